@@ -19,6 +19,7 @@
  */
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,6 +31,17 @@
 #define __pure    __attribute__((pure))
 #define __unused  __attribute__((unused))
 
+/**
+ * Find the structure that a member is embedded in.
+ * @param ptr A pointer to the member
+ * @param type The type of the containing structure
+ * @param member The name of the member within `type`
+ *
+ * @return A pointer to the `type` structure containing the member at `ptr`.
+ */
+#define container_of(ptr, type, member)				\
+	((type *) ((char *) (ptr) - offsetof(type, member)))
+
 /**
  * Pick the minimum of two comparable values.
  * @param m First comparable value
@@ -32,10 +32,38 @@
 #ifndef __DATA_STRUCTURE_H
 #define __DATA_STRUCTURE_H
 
+/**
+ * Concurrency modes a data structure may be created with.
+ *
+ * `DS_LOCKED` (the default) serializes every operation through a
+ * reader/writer lock.  `DS_SPSC` is a lock-free mode for exactly one producer
+ * thread and one consumer thread, and `DS_MPMC` is a lock-free mode for any
+ * number of producers and consumers.  `DS_BROADCAST` is a mode for one
+ * producer whose data is seen by every one of any number of readers; pushing
+ * and reading are lock-free, but finding the slowest reader takes a reader
+ * lock which attaching and detaching readers hold exclusively.  These modes
+ * are only supported by ring buffers.
+ */
+enum ds_concurrency {
+	DS_LOCKED = 0,
+	DS_SPSC,
+	DS_MPMC,
+	DS_BROADCAST,
+};
+
 struct ds_properties {
 	size_t data_size;
 	size_t entries;
 	bool   overwrite;
+	bool   power_of_two;
+	bool   mirrored;
+	bool   growable;
+	bool   huge_pages;
+	bool   prefault;
+	bool   lock_memory;
+	bool   indexed;
+
+	enum ds_concurrency concurrency;
 };
 
 #define __DS_HOF_OPS_NAME   __hof_ops
@@ -80,8 +108,22 @@ struct ds_properties {
 #define DS_DATA_SIZE(ds) (DS_PROPS(ds)->data_size)
 #define DS_ENTRIES(ds)   (DS_PROPS(ds)->entries)
 #define DS_OVERWRITE(ds) (DS_PROPS(ds)->overwrite)
+#define DS_CONCURRENCY(ds) (DS_PROPS(ds)->concurrency)
 
 #define DS_ALLOC(ds) (ds = malloc(sizeof(*ds)))
 #define DS_FREE(ds) (free_null(*ds))
 
+/* Like DS_ALLOC(), but honours alignment beyond malloc()'s, for data
+ * structures whose private section contains over-aligned members. */
+#define DS_ALLOC_ALIGNED(ds)						\
+	({								\
+		void * ds_;						\
+		ds = NULL;						\
+		if(!posix_memalign(&ds_,				\
+				   MAX(__alignof__(*ds), sizeof(void *)),	\
+				   sizeof(*ds)))			\
+			ds = ds_;					\
+		ds;							\
+	})
+
 #endif /* __DATA_STRUCTURE_H */
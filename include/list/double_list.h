@@ -20,11 +20,15 @@
 #ifndef __LINKED_LIST_H
 #define __LINKED_LIST_H
 
+#include <stdatomic.h>
+
 #include "focs.h"
 #include "focs/data_structure.h"
 #include "hof.h"
 #include "list/linked_list.h"
+#include "mem/slab.h"
 #include "sync/rwlock.h"
+#include "tree/rank_tree.h"
 
 /**
  * @struct dl_element
@@ -36,7 +40,9 @@ struct dl_element {
 	struct dl_element * next;
 	struct dl_element * prev;
 
-	void * data;
+	/* The element's data, stored inline.  Elements are allocated from
+	 * the list's slab cache with room for `DS_DATA_SIZE()` bytes here. */
+	uint8_t data[] __attribute__((__aligned__));
 };
 
 /**
@@ -51,6 +57,18 @@ struct dl_element {
 	size_t length;
 	size_t data_size;
 
+	struct slab_cache * slab;
+
+	/* Maps positions to elements when the list is created with the
+	 * `indexed` property, otherwise NULL. */
+	struct rank_tree * index;
+
+	/* The position and element of the last positional lookup, from which
+	 * nearby lookups start walking.  NULL when unknown. */
+	struct dl_element * finger;
+	size_t finger_pos;
+	atomic_flag finger_lock;
+
 	struct rwlock * rwlock;
 } END_DS(double_list);
 
@@ -137,6 +155,11 @@ struct dl_element {
  * Allocates a new doubly linked list at the structure pointer pointed to by
  * `list`.
  *
+ * If `props->indexed` is set, the list also maintains a positional index, so
+ * that dl_fetch(), dl_insert(), dl_delete() and dl_remove() find their
+ * position in O(log n) rather than O(n) time.  The index costs one rank tree
+ * node per element, and dl_filter() pays O(log n) per removed element.
+ *
  * @return Upon successful completion, dl_create() shall return a new
  * double_list.  Otherwise, `NULL` shall be returned and `errno` set to
  * indicate the error.
@@ -288,6 +311,87 @@ void dl_map(double_list list, map_fn fn);
  */
 void dl_reverse(double_list list);
 
+/**
+ * Sort a list in place.
+ * @param list The list to sort
+ * @param comp A function returning `true` if its first argument must be
+ *             ordered strictly before its second
+ *
+ * Sorts `list` with a stable merge sort in O(n log n) time.  The elements are
+ * relinked in place, so no memory is allocated and pointers returned by
+ * dl_fetch() remain valid.
+ */
+void dl_sort(double_list list, comp_fn comp);
+
+/**
+ * Merge one sorted list into another.
+ * @param dst The list to merge into
+ * @param src The list to merge from
+ * @param comp The function both lists are sorted by (see dl_sort())
+ *
+ * Moves every element of `src` into `dst` in linear time, so that `dst`
+ * remains sorted; `src` is left empty.  Elements of `dst` are ordered before
+ * equal elements of `src`.  Indexed lists also rebuild their positional index,
+ * which takes O(n log n) time.
+ *
+ * @return `true` on success.  Otherwise, `false` is returned, both lists are
+ * left unchanged, and `errno` is set to indicate the error: `EINVAL` if `dst`
+ * and `src` are the same list or store data of different sizes, or `ENOMEM`
+ * if the positional index of `dst` could not be grown.
+ */
+bool dl_merge(double_list dst, double_list src, comp_fn comp);
+
+/**
+ * Move every element of one list into another at a given position.
+ * @param dst The list to move elements into
+ * @param pos The position in `dst` to move them to
+ *            (must be an index in the range `0..dst->length`)
+ * @param src The list to move elements from
+ *
+ * Relinks the elements of `src`, in order, into `dst` so that the first of
+ * them is at index `pos`; `src` is left empty.  No data is copied, so this
+ * takes constant time at either end of `dst` and otherwise only the time to
+ * find `pos`.  Indexed lists also record each moved element in their
+ * positional index.
+ *
+ * @return `true` on success.  Otherwise, `false` is returned and `errno` is
+ * set to indicate the error: `EINVAL` if `dst` and `src` are the same list or
+ * store data of different sizes, or if `pos` is out of range.
+ */
+bool dl_splice(double_list dst, size_t pos, double_list src);
+
+/**
+ * Move every element of one list onto the tail of another.
+ * @param dst The list to append to
+ * @param src The list to move elements from
+ *
+ * Equivalent to dl_splice() at the tail of `dst`, in constant time.
+ *
+ * @return `true` on success.  Otherwise, `false` is returned and `errno` is
+ * set as for dl_splice().
+ */
+bool dl_concat(double_list dst, double_list src);
+
+/**
+ * Split a list in two at a given position.
+ * @param list The list to split
+ * @param pos  The position to split `list` at
+ *             (must be an index in the range `0..list->length`)
+ *
+ * Moves the elements of `list` from index `pos` onwards into a new list with
+ * the same properties, leaving the first `pos` elements in `list`.  The chain
+ * is cut in place, so no data is copied and pointers returned by dl_fetch()
+ * remain valid; this takes only the time to find `pos`, plus the time for an
+ * indexed list to index the moved elements.  Unless every element moves, the
+ * two lists go on sharing the memory the elements were allocated from, and
+ * their allocations are then serialized with each other.
+ *
+ * @return A new list holding the tail of `list`, which must be destroyed with
+ * dl_free().  Otherwise, `NULL` is returned and `errno` is set to indicate the
+ * error.
+ */
+double_list dl_split_at(double_list list, size_t pos);
+
 /**
  * Right associative fold for doubly linked lists.
  * @param list A list of values to reduce
@@ -0,0 +1,344 @@
+/* intrusive_list.h - Intrusive Linked List API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INTRUSIVE_LIST_H
+#define __INTRUSIVE_LIST_H
+
+#include "focs.h"
+#include "focs/data_structure.h"
+#include "list/double_list.h"
+#include "list/linked_list.h"
+#include "sync/rwlock.h"
+
+/**
+ * @struct isl_link
+ * Links an object into an intrusive singly linked list.
+ *
+ * Embed this structure in your own object; an object may sit on several lists
+ * at once by embedding one link per list.
+ */
+struct isl_link {
+	struct isl_link * next;
+};
+
+/**
+ * @struct idl_link
+ * Links an object into an intrusive doubly linked list.
+ *
+ * Embed this structure in your own object; an object may sit on several lists
+ * at once by embedding one link per list.
+ */
+struct idl_link {
+	struct idl_link * next;
+	struct idl_link * prev;
+};
+
+/**
+ * @struct isingle_list
+ * Represents an intrusive singly linked list.
+ *
+ * The list never allocates or copies data; it only threads together links
+ * owned by the caller.  Initialize this structure with isl_create(), and
+ * destroy it with isl_free().
+ */
+START_DS(isingle_list) {
+	struct isl_link * head;
+	struct isl_link * tail;
+	size_t length;
+
+	struct rwlock * rwlock;
+} END_DS(isingle_list);
+
+/**
+ * @struct idouble_list
+ * Represents an intrusive doubly linked list.
+ *
+ * The list never allocates or copies data; it only threads together links
+ * owned by the caller.  Initialize this structure with idl_create(), and
+ * destroy it with idl_free().
+ */
+START_DS(idouble_list) {
+	struct idl_link * head;
+	struct idl_link * tail;
+	size_t length;
+
+	struct rwlock * rwlock;
+} END_DS(idouble_list);
+
+/**
+ * Return the object that a list link is embedded in.
+ * @param link A pointer to a `struct isl_link` or `struct idl_link`
+ * @param type The type of the containing object
+ * @param member The name of the link member within `type`
+ *
+ * @return A pointer to the containing object, or `NULL` if `link` is `NULL`.
+ */
+#define intrusive_list_entry(link, type, member)			\
+	({								\
+		typeof(link) link_ = link;				\
+		link_ ? container_of(link_, type, member) : NULL;	\
+	})
+
+/**
+ * Advance through an intrusive list object by object.
+ * @param list The list to iterate over
+ * @param link A link pointer that will point to the current link
+ * @param entry An object pointer that will point to the current object
+ * @param member The name of the link member within the object
+ *
+ * intrusive_list_foreach() should be used like a for loop; for example:
+ * ```
+ * struct isl_link * link;
+ * struct my_object * obj;
+ * intrusive_list_foreach(list, link, obj, node) {
+ *         do_something(obj);
+ * }
+ * ```
+ * See linked_list_foreach().
+ */
+#define intrusive_list_foreach(list, link, entry, member)		\
+	linked_list_foreach(list, link)					\
+		if((entry = container_of(link, typeof(*entry), member)), true)
+
+/**
+ * Advance through an intrusive list object by object.
+ * @param list The list to iterate over
+ * @param link A link pointer that will point to the current link
+ * @param entry An object pointer that will point to the current object
+ * @param member The name of the link member within the object
+ *
+ * The syntax of intrusive_list_foreach_safe() is the same as
+ * intrusive_list_foreach().  However, it is safe to unlink the current object
+ * during the loop body.  See linked_list_foreach_safe().
+ */
+#define intrusive_list_foreach_safe(list, link, entry, member)		\
+	linked_list_foreach_safe(list, link)				\
+		if((entry = container_of(link, typeof(*entry), member)), true)
+
+/**
+ * Advance through an intrusive doubly linked list in reverse.
+ * @param list The list to iterate over
+ * @param link A link pointer that will point to the current link
+ * @param entry An object pointer that will point to the current object
+ * @param member The name of the link member within the object
+ *
+ * See intrusive_list_foreach() and double_list_foreach_rev().
+ */
+#define intrusive_list_foreach_rev(list, link, entry, member)		\
+	double_list_foreach_rev(list, link)				\
+		if((entry = container_of(link, typeof(*entry), member)), true)
+
+/* ########################## *
+ * # Creation & Destruction # *
+ * ########################## */
+
+/**
+ * Allocate and initialize a new intrusive singly linked list.
+ *
+ * @return A new, empty list, or `NULL` with `errno` set on failure.
+ */
+isingle_list isl_create(void);
+
+/**
+ * Destroy and deallocate an intrusive singly linked list.
+ * @param list A pointer to the list to destroy
+ *
+ * Only the list itself is freed; objects still linked into `list` are owned by
+ * the caller and are left untouched.
+ */
+void isl_free(isingle_list * list);
+
+/**
+ * Allocate and initialize a new intrusive doubly linked list.
+ *
+ * @return A new, empty list, or `NULL` with `errno` set on failure.
+ */
+idouble_list idl_create(void);
+
+/**
+ * Destroy and deallocate an intrusive doubly linked list.
+ * @param list A pointer to the list to destroy
+ *
+ * Only the list itself is freed; objects still linked into `list` are owned by
+ * the caller and are left untouched.
+ */
+void idl_free(idouble_list * list);
+
+/* ############################# *
+ * # Data Management Functions # *
+ * ############################# */
+
+/**
+ * Determine if an intrusive singly linked list is empty.
+ * @param list The list to check
+ *
+ * @return `true` if `list` contains no links, otherwise `false`.
+ */
+bool isl_null(isingle_list list);
+
+/**
+ * Count the links in an intrusive singly linked list.
+ * @param list The list to measure
+ *
+ * @return The number of links in `list`.
+ */
+size_t isl_length(isingle_list list);
+
+/**
+ * Link an object at the head of an intrusive singly linked list.
+ * @param list The list to push onto
+ * @param link The link embedded in the object to push
+ *
+ * Runtime: O(1)
+ */
+void isl_push_head(isingle_list list, struct isl_link * link);
+
+/**
+ * Link an object at the tail of an intrusive singly linked list.
+ * @param list The list to push onto
+ * @param link The link embedded in the object to push
+ *
+ * Runtime: O(1)
+ */
+void isl_push_tail(isingle_list list, struct isl_link * link);
+
+/**
+ * Unlink the object at the head of an intrusive singly linked list.
+ * @param list The list to pop from
+ *
+ * Runtime: O(1)
+ *
+ * @return The head link, or `NULL` if `list` is empty.  Use
+ * intrusive_list_entry() to recover the containing object.
+ */
+struct isl_link * isl_pop_head(isingle_list list);
+
+/**
+ * Link an object directly after another in an intrusive singly linked list.
+ * @param list The list to insert into
+ * @param mark A link already in `list`, or `NULL` to insert at the head
+ * @param link The link embedded in the object to insert
+ *
+ * Runtime: O(1)
+ */
+void isl_insert_after(isingle_list list,
+		      struct isl_link * mark,
+		      struct isl_link * link);
+
+/**
+ * Unlink the object directly after another in an intrusive singly linked list.
+ * @param list The list to remove from
+ * @param mark A link already in `list`, or `NULL` to remove the head
+ *
+ * Runtime: O(1)
+ *
+ * @return The unlinked link, or `NULL` if nothing follows `mark`.
+ */
+struct isl_link * isl_remove_after(isingle_list list, struct isl_link * mark);
+
+/**
+ * Determine if an intrusive doubly linked list is empty.
+ * @param list The list to check
+ *
+ * @return `true` if `list` contains no links, otherwise `false`.
+ */
+bool idl_null(idouble_list list);
+
+/**
+ * Count the links in an intrusive doubly linked list.
+ * @param list The list to measure
+ *
+ * @return The number of links in `list`.
+ */
+size_t idl_length(idouble_list list);
+
+/**
+ * Link an object at the head of an intrusive doubly linked list.
+ * @param list The list to push onto
+ * @param link The link embedded in the object to push
+ *
+ * Runtime: O(1)
+ */
+void idl_push_head(idouble_list list, struct idl_link * link);
+
+/**
+ * Link an object at the tail of an intrusive doubly linked list.
+ * @param list The list to push onto
+ * @param link The link embedded in the object to push
+ *
+ * Runtime: O(1)
+ */
+void idl_push_tail(idouble_list list, struct idl_link * link);
+
+/**
+ * Unlink the object at the head of an intrusive doubly linked list.
+ * @param list The list to pop from
+ *
+ * Runtime: O(1)
+ *
+ * @return The head link, or `NULL` if `list` is empty.
+ */
+struct idl_link * idl_pop_head(idouble_list list);
+
+/**
+ * Unlink the object at the tail of an intrusive doubly linked list.
+ * @param list The list to pop from
+ *
+ * Runtime: O(1)
+ *
+ * @return The tail link, or `NULL` if `list` is empty.
+ */
+struct idl_link * idl_pop_tail(idouble_list list);
+
+/**
+ * Link an object directly after another in an intrusive doubly linked list.
+ * @param list The list to insert into
+ * @param mark A link already in `list`, or `NULL` to insert at the head
+ * @param link The link embedded in the object to insert
+ *
+ * Runtime: O(1)
+ */
+void idl_insert_after(idouble_list list,
+		      struct idl_link * mark,
+		      struct idl_link * link);
+
+/**
+ * Link an object directly before another in an intrusive doubly linked list.
+ * @param list The list to insert into
+ * @param mark A link already in `list`, or `NULL` to insert at the tail
+ * @param link The link embedded in the object to insert
+ *
+ * Runtime: O(1)
+ */
+void idl_insert_before(idouble_list list,
+		       struct idl_link * mark,
+		       struct idl_link * link);
+
+/**
+ * Unlink an object from an intrusive doubly linked list.
+ * @param list The list to delete from
+ * @param link A link currently in `list`
+ *
+ * Runtime: O(1)
+ *
+ * The object itself is not freed; it is owned by the caller.
+ */
+void idl_delete(idouble_list list, struct idl_link * link);
+
+#endif /* __INTRUSIVE_LIST_H */
@@ -17,31 +17,288 @@
  * along with focs.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdatomic.h>
+
 #include "focs.h"
 #include "focs/data_structure.h"
+#include "hof.h"
 #include "sync/rwlock.h"
+#include "sync/waitq.h"
 
-START_DS(ring_buffer) {
-	void * head;
-	void * tail;
+/* The size of a cache line.  State written by producers, state written by
+ * consumers and read-mostly configuration are each kept on their own line to
+ * avoid false sharing between cores.  Define this to something small, such as
+ * `8`, for a compact layout.  Since it changes `struct ring_buffer_priv`, the
+ * functions which create a ring buffer are passed the value their caller was
+ * built with, and fail with `EINVAL` unless it matches the library's. */
+#ifndef RB_CACHELINE_SIZE
+#define RB_CACHELINE_SIZE 64
+#endif
+
+#define __cacheline_aligned __attribute__((__aligned__(RB_CACHELINE_SIZE)))
+
+/* The huge page size that data regions are rounded up to when huge pages are
+ * requested.  Explicit huge pages are only used if this matches the system's
+ * default huge page size. */
+#ifndef RB_HUGEPAGE_SIZE
+#define RB_HUGEPAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+/* Flags describing the memory backing the data region; see rb_backing(). */
+#define RB_BACKING_HEAP       0
+#define RB_BACKING_MIRRORED   (1 << 0)
+#define RB_BACKING_SHARED     (1 << 1)
+#define RB_BACKING_HUGETLB    (1 << 2) /* Explicit huge pages. */
+#define RB_BACKING_HUGEPAGE   (1 << 3) /* Transparent huge pages. */
+#define RB_BACKING_PREFAULTED (1 << 4)
+#define RB_BACKING_LOCKED     (1 << 5)
+
+/* Buffer state which is shared between every user of a buffer.  For a buffer
+ * created with rb_create_shared() this lives at the start of the shared memory
+ * object, so it must only ever contain plain values and offsets: each process
+ * maps the object at a different address. */
+struct ring_buffer_shared {
+	/* Read-only description of a shared memory object, set up once by
+	 * rb_create_shared().  `magic` is set last, once the rest is valid. */
+	atomic_uint_least64_t magic;
+	size_t data_size;
+	size_t capacity;
+	size_t seq_offset;  /* Offset of the `DS_MPMC` sequence numbers. */
+	size_t data_offset; /* Offset of the data region. */
+	enum ds_concurrency concurrency;
+
+	/* Lock-free state used when the buffer is created with `DS_SPSC` or
+	 * `DS_MPMC`.  Both are free running element counters: `write` is only
+	 * advanced by producers and `read` is only advanced by consumers, and
+	 * each side's state sits on its own cache line.  In `DS_SPSC` mode each
+	 * side also keeps its last view of the other side's counter, and only
+	 * reloads it when that view says the buffer is full or empty. */
+	atomic_size_t write __cacheline_aligned;
+	size_t read_cache;
+	size_t reserved; /* Slots handed out by rb_reserve_tail(). */
+
+	/* Blocks which could not be pushed because the buffer was full. */
+	atomic_size_t failed;
 
+	/* In `DS_BROADCAST` mode with `overwrite` set, advanced past the slots
+	 * the producer is about to overwrite before it touches them, so that
+	 * readers can tell if a block changed while they were copying it. */
+	atomic_size_t claim;
+
+	atomic_size_t read __cacheline_aligned;
+	size_t write_cache;
+	size_t acquired; /* Blocks handed out by rb_acquire_head(). */
+};
+
+struct rb_reader;
+
+START_DS(ring_buffer) {
+	/* Read-mostly configuration, set up by rb_create(). */
 	void * data;
-	size_t length;
+	size_t capacity; /* Number of slots in `data`. */
+	size_t mask;     /* `capacity - 1` if it is a power of two, else `0`. */
+	unsigned int backing; /* `RB_BACKING_*` flags for `data`. */
 
 	struct rwlock * rwlock;
+
+	/* Threads blocked in rb_pop_head_wait() and rb_push_tail_wait(). */
+	struct waitq * not_empty;
+	struct waitq * not_full;
+
+	/* Per-slot sequence numbers (`DS_MPMC` only).  A slot is free for the
+	 * producer claiming counter `n` when its sequence is `n`, and holds
+	 * data for the consumer claiming counter `n` when it is `n + 1`. */
+	atomic_size_t * seq;
+
+	/* Points to `local`, or into the shared memory object for a buffer
+	 * created with rb_create_shared() or rb_attach_shared(). */
+	struct ring_buffer_shared * shared;
+
+	/* Readers attached to a `DS_BROADCAST` buffer, protected by `rwlock`. */
+	struct rb_reader * readers;
+
+	/* Free running element counters for the locked buffer; the number of
+	 * stored blocks is always `tail - head`. */
+	size_t head __cacheline_aligned;
+	size_t tail;
+
+	/* Sequence counter for lock-free readers of the locked buffer; it is
+	 * odd while a writer is modifying `head`, `tail` or the data. */
+	atomic_size_t version;
+
+	/* Telemetry for the locked buffer, only updated under the writer lock;
+	 * the lock-free modes derive theirs from `write` and `read`. */
+	atomic_size_t pushes;
+	atomic_size_t pops;
+	atomic_size_t overwrites;
+
+	/* Bumped by every writer that modifies blocks anywhere but past the
+	 * tail, so rb_snapshot() can tell when a plain push did not suffice. */
+	atomic_size_t edits;
+
+	struct ring_buffer_shared local;
 } END_DS(ring_buffer);
 
+/* Counters reported by rb_stats(). */
+struct rb_stats {
+	size_t pushes;     /* Blocks pushed, including any that overwrote. */
+	size_t pops;       /* Blocks popped. */
+	size_t overwrites; /* Blocks dropped to make room in `overwrite` mode. */
+	size_t failed;     /* Blocks not pushed because the buffer was full. */
+};
+
+/* A reader of a `DS_BROADCAST` ring buffer; see rb_reader_attach(). */
+struct rb_reader {
+	/* Counter of the next block to read.  Only the reader advances it, and
+	 * the producer only reads it, so it gets a cache line of its own. */
+	atomic_size_t cursor __cacheline_aligned;
+	size_t lost; /* Blocks overwritten before they could be read. */
+
+	ring_buffer buf;
+	struct rb_reader * next;
+};
+
+typedef struct rb_reader * rb_reader;
+
 /**
  * Create a new doubly ring buffer with the given properties.
  * @param props A pointer to a data structure properties structure (non-NULL)
  *
  * Allocates and initializes a new ring buffer with the given properties.
  *
+ * The buffer holds `props->entries` data blocks.  If `props->power_of_two` is
+ * set, the capacity is rounded up to the next power of two.  Buffers with a
+ * power of two capacity map positions to slots with a bit mask instead of a
+ * division, so sizing a buffer this way makes every access cheaper.
+ *
+ * If `props->mirrored` is set, the data region is mapped twice into adjacent
+ * virtual memory, so a run of blocks that wraps around the end of the buffer
+ * is still contiguous in memory (see rb_peek_span()).  The capacity is rounded
+ * up to fill a whole number of pages.  If the mapping cannot be set up, the
+ * buffer silently falls back to an ordinary heap allocation; rb_backing()
+ * reports which one was used.
+ *
+ * For large buffers, `props->huge_pages` backs the data region with explicit
+ * huge pages (`MAP_HUGETLB`) if the system has any reserved, or else with a
+ * mapping advised to use transparent huge pages (`MADV_HUGEPAGE`), rounded up
+ * to `RB_HUGEPAGE_SIZE`.  `props->prefault` touches every page of the data
+ * region up front, and `props->lock_memory` locks it into RAM with mlock(), so
+ * that the first lap around the buffer does not take page faults.  Each of
+ * these falls back silently if the system does not permit it, and all of them
+ * are ignored for growable buffers; `props->huge_pages` is also ignored for
+ * mirrored buffers.  rb_backing() reports what was obtained.
+ *
+ * If `props->concurrency` is `DS_SPSC`, the buffer is lock-free and may be
+ * shared by exactly one producer thread and one consumer thread.  The producer
+ * may only push onto the tail and the consumer may only pop from the head, fetch
+ * and peek; rb_size(), rb_empty() and rb_full() may be called from either
+ * side.  Operations that would modify the opposite end of the buffer
+ * (pushing onto the head, popping from the tail and rb_insert()) fail with
+ * `ENOTSUP`.
+ *
+ * If `props->concurrency` is `DS_MPMC`, the buffer is a lock-free bounded
+ * queue which any number of threads may push to with rb_push_tail() and pop
+ * from with rb_pop_head() or rb_pop_head_into(), or the blocking variants of
+ * those.  rb_size(), rb_empty() and rb_full() return a snapshot which may be
+ * stale by the time it is returned.  All other operations, including
+ * rb_fetch(), fail with `ENOTSUP`.
+ *
+ * If `props->growable` is set, a push onto a full buffer reallocates the data
+ * region with (at least) twice the capacity instead of failing with `ENOBUFS`;
+ * rb_shrink_to_fit() gives the memory back after a burst.  Growth is only
+ * available to locked buffers without `props->overwrite` or
+ * `props->mirrored` (`EINVAL`).  rb_full() reports whether the current
+ * allocation is full.
+ *
+ * If `props->concurrency` is `DS_BROADCAST`, one producer thread pushes onto
+ * the tail with rb_push_tail(), rb_push_tail_n() or rb_push_tail_wait(), and
+ * every reader attached with rb_reader_attach() sees each block, each at its
+ * own pace.  Blocks are written once, however many readers there are.  A push
+ * fails with `ENOBUFS` while the slowest reader is a full capacity behind,
+ * unless `props->overwrite` is set, in which case the oldest blocks are
+ * overwritten and each reader which had not read them yet counts them as lost
+ * (see rb_reader_lost()).  Blocks pushed while no reader is attached are
+ * discarded.  rb_size(), rb_empty() and rb_full() describe the slowest reader.
+ * All other operations fail with `ENOTSUP`.
+ *
+ * A broadcast buffer is not entirely lock-free.  The list of readers is
+ * protected by the buffer's reader/writer lock, which rb_reader_attach() and
+ * rb_reader_detach() take as writers.  Reading never takes it, and neither
+ * does a push while the producer's cached view of the slowest reader leaves
+ * enough room.  When it does not, the push takes the lock as a reader to
+ * find the slowest reader again, as do rb_size(), rb_empty() and rb_full(),
+ * so these may wait for a reader being attached or detached.
+ *
+ * Overwriting is not possible without a lock, so neither `DS_SPSC` nor
+ * `DS_MPMC` may be combined with `props->overwrite` (`EINVAL`).
+ *
  * @return Upon successful completion, rb_create() shall return the newly
  * created ring buffer.  Otherwise, `NULL` shall be returned and `errno` set to
  * indicate the error.
  */
-ring_buffer __nonulls rb_create(const struct ds_properties * props);
+#define rb_create(props) __rb_create((props), RB_CACHELINE_SIZE)
+ring_buffer __nonulls __rb_create(const struct ds_properties * props,
+				  size_t line_size);
+
+/**
+ * Create a new ring buffer in a named shared memory object.
+ * @param name  The name of the shared memory object, as for shm_open()
+ *              (non-NULL)
+ * @param props A pointer to a data structure properties structure (non-NULL)
+ *
+ * Creates the shared memory object `name` and sets up a ring buffer inside it,
+ * which other processes can then open with rb_attach_shared().  Blocks pushed
+ * by one process are popped by another straight out of the shared mapping.
+ *
+ * The object holds only the buffer's counters and data, never pointers, so
+ * every process may map it at a different address.  Since locks and reader
+ * cursors are private to a process, `props->concurrency` must be `DS_SPSC` or
+ * `DS_MPMC` (`EINVAL` otherwise), and the blocking rb_*_wait() functions are
+ * not supported (`ENOTSUP`).  `props->mirrored` is ignored.
+ *
+ * The object stays in place after rb_destroy(); remove it with
+ * rb_unlink_shared() once every process is done with it.
+ *
+ * @return Upon successful completion, rb_create_shared() shall return the
+ * newly created ring buffer.  Otherwise, `NULL` shall be returned and `errno`
+ * set to indicate the error (`EEXIST` if `name` already exists).
+ */
+#define rb_create_shared(name, props) \
+	__rb_create_shared((name), (props), RB_CACHELINE_SIZE)
+ring_buffer __nonulls __rb_create_shared(const char * name,
+					 const struct ds_properties * props,
+					 size_t line_size);
+
+/**
+ * Open a ring buffer created by another process with rb_create_shared().
+ * @param name  The name the buffer was created with (non-NULL)
+ * @param props A pointer to a data structure properties structure (non-NULL)
+ *
+ * `props` must have the same data size and concurrency mode as the properties
+ * the buffer was created with, and no more entries than it holds.
+ *
+ * @return Upon successful completion, rb_attach_shared() shall return the
+ * ring buffer.  Otherwise, `NULL` shall be returned and `errno` set to
+ * indicate the error (`EINVAL` if `props` does not match the buffer, or
+ * `EAGAIN` if its creator has not finished setting it up yet).
+ */
+#define rb_attach_shared(name, props) \
+	__rb_attach_shared((name), (props), RB_CACHELINE_SIZE)
+ring_buffer __nonulls __rb_attach_shared(const char * name,
+					 const struct ds_properties * props,
+					 size_t line_size);
+
+/**
+ * Remove the name of a shared ring buffer.
+ * @param name The name the buffer was created with (non-NULL)
+ *
+ * Processes which already have the buffer open may keep using it; its memory
+ * is released once the last of them destroys it.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately.
+ */
+bool __nonulls rb_unlink_shared(const char * name);
 
 /**
  * Destroy and deallocate a ring buffer.
@@ -58,9 +315,186 @@ void __nonulls rb_destroy(ring_buffer * buf);
  * @return This function shall return the number of data blocks stored in the
  * ring buffer `buf`.  This is distinct from the capacity of the ring buffer,
  * which is the number of entries it may contain when full.
+ *
+ * Like rb_empty() and rb_full(), this does not take the buffer's lock; it
+ * retries instead if a writer was modifying the buffer at the same time.  The
+ * exception is a `DS_BROADCAST` buffer, where it takes the lock as a reader to
+ * find the slowest reader.
  */
 size_t __nonulls rb_size(const ring_buffer buf);
 
+/**
+ * Attach a new reader to a broadcast ring buffer.
+ * @param buf The `DS_BROADCAST` ring buffer to read from (non-NULL)
+ *
+ * The reader starts at the tail of `buf`, so it sees every block pushed from
+ * now on.  Readers may be attached and detached while the producer is
+ * running, but every reader has to be detached before `buf` is destroyed.
+ * Attaching and detaching take the buffer's lock as a writer, so the
+ * producer may have to wait for them when it looks for the slowest reader.
+ *
+ * @return Upon successful completion, rb_reader_attach() shall return the new
+ * reader.  Otherwise, `NULL` shall be returned and `errno` set appropriately
+ * (`ENOTSUP` if `buf` is not a broadcast buffer).
+ */
+rb_reader __nonulls rb_reader_attach(ring_buffer buf);
+
+/**
+ * Detach and deallocate a reader of a broadcast ring buffer.
+ * @param reader A pointer to the reader to detach (non-NULL)
+ *
+ * Any blocks the reader has not read yet no longer hold up the producer.
+ */
+void __nonulls rb_reader_detach(rb_reader * reader);
+
+/**
+ * Read the next block for a reader of a broadcast ring buffer.
+ * @param reader The reader to advance (non-NULL)
+ * @param data   A pointer to memory to copy the block into (non-NULL)
+ *
+ * Each reader may only be used by one thread at a time.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately
+ * (`EFAULT` if the reader has seen every block pushed so far).
+ */
+bool __nonulls rb_reader_pop_into(rb_reader reader, void * data);
+
+/**
+ * Read several blocks for a reader of a broadcast ring buffer.
+ * @param reader The reader to advance (non-NULL)
+ * @param data   A pointer to memory for up to `n` blocks (non-NULL)
+ * @param n      The number of blocks to read
+ *
+ * @return The number of blocks read, which may be less than `n`.  If no block
+ * could be read, `errno` is set to `EFAULT`.
+ */
+size_t __nonulls rb_reader_pop_n(rb_reader reader, void * data, const size_t n);
+
+/**
+ * Determine the number of blocks a broadcast reader has not read yet.
+ * @param reader The reader to check (non-NULL)
+ *
+ * @return The number of blocks which may still be read by `reader`.
+ */
+size_t __nonulls rb_reader_size(const rb_reader reader);
+
+/**
+ * Determine the number of blocks a broadcast reader has missed.
+ * @param reader The reader to check (non-NULL)
+ *
+ * @return The number of blocks which the producer overwrote before `reader`
+ * could read them.  Always `0` unless the buffer was created with
+ * `props->overwrite`.
+ */
+size_t __nonulls rb_reader_lost(const rb_reader reader);
+
+/**
+ * Read data from a file descriptor straight into a ring buffer.
+ * @param buf The ring buffer to push onto (non-NULL)
+ * @param fd  The file descriptor to read from
+ * @param max The largest number of bytes to read
+ *
+ * Reads up to `max` bytes from `fd` into the free space at the tail of `buf`
+ * with a single readv() call, covering both sides of the wrap if necessary,
+ * and pushes whatever was read.  Only buffers of single byte blocks are
+ * supported (`EINVAL`).
+ *
+ * A locked buffer holds its writer lock during the call, so other pushes and
+ * pops wait for it; use a non-blocking `fd`, or a `DS_SPSC` buffer where only
+ * the producer may read into it.  `DS_MPMC` and `DS_BROADCAST` buffers are not
+ * supported (`ENOTSUP`).
+ *
+ * @return The number of bytes read, `0` at end of file, or `-1` on failure
+ * with `errno` set appropriately (`ENOBUFS` if `buf` is full, or as set by
+ * readv()).
+ */
+ssize_t __nonulls rb_read_fd(ring_buffer buf, const int fd, const size_t max);
+
+/**
+ * Write data from a ring buffer straight to a file descriptor.
+ * @param buf The ring buffer to pop from (non-NULL)
+ * @param fd  The file descriptor to write to
+ * @param max The largest number of bytes to write
+ *
+ * The counterpart of rb_read_fd(): writes up to `max` bytes from the head of
+ * `buf` to `fd` with a single writev() call and pops whatever was written.
+ * For `DS_SPSC` buffers only the consumer may write out of it.
+ *
+ * @return The number of bytes written, or `-1` on failure with `errno` set
+ * appropriately (`EFAULT` if `buf` is empty, or as set by writev()).
+ */
+ssize_t __nonulls rb_write_fd(ring_buffer buf, const int fd, const size_t max);
+
+/**
+ * Release the memory a growable ring buffer no longer needs.
+ * @param buf The ring buffer to shrink (non-NULL)
+ *
+ * Reallocates the data region of `buf` to the smallest capacity which holds
+ * its current contents, but never less than the number of entries it was
+ * created with.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately
+ * (`ENOTSUP` if `buf` is not growable).
+ */
+bool __nonulls rb_shrink_to_fit(ring_buffer buf);
+
+/**
+ * Determine the number of data blocks a ring buffer can hold.
+ * @param buf The ring buffer to check (non-NULL)
+ *
+ * @return The current capacity of `buf`, which may be larger than the number
+ * of entries it was created with (see rb_create()).
+ */
+size_t __nonulls rb_capacity(const ring_buffer buf);
+
+/**
+ * Read the telemetry counters of a ring buffer.
+ * @param buf   The ring buffer to check (non-NULL)
+ * @param stats Where to store the counters (non-NULL)
+ *
+ * The counters are kept up to date by the operations themselves, without any
+ * extra locking or atomic read-modify-write on the paths that succeed, and may
+ * be read at any time.  Blocks removed by rb_filter() are not counted as pops.
+ * For `DS_BROADCAST` buffers `pops` and `overwrites` are always `0`: each
+ * reader counts its own losses (see rb_reader_lost()).
+ */
+void __nonulls rb_stats(const ring_buffer buf, struct rb_stats * stats);
+
+/**
+ * Copy the contents of a ring buffer without stopping its producers.
+ * @param buf The ring buffer to copy (non-NULL)
+ * @param dst A pointer to memory for up to rb_capacity() blocks (non-NULL)
+ *
+ * Copies the blocks stored in `buf` to `dst`, oldest first, usually with just
+ * one or two memcpy() calls, and without taking the buffer's lock: producers
+ * keep pushing meanwhile.  If they overwrite some of the oldest blocks during
+ * the copy, those are left out, so every block returned was in the buffer at
+ * some point during the call and the newest ones are always included.  If any
+ * other modification interferes, the copy is taken again.
+ *
+ * Growable buffers are copied under the reader lock, since growing frees the
+ * old data region.  `DS_MPMC` and `DS_BROADCAST` buffers are not supported
+ * (`ENOTSUP`).
+ *
+ * @return The number of blocks copied to `dst`, which is `0` if `buf` is
+ * empty.  On failure, `0` is returned and `errno` is set appropriately.
+ */
+size_t __nonulls rb_snapshot(const ring_buffer buf, void * dst);
+
+/**
+ * Determine the kind of memory backing a ring buffer.
+ * @param buf The ring buffer to check (non-NULL)
+ *
+ * @return A bitwise OR of `RB_BACKING_*` flags, or `RB_BACKING_HEAP` if the
+ * data region is an ordinary heap allocation.  `RB_BACKING_HUGETLB` or
+ * `RB_BACKING_HUGEPAGE` is set if huge pages were obtained,
+ * `RB_BACKING_PREFAULTED` if every page was faulted in at creation, and
+ * `RB_BACKING_LOCKED` if the data region is locked into RAM.
+ */
+unsigned int __nonulls rb_backing(const ring_buffer buf);
+
 /**
  * Determine if a ring buffer is empty.
  * @param buf The ring buffer to check (non-NULL)
@@ -99,6 +533,24 @@ bool __nonulls rb_push_head(ring_buffer buf,
 bool __nonulls rb_push_tail(ring_buffer buf,
 	                    const void * data);
 
+/**
+ * Push a new data block onto the tail of a ring buffer, waiting for space.
+ * @param buf     The ring buffer to push onto (non-NULL)
+ * @param data    A pointer to the data to push (non-NULL)
+ * @param timeout The longest time to wait, or `NULL` to wait indefinitely
+ *
+ * Behaves like rb_push_tail(), but if `buf` is full the calling thread sleeps
+ * until a block is removed or `timeout` elapses.  Threads are only woken when
+ * one is actually waiting, so pops on a buffer nobody waits on stay cheap.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately
+ * (`ETIMEDOUT` if the timeout elapsed first).
+ */
+bool __attribute__((nonnull(1, 2))) rb_push_tail_wait(ring_buffer buf,
+			const void * data,
+			const struct timespec * timeout);
+
 /**
  * Pop a data element from the head of a ring buffer.
  * @param buf The ring buffer to pop from (non-NULL)
@@ -116,6 +568,52 @@ bool __nonulls rb_push_tail(ring_buffer buf,
  */
 void * __nonulls rb_pop_head(ring_buffer buf);
 
+/**
+ * Pop a data element from the head of a ring buffer into a caller buffer.
+ * @param buf  The ring buffer to pop from (non-NULL)
+ * @param data A buffer of at least `DS_DATA_SIZE(buf)` bytes (non-NULL)
+ *
+ * Behaves like rb_pop_head(), but copies the data block into `data` instead of
+ * allocating a new block for it.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately.
+ */
+bool __nonulls rb_pop_head_into(ring_buffer buf, void * data);
+
+/**
+ * Pop a data element from the head of a ring buffer, waiting for one to arrive.
+ * @param buf     The ring buffer to pop from (non-NULL)
+ * @param timeout The longest time to wait, or `NULL` to wait indefinitely
+ *
+ * Behaves like rb_pop_head(), but if `buf` is empty the calling thread sleeps
+ * until a block is pushed or `timeout` elapses, instead of failing at once.
+ * Threads are only woken when one is actually waiting, so pushes onto a buffer
+ * nobody waits on stay cheap.
+ *
+ * @return A pointer to the popped data, which must be freed by the caller, or
+ * `NULL` on failure with `errno` set appropriately (`ETIMEDOUT` if the timeout
+ * elapsed first).
+ */
+void * __attribute__((nonnull(1))) rb_pop_head_wait(ring_buffer buf,
+			const struct timespec * timeout);
+
+/**
+ * Pop a data element from the head of a ring buffer into a caller buffer,
+ * waiting for one to arrive.
+ * @param buf     The ring buffer to pop from (non-NULL)
+ * @param timeout The longest time to wait, or `NULL` to wait indefinitely
+ * @param data    A buffer of at least `DS_DATA_SIZE(buf)` bytes (non-NULL)
+ *
+ * Behaves like rb_pop_head_wait(), but copies the data block into `data`.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately.
+ */
+bool __attribute__((nonnull(1, 3))) rb_pop_head_wait_into(ring_buffer buf,
+			const struct timespec * timeout,
+			void * data);
+
 /**
  * Pop a data element from the tail of a ring buffer.
  * @param buf The ring buffer to pop from (non-NULL)
@@ -133,6 +631,85 @@ void * __nonulls rb_pop_head(ring_buffer buf);
  */
 void * __nonulls rb_pop_tail(ring_buffer buf);
 
+/**
+ * Pop a data element from the tail of a ring buffer into a caller buffer.
+ * @param buf  The ring buffer to pop from (non-NULL)
+ * @param data A buffer of at least `DS_DATA_SIZE(buf)` bytes (non-NULL)
+ *
+ * Behaves like rb_pop_tail(), but copies the data block into `data` instead of
+ * allocating a new block for it.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately.
+ */
+bool __nonulls rb_pop_tail_into(ring_buffer buf, void * data);
+
+/**
+ * Push a block of data elements onto the head of a ring buffer.
+ * @param buf  The ring buffer to push onto (non-NULL)
+ * @param data An array of `n` data blocks to push (non-NULL)
+ * @param n    The number of data blocks in `data`
+ *
+ * Prepend as many blocks of `data` to `buf` as will fit, under a single lock
+ * acquisition.  The blocks keep their order, so `data[0]` becomes the new head
+ * of `buf`; this is equivalent to calling rb_push_head() on `data[n - 1]`
+ * first and `data[0]` last.  If `buf` overwrites, the blocks pushed out of
+ * `buf` are counted as pushed.
+ *
+ * @return The number of data blocks pushed.  If no blocks could be pushed
+ * (and `n` is not `0`), `0` shall be returned and `errno` set appropriately.
+ */
+size_t __nonulls rb_push_head_n(ring_buffer buf,
+				const void * data,
+				const size_t n);
+
+/**
+ * Push a block of data elements onto the tail of a ring buffer.
+ * @param buf  The ring buffer to push onto (non-NULL)
+ * @param data An array of `n` data blocks to push (non-NULL)
+ * @param n    The number of data blocks in `data`
+ *
+ * Append as many blocks of `data` to `buf` as will fit, under a single lock
+ * acquisition; this is equivalent to calling rb_push_tail() on `data[0]`
+ * first and `data[n - 1]` last.  If `buf` overwrites, the blocks pushed out of
+ * `buf` are counted as pushed.
+ *
+ * @return The number of data blocks pushed.  If no blocks could be pushed
+ * (and `n` is not `0`), `0` shall be returned and `errno` set appropriately.
+ */
+size_t __nonulls rb_push_tail_n(ring_buffer buf,
+				const void * data,
+				const size_t n);
+
+/**
+ * Pop a block of data elements from the head of a ring buffer.
+ * @param buf  The ring buffer to pop from (non-NULL)
+ * @param data A buffer with room for `n` data blocks (non-NULL)
+ * @param n    The maximum number of data blocks to pop
+ *
+ * Remove up to `n` blocks from the head of `buf` under a single lock
+ * acquisition, copying them into `data` in order starting with the head.
+ *
+ * @return The number of data blocks popped.  If `buf` is empty (and `n` is
+ * not `0`), `0` shall be returned and `errno` set appropriately.
+ */
+size_t __nonulls rb_pop_head_n(ring_buffer buf, void * data, const size_t n);
+
+/**
+ * Pop a block of data elements from the tail of a ring buffer.
+ * @param buf  The ring buffer to pop from (non-NULL)
+ * @param data A buffer with room for `n` data blocks (non-NULL)
+ * @param n    The maximum number of data blocks to pop
+ *
+ * Remove up to `n` blocks from the tail of `buf` under a single lock
+ * acquisition.  The blocks are copied into `data` in the order they were
+ * stored in `buf`, so the last block copied is the old tail.
+ *
+ * @return The number of data blocks popped.  If `buf` is empty (and `n` is
+ * not `0`), `0` shall be returned and `errno` set appropriately.
+ */
+size_t __nonulls rb_pop_tail_n(ring_buffer buf, void * data, const size_t n);
+
 /**
  * Insert a data block into a ring buffer at a certain position.
  * @param buf  The ring buffer to insert into (non-NULL)
@@ -150,22 +727,241 @@ bool __nonulls rb_insert(ring_buffer buf,
 	                 const void * data,
 	                 const ssize_t pos);
 
+/**
+ * Reserve free slots at the tail of a ring buffer to be written in place.
+ * @param buf The ring buffer to reserve space in (non-NULL)
+ * @param n   On entry, the number of slots wanted; on return, the number of
+ *            slots actually reserved (non-NULL)
+ *
+ * Returns a pointer to a run of up to `*n` free, contiguous slots at the tail
+ * of `buf`.  The run stops early at the end of the data region unless the
+ * buffer is mirrored.  The caller fills the slots directly and then publishes
+ * them with rb_commit_tail(); every successful call must be paired with exactly
+ * one call to rb_commit_tail().
+ *
+ * For a locked buffer this holds the writer lock in between, so the calling
+ * thread must not otherwise access `buf` before committing.  For a `DS_SPSC`
+ * buffer only the producer may reserve.  `DS_MPMC` buffers do not support
+ * reservations (`ENOTSUP`).
+ *
+ * @return A pointer into `buf`, or `NULL` on failure with `errno` set
+ * appropriately (`ENOBUFS` if `buf` is full, in which case rb_commit_tail()
+ * must not be called).
+ */
+void * __nonulls rb_reserve_tail(ring_buffer buf, size_t * n);
+
+/**
+ * Publish slots reserved with rb_reserve_tail().
+ * @param buf The ring buffer the slots were reserved in (non-NULL)
+ * @param n   The number of reserved slots to publish, which may be fewer than
+ *            were reserved (the remaining reservation is dropped)
+ *
+ * @return Upon successful completion, this function shall return `true`.
+ * Otherwise, `false` shall be returned and `errno` set appropriately
+ * (`EINVAL` if `n` exceeds the reservation, in which case nothing is
+ * published).  Either way, the reservation ends.
+ */
+bool __nonulls rb_commit_tail(ring_buffer buf, const size_t n);
+
+/**
+ * Acquire stored blocks at the head of a ring buffer to be read in place.
+ * @param buf The ring buffer to read from (non-NULL)
+ * @param n   On entry, the number of blocks wanted; on return, the number of
+ *            blocks actually acquired (non-NULL)
+ *
+ * The consumer counterpart of rb_reserve_tail(): returns a pointer to a run of
+ * up to `*n` contiguous blocks at the head of `buf`, which stay valid until
+ * they are consumed with rb_release_head().  The same pairing and concurrency
+ * rules apply, with the consumer taking the producer's place for `DS_SPSC`
+ * buffers.
+ *
+ * @return A pointer into `buf`, or `NULL` on failure with `errno` set
+ * appropriately (`EFAULT` if `buf` is empty, in which case rb_release_head()
+ * must not be called).
+ */
+void * __nonulls rb_acquire_head(ring_buffer buf, size_t * n);
+
+/**
+ * Consume blocks acquired with rb_acquire_head().
+ * @param buf The ring buffer the blocks were acquired from (non-NULL)
+ * @param n   The number of acquired blocks to remove from the head of `buf`,
+ *            which may be fewer than were acquired
+ *
+ * @return Upon successful completion, this function shall return `true`.
+ * Otherwise, `false` shall be returned and `errno` set appropriately
+ * (`EINVAL` if `n` exceeds the acquired count, in which case nothing is
+ * removed).  Either way, the acquisition ends.
+ */
+bool __nonulls rb_release_head(ring_buffer buf, const size_t n);
+
 /**
  * Fetch a data block from a given index of a ring buffer.
  * @param buf The ring buffer to fetch from
  * @param pos The index to fetch the block from
  *             (must be an index in the range `0..length - 1`)
  *
- * Fetch the data stored at index `pos` in `buf`.
+ * Fetch a copy of the data stored at index `pos` in `buf`.
+ *
+ * On a locked buffer the block is read optimistically without taking the lock
+ * and read again if a writer modified the buffer in the meantime, so fetching
+ * never holds up writers.
  *
- * @return A pointer to the data at index `pos`, or `NULL` on failure.
- * This pointer should **not** be free()d explicitly, or the `buf` will become
- * corrupted.  This pointer will be free()d when dl_free() is called, so if
- * the data is needed after `buf` is destroyed, make a copy of it, or make
- * sure to call rb_remove() on the data's index before destroying `buf`.
+ * @return A pointer to a newly allocated copy of the data at index `pos`, or
+ * `NULL` on failure.  This pointer must be explicitly freed with free() when it
+ * is no longer needed.
  */
 void * __nonulls rb_fetch(const ring_buffer buf, const ssize_t pos);
 
+/**
+ * Fetch a data block from a given index of a ring buffer into a caller buffer.
+ * @param buf  The ring buffer to fetch from (non-NULL)
+ * @param pos  The index to fetch the block from
+ *             (must be an index in the range `0..length - 1`)
+ * @param data A buffer of at least `DS_DATA_SIZE(buf)` bytes (non-NULL)
+ *
+ * Behaves like rb_fetch(), but copies the data block into `data` instead of
+ * allocating a new block for it.
+ *
+ * @return Upon successful completion, this function shall return `true`;
+ * otherwise, `false` shall be returned and `errno` set appropriately.
+ */
+bool __nonulls rb_fetch_into(const ring_buffer buf,
+			     const ssize_t pos,
+			     void * data);
+
+/**
+ * Access a data block in place without copying it out of a ring buffer.
+ * @param buf The ring buffer to peek into (non-NULL)
+ * @param pos The index of the block to access
+ *            (must be an index in the range `0..length - 1`)
+ *
+ * Return a pointer to the data block stored at index `pos` inside `buf`.  The
+ * block stays valid and unmodified until rb_peek_release() is called; every
+ * successful call to rb_peek() must be paired with exactly one call to
+ * rb_peek_release().
+ *
+ * For a locked buffer this holds the reader lock in between, so the calling
+ * thread must not modify `buf` before releasing it.  For a `DS_SPSC` buffer
+ * only the consumer may peek, and the block stays valid until the consumer
+ * pops it.  `DS_MPMC` buffers do not support peeking (`ENOTSUP`).
+ *
+ * @return A pointer into `buf`, or `NULL` on failure with `errno` set
+ * appropriately (in which case rb_peek_release() must not be called).
+ */
+void * __nonulls rb_peek(const ring_buffer buf, const ssize_t pos);
+
+/**
+ * Access a run of data blocks in place without copying it out of a ring buffer.
+ * @param buf The ring buffer to peek into (non-NULL)
+ * @param pos The index of the first block to access
+ *            (must be an index in the range `0..length - 1`)
+ * @param n   Set to the number of blocks available at the returned address
+ *            (non-NULL)
+ *
+ * Like rb_peek(), but also reports how many of the blocks from index `pos` to
+ * the end of the buffer lie contiguously in memory.  For a mirrored buffer this
+ * is always all of them; otherwise the run stops at the end of the data region.
+ * The same pairing with rb_peek_release() applies.
+ *
+ * @return A pointer into `buf`, or `NULL` on failure with `errno` set
+ * appropriately (in which case rb_peek_release() must not be called).
+ */
+void * __nonulls rb_peek_span(const ring_buffer buf,
+			      const ssize_t pos,
+			      size_t * n);
+
+/**
+ * Release a data block accessed with rb_peek().
+ * @param buf The ring buffer that was peeked into (non-NULL)
+ *
+ * After this call, the pointer returned by rb_peek() may no longer be used.
+ */
+void __nonulls rb_peek_release(const ring_buffer buf);
+
+/**
+ * Transform each data block in a ring buffer in place.
+ * @param buf The ring buffer to transform (non-NULL)
+ * @param fn  A function that will transform each value in the buffer
+ *
+ * Replaces each block, from head to tail, with the result of `fn`.  If `fn`
+ * returns a newly allocated block rather than the one it was passed, its
+ * value is copied into the buffer and the allocation freed.
+ *
+ * Like the other higher order functions, rb_map() walks the one or two runs of
+ * blocks which are contiguous in memory under a single lock acquisition, and
+ * is only supported by `DS_LOCKED` buffers (`ENOTSUP`).
+ */
+void __nonulls rb_map(ring_buffer buf, map_fn fn);
+
+/**
+ * Right associative fold over a ring buffer.
+ * @param buf  A ring buffer of values to reduce (non-NULL)
+ * @param fn   A binary function that will sequentially reduce values
+ * @param init An initial value for the fold, one block in size
+ *
+ * Reduces the blocks of `buf` from the tail towards the head:
+ * ```
+ * fn(buf[0], fn(buf[1], ... fn(buf[n - 1], init)))
+ * ```
+ *
+ * @return A newly allocated block holding the result, which is a copy of
+ * `init` if `buf` is empty, or `NULL` on failure with `errno` set
+ * appropriately.
+ */
+void * __nonulls rb_foldr(const ring_buffer buf,
+			  foldr_fn fn,
+			  const void * init);
+
+/**
+ * Left associative fold over a ring buffer.
+ * @param buf  A ring buffer of values to reduce (non-NULL)
+ * @param fn   A binary function that will sequentially reduce values
+ * @param init An initial value for the fold, one block in size
+ *
+ * Reduces the blocks of `buf` from the head towards the tail:
+ * ```
+ * fn(fn(fn(init, buf[0]), buf[1]), ...)
+ * ```
+ *
+ * @return A newly allocated block holding the result, which is a copy of
+ * `init` if `buf` is empty, or `NULL` on failure with `errno` set
+ * appropriately.
+ */
+void * __nonulls rb_foldl(const ring_buffer buf,
+			  foldl_fn fn,
+			  const void * init);
+
+/**
+ * Determine if any block in a ring buffer satisfies some condition.
+ * @param buf The ring buffer to search (non-NULL)
+ * @param p   The predicate function
+ *
+ * @return `true` if at least one block satisfies `p`, or `false` otherwise.
+ */
+bool __nonulls rb_any(const ring_buffer buf, pred_fn p);
+
+/**
+ * Determine if every block in a ring buffer satisfies some condition.
+ * @param buf The ring buffer to search (non-NULL)
+ * @param p   The predicate function
+ *
+ * @return `false` if at least one block does not satisfy `p`, or `true`
+ * otherwise, including when `buf` is empty.
+ */
+bool __nonulls rb_all(const ring_buffer buf, pred_fn p);
+
+/**
+ * Filter a ring buffer to contain only blocks that satisfy some predicate.
+ * @param buf The ring buffer to filter (non-NULL)
+ * @param p   The predicate
+ *
+ * Removes every block that does not satisfy `p` from `buf`, keeping the
+ * remaining blocks in order.
+ *
+ * @return `true` if any block was removed, or `false` otherwise.
+ */
+bool __nonulls rb_filter(ring_buffer buf, pred_fn p);
+
 #ifdef DEBUG
 #include <stdio.h>
 
@@ -189,6 +985,12 @@ static const struct mgmt_operations mgmt_ops = {
 };
 
 static const struct hof_operations hof_ops = {
+	.map    = (map_hof_fn)    rb_map,
+	.foldr  = (foldr_hof_fn)  rb_foldr,
+	.foldl  = (foldl_hof_fn)  rb_foldl,
+	.any    = (any_hof_fn)    rb_any,
+	.all    = (all_hof_fn)    rb_all,
+	.filter = (filter_hof_fn) rb_filter,
 };
 
 #else /* GENERICS */
@@ -24,6 +24,7 @@
 #include "focs/data_structure.h"
 #include "hof.h"
 #include "linked_list.h"
+#include "mem/slab.h"
 #include "sync/rwlock.h"
 
 /**
@@ -34,7 +35,10 @@
  */
 struct sl_element {
 	struct sl_element * next;
-	void * data;
+
+	/* The element's data, stored inline.  Elements are allocated from
+	 * the list's slab cache with room for `DS_DATA_SIZE()` bytes here. */
+	uint8_t data[] __attribute__((__aligned__));
 };
 
 /**
@@ -48,6 +52,7 @@ START_DS(single_list) {
 	struct sl_element * tail;
 	size_t length;
 
+	struct slab_cache * slab;
 	struct rwlock * rwlock;
 } END_DS(single_list);
 
@@ -213,6 +218,83 @@ void sl_map(single_list list, map_fn fn);
  */
 void sl_reverse(single_list list);
 
+/**
+ * Sort a list in place.
+ * @param list The list to sort
+ * @param comp A function returning `true` if its first argument must be
+ *             ordered strictly before its second
+ *
+ * Sorts `list` with a stable merge sort in O(n log n) time.  The elements are
+ * relinked in place, so no memory is allocated and pointers returned by
+ * sl_fetch() remain valid.
+ */
+void sl_sort(single_list list, comp_fn comp);
+
+/**
+ * Merge one sorted list into another.
+ * @param dst The list to merge into
+ * @param src The list to merge from
+ * @param comp The function both lists are sorted by (see sl_sort())
+ *
+ * Moves every element of `src` into `dst` in linear time, so that `dst`
+ * remains sorted; `src` is left empty.  Elements of `dst` are ordered before
+ * equal elements of `src`.
+ *
+ * @return `true` on success.  Otherwise, `false` is returned and `errno` is
+ * set to `EINVAL` if `dst` and `src` are the same list or store data of
+ * different sizes.
+ */
+bool sl_merge(single_list dst, single_list src, comp_fn comp);
+
+/**
+ * Move every element of one list into another at a given position.
+ * @param dst The list to move elements into
+ * @param pos The position in `dst` to move them to
+ *            (must be an index in the range `0..dst->length`)
+ * @param src The list to move elements from
+ *
+ * Relinks the elements of `src`, in order, into `dst` so that the first of
+ * them is at index `pos`; `src` is left empty.  No data is copied, so this
+ * takes constant time at the head or tail of `dst` and otherwise only the
+ * time to find `pos`.
+ *
+ * @return `true` on success.  Otherwise, `false` is returned and `errno` is
+ * set to indicate the error: `EINVAL` if `dst` and `src` are the same list or
+ * store data of different sizes, or if `pos` is out of range.
+ */
+bool sl_splice(single_list dst, size_t pos, single_list src);
+
+/**
+ * Move every element of one list onto the tail of another.
+ * @param dst The list to append to
+ * @param src The list to move elements from
+ *
+ * Equivalent to sl_splice() at the tail of `dst`, in constant time.
+ *
+ * @return `true` on success.  Otherwise, `false` is returned and `errno` is
+ * set as for sl_splice().
+ */
+bool sl_concat(single_list dst, single_list src);
+
+/**
+ * Split a list in two at a given position.
+ * @param list The list to split
+ * @param pos  The position to split `list` at
+ *             (must be an index in the range `0..list->length`)
+ *
+ * Moves the elements of `list` from index `pos` onwards into a new list with
+ * the same properties, leaving the first `pos` elements in `list`.  The chain
+ * is cut in place, so no data is copied and pointers returned by sl_fetch()
+ * remain valid; this takes only the time to find `pos`.  Unless every element
+ * moves, the two lists go on sharing the memory the elements were allocated
+ * from, and their allocations are then serialized with each other.
+ *
+ * @return A new list holding the tail of `list`, which must be destroyed with
+ * sl_free().  Otherwise, `NULL` is returned and `errno` is set to indicate the
+ * error.
+ */
+single_list sl_split_at(single_list list, size_t pos);
+
 /**
  * Right associative fold for singly linked lists.
  * @param list A list of values to reduce
@@ -0,0 +1,357 @@
+/* unrolled_list.h - Unrolled Linked List API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UNROLLED_LIST_H
+#define __UNROLLED_LIST_H
+
+#include "focs.h"
+#include "focs/data_structure.h"
+#include "hof.h"
+#include "list/double_list.h"
+#include "list/linked_list.h"
+#include "mem/slab.h"
+#include "sync/rwlock.h"
+
+/* Target size of a single unrolled list node, in bytes, including its header.
+ * Lists whose elements are too large to fit UL_MIN_CAPACITY of them in a node
+ * of this size use larger nodes. */
+#ifndef UL_NODE_SIZE
+#define UL_NODE_SIZE 256
+#endif
+
+#define UL_MIN_CAPACITY 4
+
+/**
+ * @struct ul_node
+ * Represents a node in an unrolled linked list.
+ *
+ * Each node stores up to `capacity` consecutive elements of the list inline, so
+ * that walking the list touches one node per several elements.
+ *
+ * This structure is intended for internal use only.
+ */
+struct ul_node {
+	struct ul_node * next;
+	struct ul_node * prev;
+	size_t count;
+
+	/* `count` elements of `DS_DATA_SIZE()` bytes each, packed from the
+	 * start of the array. */
+	uint8_t data[] __attribute__((__aligned__));
+};
+
+/**
+ * @struct unrolled_list
+ * Represents an unrolled (chunked) doubly linked list.
+ *
+ * Initialize this structure with ul_create(), and destroy it with ul_free().
+ */
+START_DS(unrolled_list) {
+	struct ul_node * head;
+	struct ul_node * tail;
+	size_t length;
+	size_t capacity;
+
+	struct slab_cache * slab;
+	struct rwlock * rwlock;
+} END_DS(unrolled_list);
+
+/* ########################## *
+ * # Creation & Destruction # *
+ * ########################## */
+
+/**
+ * Allocate and initialize a new unrolled linked list.
+ * @param props The properties of the list; only `data_size` is used
+ *
+ * @return Upon successful completion, ul_create() shall return a new
+ * unrolled_list.  Otherwise, `NULL` shall be returned and `errno` set to
+ * indicate the error.
+ */
+unrolled_list ul_create(const struct ds_properties * props);
+
+/**
+ * Destroy and deallocate an unrolled linked list.
+ * @param list A pointer to an `unrolled_list`
+ *
+ * De-allocates the unrolled linked list pointed to by `list`, as well as every
+ * data element contained within it.
+ */
+void ul_free(unrolled_list * list);
+
+/* ############################# *
+ * # Data Management Functions # *
+ * ############################# */
+
+/**
+ * Push a new data element to the head of the list.
+ * @param list The list to push onto
+ * @param data A pointer to the data to push
+ *
+ * Push a copy of `data` onto the head of `list`.
+ */
+void ul_push_head(unrolled_list list, void * data);
+
+/**
+ * Push a new data element to the tail of the list.
+ * @param list The list to push onto
+ * @param data A pointer to the data to push
+ *
+ * Push a copy of `data` onto the tail of `list`.
+ */
+void ul_push_tail(unrolled_list list, void * data);
+
+/**
+ * Pop a data element from the head of a list.
+ * @param list The list to pop from
+ *
+ * @return A pointer to a copy of the data element at the head of `list`, or
+ * `NULL` if `list` is empty.  This pointer must be explicitly freed with free()
+ * when it is no longer needed.
+ */
+void * ul_pop_head(unrolled_list list);
+
+/**
+ * Pop a data element from the tail of a list.
+ * @param list The list to pop from
+ *
+ * @return A pointer to a copy of the data element at the tail of `list`, or
+ * `NULL` if `list` is empty.  This pointer must be explicitly freed with free()
+ * when it is no longer needed.
+ */
+void * ul_pop_tail(unrolled_list list);
+
+/**
+ * Insert a new data element to a given position in a list.
+ * @param list The list to insert into
+ * @param data A pointer to the data to insert
+ * @param pos  The position to insert the element at
+ *             (must be an index in the range `0..DS_PRIV(list)->length`)
+ *
+ * Insert a copy of `data` into `list` at the index indicated by `pos`.  A full
+ * node is split in two to make room.
+ *
+ * @return `true` if the insertion succeeds, otherwise `false`.
+ */
+bool ul_insert(unrolled_list list, void * data, size_t pos);
+
+/**
+ * Delete a data element from a given position in a list.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..DS_PRIV(list)->length - 1`)
+ *
+ * A node left less than half full is merged with its successor when their
+ * elements fit in one node.
+ *
+ * @return `true` if the deletion succeeds, otherwise `false`.
+ */
+bool ul_delete(unrolled_list list, size_t pos);
+
+/**
+ * Delete and return a data element from a given position in a list.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..DS_PRIV(list)->length - 1`)
+ *
+ * @return A pointer to a copy of the data removed from `list`, or `NULL` on
+ * failure.  This pointer must be explicitly freed with free() when it is no
+ * longer needed.
+ */
+void * ul_remove(unrolled_list list, size_t pos);
+
+/**
+ * Fetch a data element from a given position in a list.
+ * @param list The list to fetch from
+ * @param pos  The index to fetch the element from
+ *             (must be an index in the range `0..DS_PRIV(list)->length - 1`)
+ *
+ * @return A pointer to the data at index `pos`, or `NULL` on failure.
+ * This pointer should **not** be free()d explicitly.  Elements move between
+ * nodes as the list changes, so the pointer is only valid until the next
+ * operation that modifies `list`.
+ */
+void * ul_fetch(unrolled_list list, size_t pos);
+
+/* ############################ *
+ * # Transformation Functions # *
+ * ############################ */
+
+/**
+ * Map a function over an unrolled list in-place.
+ * @param list A list of values
+ * @param fn A function that will transform each value in the list
+ *
+ * See dl_map().
+ */
+void ul_map(unrolled_list list, map_fn fn);
+
+/**
+ * Reverse a list in place.
+ * @param list The list to reverse
+ */
+void ul_reverse(unrolled_list list);
+
+/**
+ * Right associative fold for unrolled lists.
+ * @param list A list of values to reduce
+ * @param fn A binary function that will sequentially reduce values
+ * @param init An initial value for the fold
+ *
+ * See dl_foldr().
+ *
+ * @return The result of a right associate fold over `list`, which must be
+ * freed with free().  If `list` is empty, the fold will be equal to the value
+ * of `init`.
+ */
+void * ul_foldr(const unrolled_list list,
+		foldr_fn fn,
+		const void * init);
+
+/**
+ * Left associative fold for unrolled lists.
+ * @param list A list of values to reduce
+ * @param fn A binary function that will sequentially reduce values
+ * @param init An initial value for the fold
+ *
+ * See dl_foldl().
+ *
+ * @return The result of a left associate fold over `list`, which must be
+ * freed with free().  If `list` is empty, the fold will be equal to the value
+ * of `init`.
+ */
+void * ul_foldl(const unrolled_list list,
+		foldl_fn fn,
+		const void * init);
+
+/* ################### *
+ * # Data Properties # *
+ * ################### */
+
+/**
+ * Determine if a list is empty.
+ * @param list The list to check
+ *
+ * @return `true` if `list` is empty, `false` otherwise.
+ */
+bool ul_null(unrolled_list list);
+
+/**
+ * Count the elements in a list.
+ * @param list The list to measure
+ *
+ * @return The number of elements in `list`.
+ */
+size_t ul_length(unrolled_list list);
+
+/**
+ * Determine if a list contains a value.
+ * @param list The list to search
+ * @param data The data to search for in the list
+ *
+ * The operation compares the contents of the memory pointed to by `data`, and
+ * not the memory addresses of the data pointers.
+ *
+ * @return `true` if a matching entry is found, otherwise `false`
+ */
+bool ul_contains(unrolled_list list, void * data);
+
+/**
+ * Determine if any value in a list satisifies some condition.
+ * @param list A list of values
+ * @param p The predicate function (representing a condition to be satisfied).
+ *
+ * @return `true` if there is at least one value that satisfies the predicate.
+ * Otherwise, it returns `false`.
+ */
+bool ul_any(unrolled_list list, pred_fn p);
+
+/**
+ * Determines if all values in a list satisify some condition
+ * @param list A list of values
+ * @param p The predicate function (representing a condition to be satisfied).
+ *
+ * @return `false` if there is at least one value that does not satisfy the
+ * predicate, or if `list` is empty.  Otherwise, it returns `true`.
+ */
+bool ul_all(unrolled_list list, pred_fn p);
+
+/* ############# *
+ * # Filtering # *
+ * ############# */
+
+/**
+ * Filter a list to contain only values that satisfy some predicate.
+ * @param list The list to filter
+ * @param p The predicate
+ *
+ * Filter `list` in-place by removing elements that do not satisfy the
+ * predicate `p`.  The surviving elements are packed into as few nodes as
+ * possible.
+ *
+ * @return `true` if any element was removed, otherwise `false`.
+ */
+bool ul_filter(unrolled_list list, pred_fn p);
+
+/**
+ * Drop elements from the head of the list until the predicate is unsatisfied.
+ *
+ * This function is an in-place equivalent of Haskell's dropWhile.
+ *
+ * @return `true` if any element was removed, otherwise `false`.
+ */
+bool ul_drop_while(unrolled_list list, pred_fn p);
+
+/**
+ * Keep elements from the head of the list until the predicate is unsatisfied.
+ *
+ * This function is an in-place equivalent of Haskell's takeWhile.
+ *
+ * @return `true` if any element was removed, otherwise `false`.
+ */
+bool ul_take_while(unrolled_list list, pred_fn p);
+
+#ifdef GENERICS
+
+static const struct mgmt_operations mgmt_ops = {
+	.empty   = (empty_mgmt_fn)   ul_null,
+	.elem    = (elem_mgmt_fn)    ul_contains,
+	.size    = (size_mgmt_fn)    ul_length,
+	.destroy = (destroy_mgmt_fn) ul_free,
+};
+
+static const struct hof_operations hof_ops = {
+	.map        = (map_hof_fn)        ul_map,
+	.foldr      = (foldr_hof_fn)      ul_foldr,
+	.foldl      = (foldl_hof_fn)      ul_foldl,
+	.any        = (any_hof_fn)        ul_any,
+	.all        = (all_hof_fn)        ul_all,
+	.filter     = (filter_hof_fn)     ul_filter,
+	.drop_while = (drop_while_hof_fn) ul_drop_while,
+	.take_while = (take_while_hof_fn) ul_take_while,
+};
+
+#else /* GENERICS */
+
+static const __unused void * mgmt_ops = NULL;
+static const __unused void * hof_ops  = NULL;
+
+#endif /* GENERICS */
+
+#endif /* __UNROLLED_LIST_H */
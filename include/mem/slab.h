@@ -0,0 +1,71 @@
+/* slab.h - Slab Allocator
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SLAB_H
+#define __SLAB_H
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "focs.h"
+
+/* Target size of a single slab, in bytes.  Caches with large objects grow
+ * their slabs so that each one still holds at least SLAB_MIN_OBJECTS. */
+#define SLAB_SIZE 4096
+#define SLAB_MIN_OBJECTS 8
+
+/* A slab cache hands out fixed-size objects carved from large slabs.  Freed
+ * objects are threaded onto a free list through their first word and reused
+ * before any new slab is allocated; slabs are only returned to the system
+ * when the whole cache is freed.  A cache with a single owner is not
+ * thread-safe: its owner must serialize access to it.  Once shared between
+ * owners with slab_cache_share(), access is serialized by a spinlock. */
+struct slab_cache {
+	size_t object_size;
+	size_t per_slab;
+	struct slab * slabs;
+	struct slab * last;
+	void * free;
+	void * free_last;
+
+	/* Objects at the end of the newest slab that have never been handed
+	 * out; they are bump-allocated rather than threaded onto the free list
+	 * up front. */
+	uint8_t * fresh;
+	size_t fresh_count;
+
+	/* The number of owners, counting caches forwarded to this one.  A
+	 * shared cache absorbed into another forwards its owners there. */
+	atomic_size_t refs;
+	_Atomic(struct slab_cache *) forward;
+	atomic_flag lock;
+};
+
+int slab_cache_alloc(struct slab_cache ** cache, size_t object_size);
+void slab_cache_free(struct slab_cache ** cache);
+struct slab_cache * slab_cache_share(struct slab_cache * cache);
+bool slab_cache_shared(struct slab_cache * cache);
+void * slab_get(struct slab_cache * cache);
+void slab_put(struct slab_cache * cache, void * object);
+int slab_cache_absorb(struct slab_cache * cache, struct slab_cache * donor);
+
+#endif /* __SLAB_H */
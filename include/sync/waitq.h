@@ -0,0 +1,51 @@
+/* waitq.h - Wait Queue
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WAITQ_H
+#define __WAITQ_H
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "focs.h"
+
+/* A wait queue lets threads sleep until some condition on shared state
+ * becomes true.  Wakers skip the mutex and condition variable entirely unless
+ * a thread is actually parked, so waking an idle queue costs one fence and
+ * one load. */
+struct waitq {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	atomic_size_t waiters;
+};
+
+typedef bool (*waitq_pred_fn)(const void * arg);
+
+int waitq_alloc(struct waitq ** waitq);
+void waitq_free(struct waitq ** waitq);
+void waitq_deadline(struct timespec * deadline, const struct timespec * timeout);
+int waitq_wait(struct waitq * waitq,
+	       waitq_pred_fn pred,
+	       const void * arg,
+	       const struct timespec * deadline);
+void waitq_wake(struct waitq * waitq);
+
+#endif /* __WAITQ_H */
@@ -0,0 +1,63 @@
+/* rank_tree.h - Order Statistic Tree
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RANK_TREE_H
+#define __RANK_TREE_H
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "focs.h"
+#include "mem/slab.h"
+
+/* A rank tree keeps a sequence of pointers ordered by position, and finds,
+ * inserts or removes the value at any position in O(log n) expected time.  It
+ * is a treap keyed implicitly by subtree size: each node is ordered by its
+ * position in the sequence and heap-ordered by a random priority.  A rank tree
+ * is not thread-safe: callers must serialize access to it. */
+struct rank_node {
+	struct rank_node * left;
+	struct rank_node * right;
+	size_t size;
+	uint32_t priority;
+	void * value;
+};
+
+struct rank_tree {
+	struct rank_node * root;
+	struct slab_cache * slab;
+	uint32_t seed;
+
+	/* Positions are counted from the other end of the tree, so that the
+	 * sequence can be reversed in constant time. */
+	bool reversed;
+};
+
+int rank_tree_alloc(struct rank_tree ** tree);
+void rank_tree_free(struct rank_tree ** tree);
+size_t rank_tree_size(const struct rank_tree * tree);
+void * rank_tree_fetch(const struct rank_tree * tree, size_t pos);
+bool rank_tree_insert(struct rank_tree * tree, size_t pos, void * value);
+void * rank_tree_remove(struct rank_tree * tree, size_t pos);
+void rank_tree_drop_head(struct rank_tree * tree, size_t count);
+void rank_tree_drop_tail(struct rank_tree * tree, size_t count);
+void rank_tree_reverse(struct rank_tree * tree);
+
+#endif /* __RANK_TREE_H */
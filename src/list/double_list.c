@@ -20,37 +20,130 @@
 
 #include "list/double_list.h"
 
-static struct dl_element * __create_element(void * data,
-					    size_t data_size)
+static struct dl_element * __create_element(double_list list, void * data)
 {
 	struct dl_element * elem;
 
-	elem = malloc(sizeof(*elem));
+	elem = slab_get(DS_PRIV(list)->slab);
 	if(!elem)
-		return_with_errno(ENOMEM, NULL);
-
-	elem->data = malloc(data_size);
-	if(!elem->data)
-		goto_with_errno(ENOMEM, exit);
+		return NULL;
 
-	memcpy(elem->data, data, data_size);
+	memcpy(elem->data, data, DS_DATA_SIZE(list));
 	return elem;
+}
 
-exit:
-	free(elem);
-	return NULL;
+static void __destroy_element(double_list list, struct dl_element * elem)
+{
+	slab_put(DS_PRIV(list)->slab, elem);
+}
+
+/* Copies the data out of an unlinked element into @data, a buffer owned by
+ * the caller, and returns the element to the slab cache. */
+static void __release_element(double_list list,
+			      struct dl_element * elem,
+			      void * data)
+{
+	memcpy(data, elem->data, DS_DATA_SIZE(list));
+	__destroy_element(list, elem);
+}
+
+/* Record @elem as the element at @pos in the list's positional index, if it
+ * has one. */
+static bool __index_insert(double_list list,
+			   size_t pos,
+			   struct dl_element * elem)
+{
+	if(!DS_PRIV(list)->index)
+		return true;
+
+	return rank_tree_insert(DS_PRIV(list)->index, pos, elem);
+}
+
+static void __index_remove(double_list list, size_t pos)
+{
+	if(DS_PRIV(list)->index)
+		rank_tree_remove(DS_PRIV(list)->index, pos);
+}
+
+/* The finger remembers the last element found by position.  Lookups run under
+ * the reader lock, so concurrent readers share the finger through a try-lock;
+ * since the finger is only a hint, a reader that finds it busy ignores it.
+ * Under the writer lock no reader is active and the finger is accessed
+ * directly. */
+static bool __finger_get(double_list list,
+			 struct dl_element ** elem,
+			 size_t * pos)
+{
+	struct double_list_priv * priv = DS_PRIV(list);
+
+	if(atomic_flag_test_and_set_explicit(&priv->finger_lock,
+					     memory_order_acquire))
+		return false;
+
+	*elem = priv->finger;
+	*pos = priv->finger_pos;
+
+	atomic_flag_clear_explicit(&priv->finger_lock, memory_order_release);
+
+	return *elem != NULL;
+}
+
+static void __finger_set(double_list list, struct dl_element * elem, size_t pos)
+{
+	struct double_list_priv * priv = DS_PRIV(list);
+
+	if(atomic_flag_test_and_set_explicit(&priv->finger_lock,
+					     memory_order_acquire))
+		return;
+
+	priv->finger = elem;
+	priv->finger_pos = pos;
+
+	atomic_flag_clear_explicit(&priv->finger_lock, memory_order_release);
+}
+
+static inline size_t __distance(size_t a, size_t b)
+{
+	return (a > b) ? a - b : b - a;
 }
 
 static struct dl_element * __lookup_element(double_list list, size_t pos)
 {
+	size_t length = DS_PRIV(list)->length;
+	size_t start;
+	size_t finger_pos;
 	struct dl_element * current;
+	struct dl_element * finger;
 
-	if(pos >= DS_PRIV(list)->length)
+	if(pos >= length)
 		return NULL;
 
-	current = DS_PRIV(list)->head;
-	for(size_t i = 0; i < pos; i++)
+	if(DS_PRIV(list)->index)
+		return rank_tree_fetch(DS_PRIV(list)->index, pos);
+
+	/* Walk from whichever of the head, the tail and the finger is
+	 * closest to @pos. */
+	if(pos <= length - 1 - pos) {
+		current = DS_PRIV(list)->head;
+		start = 0;
+	} else {
+		current = DS_PRIV(list)->tail;
+		start = length - 1;
+	}
+
+	if(__finger_get(list, &finger, &finger_pos) &&
+	   __distance(finger_pos, pos) < __distance(start, pos)) {
+		current = finger;
+		start = finger_pos;
+	}
+
+	for(; start < pos; start++)
 		current = current->next;
+	for(; start > pos; start--)
+		current = current->prev;
+
+	__finger_set(list, current, pos);
+
 	return current;
 }
 
@@ -131,6 +224,9 @@ static bool __insert_element(double_list list, struct dl_element * current, size
 	if(pos > DS_PRIV(list)->length)
 		return false;
 
+	if(!__index_insert(list, pos, current))
+		return false;
+
 	if(pos == 0) {
 		__push_head(list, current);
 	} else if(pos == DS_PRIV(list)->length) {
@@ -146,6 +242,10 @@ static bool __insert_element(double_list list, struct dl_element * current, size
 		(DS_PRIV(list)->length)++;
 	}
 
+	/* The elements from @pos onwards have moved up one position. */
+	if(DS_PRIV(list)->finger && pos <= DS_PRIV(list)->finger_pos)
+		(DS_PRIV(list)->finger_pos)++;
+
 	return true;
 }
 
@@ -168,11 +268,23 @@ static struct dl_element * __remove_element(double_list list, size_t pos)
 		(DS_PRIV(list)->length)--;
 	}
 
+	__index_remove(list, pos);
+
+	/* Step the finger back off the removed element, or down one position
+	 * if it was after it. */
+	if(DS_PRIV(list)->finger == current) {
+		DS_PRIV(list)->finger = current->prev;
+		DS_PRIV(list)->finger_pos = pos - 1;
+	} else if(DS_PRIV(list)->finger && pos < DS_PRIV(list)->finger_pos)
+		(DS_PRIV(list)->finger_pos)--;
+
 	return current;
 }
 
 static void __delete_element(double_list list, struct dl_element * elem)
 {
+	DS_PRIV(list)->finger = NULL;
+
 	/* Fix head and tail. */
 	if(DS_PRIV(list)->head == elem)
 		DS_PRIV(list)->head = elem->next;
@@ -190,15 +302,21 @@ static void __delete_element(double_list list, struct dl_element * elem)
 
 static void __delete_before(double_list list, struct dl_element * mark)
 {
+	size_t count = 0;
 	struct dl_element * current;
 
+	DS_PRIV(list)->finger = NULL;
+
 	linked_list_while_safe(list, current, current != mark) {
-		free(current->data);
-		free(current);
+		__destroy_element(list, current);
 
 		(DS_PRIV(list)->length)--;
+		count++;
 	}
 
+	if(DS_PRIV(list)->index)
+		rank_tree_drop_head(DS_PRIV(list)->index, count);
+
 	DS_PRIV(list)->head = mark;
 	if(mark)
 		mark->prev = NULL;
@@ -208,15 +326,21 @@ static void __delete_before(double_list list, struct dl_element * mark)
 
 static void __delete_after(double_list list, struct dl_element * mark)
 {
+	size_t count = 0;
 	struct dl_element * current;
 
+	DS_PRIV(list)->finger = NULL;
+
 	double_list_while_rev_safe(list, current, current != mark) {
-		free(current->data);
-		free(current);
+		__destroy_element(list, current);
 
 		(DS_PRIV(list)->length)--;
+		count++;
 	}
 
+	if(DS_PRIV(list)->index)
+		rank_tree_drop_tail(DS_PRIV(list)->index, count);
+
 	DS_PRIV(list)->tail = mark;
 	if(mark)
 		mark->next = NULL;
@@ -224,6 +348,191 @@ static void __delete_after(double_list list, struct dl_element * mark)
 		DS_PRIV(list)->head = NULL;
 }
 
+/* Re-record every element's position in the positional index after the list
+ * has been relinked wholesale.  The tree's nodes are recycled through its slab
+ * cache, so this cannot fail as long as the index held at least one node per
+ * element of the list beforehand. */
+static void __index_rebuild(double_list list, size_t old_length)
+{
+	size_t pos = 0;
+	struct dl_element * current;
+
+	if(!DS_PRIV(list)->index)
+		return;
+
+	rank_tree_drop_head(DS_PRIV(list)->index, old_length);
+
+	linked_list_foreach(list, current)
+		rank_tree_insert(DS_PRIV(list)->index, pos++, current);
+}
+
+/* Restore the `prev` pointers and the tail after the list has been relinked
+ * through its `next` pointers alone. */
+static void __relink_prev(double_list list)
+{
+	struct dl_element * current;
+	struct dl_element * prev = NULL;
+
+	linked_list_foreach(list, current) {
+		current->prev = prev;
+		prev = current;
+	}
+
+	DS_PRIV(list)->tail = prev;
+}
+
+/* Enter the writer locks of two different lists in address order, so that
+ * two threads locking the same pair of lists cannot deadlock. */
+static void __writer_entry_pair(double_list a, double_list b)
+{
+	double_list tmp;
+
+	if((uintptr_t) a > (uintptr_t) b) {
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	rwlock_writer_entry(DS_PRIV(a)->rwlock);
+	rwlock_writer_entry(DS_PRIV(b)->rwlock);
+}
+
+static void __writer_exit_pair(double_list a, double_list b)
+{
+	rwlock_writer_exit(DS_PRIV(a)->rwlock);
+	rwlock_writer_exit(DS_PRIV(b)->rwlock);
+}
+
+/* Cut the chain of elements starting at @head after at most @count elements,
+ * returning the remainder of the chain.  Only `next` pointers are
+ * maintained. */
+static struct dl_element * __cut_run(struct dl_element * head, size_t count)
+{
+	struct dl_element * rest;
+
+	if(!head)
+		return NULL;
+
+	while(--count && head->next)
+		head = head->next;
+
+	rest = head->next;
+	head->next = NULL;
+
+	return rest;
+}
+
+/* Merge the sorted chains @a and @b onto @link, and return the link following
+ * the last merged element.  Ties are taken from @a so that merges are
+ * stable.  Only `next` pointers are maintained. */
+static struct dl_element ** __merge_runs(struct dl_element ** link,
+					 struct dl_element * a,
+					 struct dl_element * b,
+					 comp_fn comp)
+{
+	while(a && b) {
+		if(comp(b->data, a->data)) {
+			*link = b;
+			b = b->next;
+		} else {
+			*link = a;
+			a = a->next;
+		}
+
+		link = &(*link)->next;
+	}
+
+	for(*link = a ? a : b; *link; link = &(*link)->next) {}
+
+	return link;
+}
+
+/* Record the chain of elements starting at @first as the positions from @pos
+ * onwards in the positional index, if the list has one.  On failure, any
+ * positions recorded are forgotten again. */
+static bool __index_chain(double_list list,
+			  size_t pos,
+			  struct dl_element * first,
+			  size_t count)
+{
+	size_t i;
+
+	if(!DS_PRIV(list)->index)
+		return true;
+
+	for(i = 0; i < count; i++, first = first->next) {
+		if(!rank_tree_insert(DS_PRIV(list)->index, pos + i, first))
+			goto undo;
+	}
+
+	return true;
+
+undo:
+	while(i-- > 0)
+		rank_tree_remove(DS_PRIV(list)->index, pos);
+
+	return false;
+}
+
+static bool __compatible(double_list dst, double_list src)
+{
+	return dst != src && DS_DATA_SIZE(dst) == DS_DATA_SIZE(src);
+}
+
+/* Move every element of @src into @dst at @pos.  Both lists' writer locks
+ * must be held. */
+static bool __splice(double_list dst, size_t pos, double_list src)
+{
+	size_t count = DS_PRIV(src)->length;
+	struct dl_element * prev;
+	struct dl_element * next;
+
+	if(pos > DS_PRIV(dst)->length)
+		return_with_errno(EINVAL, false);
+
+	if(count == 0)
+		return true;
+
+	if(!__index_chain(dst, pos, DS_PRIV(src)->head, count))
+		return_with_errno(ENOMEM, false);
+
+	/* The elements of @src now belong to @dst, so @dst must release
+	 * them. */
+	slab_cache_absorb(DS_PRIV(dst)->slab, DS_PRIV(src)->slab);
+
+	prev = pos ? __lookup_element(dst, pos - 1) : NULL;
+	next = prev ? prev->next : DS_PRIV(dst)->head;
+
+	DS_PRIV(src)->head->prev = prev;
+	DS_PRIV(src)->tail->next = next;
+
+	if(prev)
+		prev->next = DS_PRIV(src)->head;
+	else
+		DS_PRIV(dst)->head = DS_PRIV(src)->head;
+
+	if(next)
+		next->prev = DS_PRIV(src)->tail;
+	else
+		DS_PRIV(dst)->tail = DS_PRIV(src)->tail;
+
+	DS_PRIV(dst)->length += count;
+
+	/* The elements from @pos onwards have moved up @count positions. */
+	if(DS_PRIV(dst)->finger && pos <= DS_PRIV(dst)->finger_pos)
+		DS_PRIV(dst)->finger_pos += count;
+
+	if(DS_PRIV(src)->index)
+		rank_tree_drop_head(DS_PRIV(src)->index, count);
+
+	DS_PRIV(src)->head = NULL;
+	DS_PRIV(src)->tail = NULL;
+	DS_PRIV(src)->length = 0;
+	DS_PRIV(src)->finger = NULL;
+
+	return true;
+}
+
 double_list dl_create(const struct ds_properties * props)
 {
 	double_list list;
@@ -239,6 +548,19 @@ double_list dl_create(const struct ds_properties * props)
 	priv->head = NULL;
 	priv->tail = NULL;
 	priv->length = 0;
+	priv->slab = NULL;
+	priv->index = NULL;
+	priv->finger = NULL;
+	priv->finger_pos = 0;
+	atomic_flag_clear(&priv->finger_lock);
+	priv->rwlock = NULL;
+
+	if(slab_cache_alloc(&priv->slab,
+			    sizeof(struct dl_element) + DS_DATA_SIZE(list)) < 0)
+		goto exit;
+
+	if(props->indexed && rank_tree_alloc(&priv->index) < 0)
+		goto exit;
 
 	if(rwlock_alloc(&priv->rwlock) < 0)
 		goto exit;
@@ -255,15 +577,24 @@ void dl_free(double_list * list)
 {
 	struct dl_element * current;
 
-	rwlock_writer_entry(DS_PRIV(*list)->rwlock);
+	/* Every element lives in the list's slab cache, so releasing the
+	 * cache frees them all without walking the list.  A cache shared with
+	 * other lists outlives this one, though, so the elements are handed
+	 * back to it first. */
+	if(DS_PRIV(*list)->slab) {
+		if(slab_cache_shared(DS_PRIV(*list)->slab)) {
+			linked_list_foreach_safe(*list, current)
+				__destroy_element(*list, current);
+		}
 
-	linked_list_foreach_safe(*list, current) {
-		free(current->data);
-		free(current);
+		slab_cache_free(&DS_PRIV(*list)->slab);
 	}
 
-	rwlock_writer_exit(DS_PRIV(*list)->rwlock);
-	rwlock_free(&DS_PRIV(*list)->rwlock);
+	if(DS_PRIV(*list)->index)
+		rank_tree_free(&DS_PRIV(*list)->index);
+
+	if(DS_PRIV(*list)->rwlock)
+		rwlock_free(&DS_PRIV(*list)->rwlock);
 
 	DS_FREE(list);
 }
@@ -283,10 +614,10 @@ void dl_push_head(double_list list, void * data)
 {
 	struct dl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_head(list, current);
+	current = __create_element(list, data);
+	if(current && !__insert_element(list, current, 0))
+		__destroy_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
@@ -294,43 +625,51 @@ void dl_push_tail(double_list list, void * data)
 {
 	struct dl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_tail(list, current);
+	current = __create_element(list, data);
+	if(current && !__insert_element(list, current, DS_PRIV(list)->length))
+		__destroy_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
 void * dl_pop_head(double_list list)
 {
-	void * data = NULL;
+	void * data;
 	struct dl_element * current;
 
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	current = __pop_head(list);
+	current = __remove_element(list, 0);
+	if(current)
+		__release_element(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
+	if(!current)
+		free_null(data);
 
 	return data;
 }
 
 void * dl_pop_tail(double_list list)
 {
-	void * data = NULL;
+	void * data;
 	struct dl_element * current;
 
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	current = __pop_tail(list);
+	current = __remove_element(list, DS_PRIV(list)->length - 1);
+	if(current)
+		__release_element(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
+	if(!current)
+		free_null(data);
 
 	return data;
 }
@@ -340,10 +679,11 @@ bool dl_insert(double_list list, void * data, size_t pos)
 	bool success;
 	struct dl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	success = __insert_element(list, current, pos);
+	current = __create_element(list, data);
+	success = current && __insert_element(list, current, pos);
+	if(current && !success)
+		__destroy_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return success;
@@ -355,31 +695,30 @@ bool dl_delete(double_list list, size_t pos)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __remove_element(list, pos);
+	if(current)
+		__destroy_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		free(current->data);
-		free(current);
-
-		return true;
-	}
-
-	return false;
+	return current != NULL;
 }
 
 void * dl_remove(double_list list, size_t pos)
 {
-	void * data = NULL;
+	void * data;
 	struct dl_element * current;
 
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __remove_element(list, pos);
+	if(current)
+		__release_element(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
+	if(!current)
+		free_null(data);
 
 	return data;
 }
@@ -464,6 +803,7 @@ bool dl_all(double_list list, pred_fn p)
 bool dl_filter(double_list list, pred_fn p)
 {
 	bool changed = false;
+	size_t pos = 0;
 	struct dl_element * current;
 
 	if(dl_null(list))
@@ -476,8 +816,10 @@ bool dl_filter(double_list list, pred_fn p)
 			changed = true;
 
 			__delete_element(list, current);
-			free(current->data);
-			free(current);
+			__index_remove(list, pos);
+			__destroy_element(list, current);
+		} else {
+			pos++;
 		}
 	}
 
@@ -573,6 +915,187 @@ void dl_reverse(double_list list)
 	tmp = DS_PRIV(list)->head;
 	DS_PRIV(list)->head = DS_PRIV(list)->tail;
 	DS_PRIV(list)->tail = tmp;
+
+	if(DS_PRIV(list)->index)
+		rank_tree_reverse(DS_PRIV(list)->index);
+
+	if(DS_PRIV(list)->finger)
+		DS_PRIV(list)->finger_pos = DS_PRIV(list)->length - 1 -
+			DS_PRIV(list)->finger_pos;
+}
+
+void dl_sort(double_list list, comp_fn comp)
+{
+	size_t width;
+	struct dl_element * a, * b, * rest;
+	struct dl_element ** link;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	/* Merge adjacent runs of 1, 2, 4, ... elements until one run spans the
+	 * whole list, then restore the backward links in a single pass. */
+	for(width = 1; width < DS_PRIV(list)->length; width *= 2) {
+		rest = DS_PRIV(list)->head;
+		link = &DS_PRIV(list)->head;
+
+		while(rest) {
+			a = rest;
+			b = __cut_run(a, width);
+			rest = __cut_run(b, width);
+			link = __merge_runs(link, a, b, comp);
+		}
+	}
+
+	__relink_prev(list);
+	__index_rebuild(list, DS_PRIV(list)->length);
+	DS_PRIV(list)->finger = NULL;
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+bool dl_merge(double_list dst, double_list src, comp_fn comp)
+{
+	bool success = true;
+
+	if(!__compatible(dst, src))
+		return_with_errno(EINVAL, false);
+
+	__writer_entry_pair(dst, src);
+
+	if(DS_PRIV(src)->length > 0) {
+		/* Reserve index nodes for the elements of @src before anything
+		 * is relinked, so that rebuilding the index cannot fail. */
+		if(!__index_chain(dst, DS_PRIV(dst)->length,
+				  DS_PRIV(src)->head, DS_PRIV(src)->length)) {
+			success = false;
+			goto_with_errno(ENOMEM, exit);
+		}
+
+		/* The elements of @src now belong to @dst, so @dst must release
+		 * them. */
+		slab_cache_absorb(DS_PRIV(dst)->slab, DS_PRIV(src)->slab);
+
+		__merge_runs(&DS_PRIV(dst)->head,
+			     DS_PRIV(dst)->head,
+			     DS_PRIV(src)->head,
+			     comp);
+
+		DS_PRIV(dst)->length += DS_PRIV(src)->length;
+
+		__relink_prev(dst);
+		__index_rebuild(dst, DS_PRIV(dst)->length);
+		DS_PRIV(dst)->finger = NULL;
+
+		if(DS_PRIV(src)->index)
+			rank_tree_drop_head(DS_PRIV(src)->index,
+					    DS_PRIV(src)->length);
+
+		DS_PRIV(src)->head = NULL;
+		DS_PRIV(src)->tail = NULL;
+		DS_PRIV(src)->length = 0;
+		DS_PRIV(src)->finger = NULL;
+	}
+
+exit:
+	__writer_exit_pair(dst, src);
+
+	return success;
+}
+
+bool dl_splice(double_list dst, size_t pos, double_list src)
+{
+	bool success;
+
+	if(!__compatible(dst, src))
+		return_with_errno(EINVAL, false);
+
+	__writer_entry_pair(dst, src);
+	success = __splice(dst, pos, src);
+	__writer_exit_pair(dst, src);
+
+	return success;
+}
+
+bool dl_concat(double_list dst, double_list src)
+{
+	bool success;
+
+	if(!__compatible(dst, src))
+		return_with_errno(EINVAL, false);
+
+	__writer_entry_pair(dst, src);
+	success = __splice(dst, DS_PRIV(dst)->length, src);
+	__writer_exit_pair(dst, src);
+
+	return success;
+}
+
+double_list dl_split_at(double_list list, size_t pos)
+{
+	size_t length;
+	struct slab_cache * slab;
+	struct dl_element * mark;
+	double_list rest;
+
+	rest = dl_create(DS_PROPS(list));
+	if(!rest)
+		return NULL;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	length = DS_PRIV(list)->length;
+	if(pos > length)
+		goto_with_errno(EINVAL, fail);
+
+	/* The first element to move into @rest, or NULL if none. */
+	mark = __lookup_element(list, pos);
+
+	if(!__index_chain(rest, 0, mark, length - pos))
+		goto_with_errno(ENOMEM, fail);
+
+	/* The elements stay where they are, in the slab cache of @list.  If
+	 * they all move, @rest takes the cache over; otherwise the two lists
+	 * share it from now on. */
+	if(pos == 0) {
+		slab = DS_PRIV(list)->slab;
+		DS_PRIV(list)->slab = DS_PRIV(rest)->slab;
+		DS_PRIV(rest)->slab = slab;
+	} else if(mark) {
+		slab_cache_free(&DS_PRIV(rest)->slab);
+		DS_PRIV(rest)->slab = slab_cache_share(DS_PRIV(list)->slab);
+	}
+
+	if(mark) {
+		DS_PRIV(rest)->head = mark;
+		DS_PRIV(rest)->tail = DS_PRIV(list)->tail;
+
+		DS_PRIV(list)->tail = mark->prev;
+		if(mark->prev)
+			mark->prev->next = NULL;
+		else
+			DS_PRIV(list)->head = NULL;
+		mark->prev = NULL;
+	}
+
+	if(DS_PRIV(list)->index)
+		rank_tree_drop_tail(DS_PRIV(list)->index, length - pos);
+
+	/* The finger is only kept if it stays in @list. */
+	if(DS_PRIV(list)->finger && DS_PRIV(list)->finger_pos >= pos)
+		DS_PRIV(list)->finger = NULL;
+
+	DS_PRIV(rest)->length = length - pos;
+	DS_PRIV(list)->length = pos;
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return rest;
+
+fail:
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+	dl_free(&rest);
+
+	return NULL;
 }
 
 void * dl_foldr(const double_list list,
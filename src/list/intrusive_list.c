@@ -0,0 +1,324 @@
+/* intrusive_list.c - Intrusive Linked List Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "list/intrusive_list.h"
+
+static void __isl_push_head(isingle_list list, struct isl_link * link)
+{
+	link->next = DS_PRIV(list)->head;
+	DS_PRIV(list)->head = link;
+
+	if(!DS_PRIV(list)->tail)
+		DS_PRIV(list)->tail = link;
+
+	(DS_PRIV(list)->length)++;
+}
+
+static struct isl_link * __isl_remove_after(isingle_list list,
+					    struct isl_link * mark)
+{
+	struct isl_link * link;
+
+	link = mark ? mark->next : DS_PRIV(list)->head;
+	if(!link)
+		return NULL;
+
+	if(mark)
+		mark->next = link->next;
+	else
+		DS_PRIV(list)->head = link->next;
+
+	if(DS_PRIV(list)->tail == link)
+		DS_PRIV(list)->tail = mark;
+
+	link->next = NULL;
+	(DS_PRIV(list)->length)--;
+
+	return link;
+}
+
+static void __idl_insert_after(idouble_list list,
+			       struct idl_link * mark,
+			       struct idl_link * link)
+{
+	link->prev = mark;
+	link->next = mark ? mark->next : DS_PRIV(list)->head;
+
+	if(link->next)
+		link->next->prev = link;
+	else
+		DS_PRIV(list)->tail = link;
+
+	if(mark)
+		mark->next = link;
+	else
+		DS_PRIV(list)->head = link;
+
+	(DS_PRIV(list)->length)++;
+}
+
+static void __idl_delete(idouble_list list, struct idl_link * link)
+{
+	if(link->prev)
+		link->prev->next = link->next;
+	else
+		DS_PRIV(list)->head = link->next;
+
+	if(link->next)
+		link->next->prev = link->prev;
+	else
+		DS_PRIV(list)->tail = link->prev;
+
+	link->next = NULL;
+	link->prev = NULL;
+	(DS_PRIV(list)->length)--;
+}
+
+isingle_list isl_create(void)
+{
+	isingle_list list;
+	struct isingle_list_priv * priv;
+
+	list = malloc(sizeof(*list));
+	if(!list)
+		return_with_errno(ENOMEM, NULL);
+
+	/* Intrusive lists store no data of their own, so they have no
+	 * properties. */
+	DS_INIT(list, NULL, NULL, NULL);
+
+	priv = DS_PRIV(list);
+	priv->head = NULL;
+	priv->tail = NULL;
+	priv->length = 0;
+
+	if(rwlock_alloc(&priv->rwlock) < 0)
+		goto exit;
+
+	return list;
+
+exit:
+	free_null(list);
+
+	return NULL;
+}
+
+void isl_free(isingle_list * list)
+{
+	rwlock_free(&DS_PRIV(*list)->rwlock);
+
+	DS_FREE(list);
+}
+
+idouble_list idl_create(void)
+{
+	idouble_list list;
+	struct idouble_list_priv * priv;
+
+	list = malloc(sizeof(*list));
+	if(!list)
+		return_with_errno(ENOMEM, NULL);
+
+	DS_INIT(list, NULL, NULL, NULL);
+
+	priv = DS_PRIV(list);
+	priv->head = NULL;
+	priv->tail = NULL;
+	priv->length = 0;
+
+	if(rwlock_alloc(&priv->rwlock) < 0)
+		goto exit;
+
+	return list;
+
+exit:
+	free_null(list);
+
+	return NULL;
+}
+
+void idl_free(idouble_list * list)
+{
+	rwlock_free(&DS_PRIV(*list)->rwlock);
+
+	DS_FREE(list);
+}
+
+bool isl_null(isingle_list list)
+{
+	return isl_length(list) == 0;
+}
+
+size_t isl_length(isingle_list list)
+{
+	size_t length;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	length = DS_PRIV(list)->length;
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return length;
+}
+
+void isl_push_head(isingle_list list, struct isl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__isl_push_head(list, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void isl_push_tail(isingle_list list, struct isl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	link->next = NULL;
+	if(DS_PRIV(list)->tail)
+		DS_PRIV(list)->tail->next = link;
+	else
+		DS_PRIV(list)->head = link;
+	DS_PRIV(list)->tail = link;
+
+	(DS_PRIV(list)->length)++;
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+struct isl_link * isl_pop_head(isingle_list list)
+{
+	struct isl_link * link;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	link = __isl_remove_after(list, NULL);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return link;
+}
+
+void isl_insert_after(isingle_list list,
+		      struct isl_link * mark,
+		      struct isl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	if(mark) {
+		link->next = mark->next;
+		mark->next = link;
+
+		if(DS_PRIV(list)->tail == mark)
+			DS_PRIV(list)->tail = link;
+
+		(DS_PRIV(list)->length)++;
+	} else {
+		__isl_push_head(list, link);
+	}
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+struct isl_link * isl_remove_after(isingle_list list, struct isl_link * mark)
+{
+	struct isl_link * link;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	link = __isl_remove_after(list, mark);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return link;
+}
+
+bool idl_null(idouble_list list)
+{
+	return idl_length(list) == 0;
+}
+
+size_t idl_length(idouble_list list)
+{
+	size_t length;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	length = DS_PRIV(list)->length;
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return length;
+}
+
+void idl_push_head(idouble_list list, struct idl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__idl_insert_after(list, NULL, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void idl_push_tail(idouble_list list, struct idl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__idl_insert_after(list, DS_PRIV(list)->tail, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+struct idl_link * idl_pop_head(idouble_list list)
+{
+	struct idl_link * link;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	link = DS_PRIV(list)->head;
+	if(link)
+		__idl_delete(list, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return link;
+}
+
+struct idl_link * idl_pop_tail(idouble_list list)
+{
+	struct idl_link * link;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	link = DS_PRIV(list)->tail;
+	if(link)
+		__idl_delete(list, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return link;
+}
+
+void idl_insert_after(idouble_list list,
+		      struct idl_link * mark,
+		      struct idl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__idl_insert_after(list, mark, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void idl_insert_before(idouble_list list,
+		       struct idl_link * mark,
+		       struct idl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__idl_insert_after(list, mark ? mark->prev : DS_PRIV(list)->tail, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void idl_delete(idouble_list list, struct idl_link * link)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__idl_delete(list, link);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
@@ -17,208 +17,639 @@
  * along with focs.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
 #include "list/ring_buffer.h"
 #include "sync/rwlock.h"
 
+/* The control block holding the state shared by every user of `buf`. */
+static inline __pure struct ring_buffer_shared * __ctl(const ring_buffer buf)
+{
+	return DS_PRIV(buf)->shared;
+}
+
+static inline __pure size_t __capacity(const ring_buffer buf)
+{
+	return DS_PRIV(buf)->capacity;
+}
+
 static inline __pure size_t __length(const ring_buffer buf)
 {
-	return DS_PRIV(buf)->length;
+	return DS_PRIV(buf)->tail - DS_PRIV(buf)->head;
 }
 
 static inline __pure size_t __space(const ring_buffer buf)
 {
-	return DS_DATA_SIZE(buf) * DS_ENTRIES(buf);
+	return DS_DATA_SIZE(buf) * __capacity(buf);
 }
 
 static inline __pure bool __is_empty(const ring_buffer buf)
 {
-	return (__length(buf) <= 0);
+	return (DS_PRIV(buf)->head == DS_PRIV(buf)->tail);
 }
 
 static inline __pure bool __is_full(const ring_buffer buf)
 {
-	return (__length(buf) >= DS_ENTRIES(buf));
+	return (__length(buf) >= __capacity(buf));
 }
 
-static inline __pure __nonulls void * __index_to_addr(const ring_buffer buf,
-	                                              const size_t index)
+static inline __pure size_t __slot(const ring_buffer buf, const size_t count)
 {
-	size_t offset;
-	size_t start;
+	/* Power of two capacities map a counter to its slot with a mask; the
+	 * division is only needed for other capacities. */
+	if(DS_PRIV(buf)->mask)
+		return count & DS_PRIV(buf)->mask;
+
+	return count % __capacity(buf);
+}
 
+static inline __pure __nonulls void * __slot_addr(const ring_buffer buf,
+	                                          const size_t slot)
+{
 	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
 	 * Cast all our pointers to size_t integers before doing arithmetic. */
 	size_t data = (size_t) DS_PRIV(buf)->data;
-	size_t head = (size_t) DS_PRIV(buf)->head;
 
-	start = head - data;
-	offset = index * DS_DATA_SIZE(buf);
-	offset = (start + offset) % __space(buf);
-	return (void *) (data + offset);
+	return (void *) (data + slot * DS_DATA_SIZE(buf));
 }
 
-static inline __pure __nonulls size_t __addr_to_index(const ring_buffer buf,
-	                                              const void * addr)
+static inline __pure __nonulls void * __count_to_addr(const ring_buffer buf,
+	                                              const size_t count)
 {
-	size_t offset;
+	return __slot_addr(buf, __slot(buf, count));
+}
 
-	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
-	 * Cast all our pointers to size_t integers before doing arithmetic. */
-	size_t head = (size_t) DS_PRIV(buf)->head;
-	size_t mark = (size_t) addr;
+static inline __pure __nonulls void * __index_to_addr(const ring_buffer buf,
+	                                              const size_t index)
+{
+	return __count_to_addr(buf, DS_PRIV(buf)->head + index);
+}
 
-	offset = mod((ssize_t) (mark - head), (ssize_t) __space(buf));
-	return offset / DS_DATA_SIZE(buf);
+static inline __pure bool __is_mirrored(const ring_buffer buf)
+{
+	return (DS_PRIV(buf)->backing & RB_BACKING_MIRRORED);
 }
 
-static inline __pure __nonulls void * __prev(const ring_buffer buf,
-	                                     const void * addr)
+static inline __pure bool __is_shared(const ring_buffer buf)
 {
-	size_t start;
-	size_t offset;
+	return (DS_PRIV(buf)->backing & RB_BACKING_SHARED);
+}
 
-	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
-	 * Cast all our pointers to size_t integers before doing arithmetic. */
-	size_t data = (size_t) DS_PRIV(buf)->data;
-	size_t mark = (size_t) addr;
+/* Determine how many of the `count` blocks starting at counter `start` can be
+ * accessed contiguously.  In a mirrored buffer every run is contiguous, since
+ * the slots past the end of the data region alias the ones at its start. */
+static inline __pure size_t __span(const ring_buffer buf,
+				   const size_t start,
+				   const size_t count)
+{
+	if(__is_mirrored(buf))
+		return count;
 
-	start = mark - data;
-	offset = mod((ssize_t) (start - DS_DATA_SIZE(buf)),
-		     (ssize_t) DS_ENTRIES(buf));
-	return (void *) (data + offset);
+	return MIN(count, __capacity(buf) - __slot(buf, start));
 }
 
-static inline __pure __nonulls void * __next(const ring_buffer buf,
-	                                     const void * addr)
+/* Copy `count` blocks from `src` into the ring starting at counter `start`.
+ * The copy is split into at most two contiguous spans around the end of the
+ * data region. */
+static __nonulls void __copy_to_ring(const ring_buffer buf,
+				     const size_t start,
+				     const void * src,
+				     const size_t count)
 {
-	size_t start;
-	size_t offset;
+	size_t first;
 
-	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
-	 * Cast all our pointers to size_t integers before doing arithmetic. */
-	size_t data = (size_t) DS_PRIV(buf)->data;
-	size_t mark = (size_t) addr;
+	first = __span(buf, start, count);
+	memcpy(__count_to_addr(buf, start), src, first * DS_DATA_SIZE(buf));
+	memcpy(DS_PRIV(buf)->data,
+	       (const uint8_t *) src + first * DS_DATA_SIZE(buf),
+	       (count - first) * DS_DATA_SIZE(buf));
+}
+
+/* Copy `count` blocks out of the ring starting at counter `start`. */
+static __nonulls void __copy_from_ring(const ring_buffer buf,
+				       const size_t start,
+				       void * dest,
+				       const size_t count)
+{
+	size_t first;
+
+	first = __span(buf, start, count);
+	memcpy(dest, __count_to_addr(buf, start), first * DS_DATA_SIZE(buf));
+	memcpy((uint8_t *) dest + first * DS_DATA_SIZE(buf),
+	       DS_PRIV(buf)->data,
+	       (count - first) * DS_DATA_SIZE(buf));
+}
+
+/* The locked buffer's writers bump `version` to an odd value before they
+ * modify it and back to an even value afterwards, so that readers can run
+ * without taking the lock: a reader that saw the same even `version` before
+ * and after reading is guaranteed not to have raced with a writer. */
+static inline __nonulls void __write_begin(ring_buffer buf)
+{
+	size_t version;
+
+	version = atomic_load_explicit(&DS_PRIV(buf)->version,
+				       memory_order_relaxed);
+	atomic_store_explicit(&DS_PRIV(buf)->version, version + 1,
+			      memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+static inline __nonulls void __write_end(ring_buffer buf)
+{
+	size_t version;
+
+	version = atomic_load_explicit(&DS_PRIV(buf)->version,
+				       memory_order_relaxed);
+	atomic_store_explicit(&DS_PRIV(buf)->version, version + 1,
+			      memory_order_release);
+}
+
+static inline __nonulls void __writer_entry(ring_buffer buf)
+{
+	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	__write_begin(buf);
+}
+
+static inline __nonulls void __writer_exit(ring_buffer buf)
+{
+	__write_end(buf);
+	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+}
+
+static inline __nonulls size_t __read_begin(const ring_buffer buf)
+{
+	size_t version;
+
+	while((version = atomic_load_explicit(&DS_PRIV(buf)->version,
+					      memory_order_acquire)) & 1)
+		sched_yield();
+
+	return version;
+}
+
+static inline __nonulls bool __read_retry(const ring_buffer buf,
+					  const size_t version)
+{
+	atomic_thread_fence(memory_order_acquire);
+	return (atomic_load_explicit(&DS_PRIV(buf)->version,
+				     memory_order_relaxed) != version);
+}
+
+/* Take a consistent snapshot of the head and length without the lock.
+ * Writers store to these with plain stores, so load them with relaxed atomic
+ * loads; any value torn by a concurrent writer is discarded by the retry. */
+static __nonulls size_t __optimistic_snapshot(const ring_buffer buf,
+					      size_t * head)
+{
+	size_t version;
+	size_t tail;
+
+	do {
+		version = __read_begin(buf);
+		*head = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_RELAXED);
+		tail  = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_RELAXED);
+	} while(__read_retry(buf, version));
+
+	return tail - *head;
+}
+
+static __nonulls bool __optimistic_fetch(const ring_buffer buf,
+					 const ssize_t relative,
+					 void * data)
+{
+	size_t version;
+	size_t head;
+	size_t length;
+
+	/* The block is copied straight out of the ring; if a writer got in the
+	 * way, the copy may be torn, so it is thrown away and taken again. */
+	do {
+		version = __read_begin(buf);
+		head   = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_RELAXED);
+		length = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_RELAXED);
+		length -= head;
+
+		if(length > 0 && length <= __capacity(buf)) {
+			size_t index = mod(relative, (ssize_t) length);
+
+			memcpy(data, __count_to_addr(buf, head + index),
+			       DS_DATA_SIZE(buf));
+		}
+	} while(__read_retry(buf, version));
 
-	start = mark - data;
-	offset = (start + DS_DATA_SIZE(buf)) % DS_ENTRIES(buf);
-	return (void *) (data + offset);
+	if(length == 0)
+		return_with_errno(EFAULT, false);
+
+	return true;
 }
 
 #define INDEX_ABS(buf, relative) \
 	(__is_empty(buf)) ? 0 : mod(relative, (ssize_t) __length(buf))
 
-static __nonulls bool __push_head(ring_buffer buf, const void * data)
+static inline __pure size_t __round_pow2(const size_t n)
 {
-	if(!DS_OVERWRITE(buf) && __is_full(buf))
-		return_with_errno(ENOBUFS, false);
+	size_t pow2 = 1;
+
+	while(pow2 < n)
+		pow2 <<= 1;
+
+	return pow2;
+}
+
+/* The locked head and tail counters start halfway through their range, at a
+ * multiple of the capacity, so that pushing onto the head can move them
+ * backwards without wrapping past zero (which would throw off `%`). */
+static inline __pure size_t __counter_base(const size_t capacity)
+{
+	return (SIZE_MAX / 2) - (SIZE_MAX / 2) % capacity;
+}
+
+static __nonulls void __set_capacity(ring_buffer buf, const size_t capacity)
+{
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	priv->capacity = capacity;
+	priv->mask = 0;
+	if((capacity & (capacity - 1)) == 0)
+		priv->mask = capacity - 1;
+
+	priv->head = __counter_base(capacity);
+	priv->tail = priv->head;
+}
+
+/* Describe the `count` slots starting at counter `start` as at most two I/O
+ * vectors, split where the run wraps around the end of the data region. */
+static __nonulls int __ring_iov(const ring_buffer buf,
+				const size_t start,
+				const size_t count,
+				struct iovec * iov)
+{
+	size_t first;
+
+	first = __span(buf, start, count);
+	iov[0].iov_base = __count_to_addr(buf, start);
+	iov[0].iov_len  = first * DS_DATA_SIZE(buf);
+	if(first == count)
+		return 1;
+
+	iov[1].iov_base = __count_to_addr(buf, start + first);
+	iov[1].iov_len  = (count - first) * DS_DATA_SIZE(buf);
+	return 2;
+}
+
+static inline __pure bool __is_growable(const ring_buffer buf)
+{
+	return DS_PROPS(buf)->growable;
+}
+
+/* Add to a telemetry counter which has a single writer at a time, either the
+ * holder of the writer lock or the one lock-free producer; a relaxed load and
+ * store suffice, and concurrent readers never see a torn value. */
+static inline void __count(atomic_size_t * counter, const size_t n)
+{
+	atomic_store_explicit(counter,
+			      atomic_load_explicit(counter,
+						   memory_order_relaxed) + n,
+			      memory_order_relaxed);
+}
+
+/* Count blocks which did not fit.  Several `DS_MPMC` producers may fail at
+ * once, but this is never on the path of a successful push. */
+static inline __nonulls void __count_failed(ring_buffer buf, const size_t n)
+{
+	if(n)
+		atomic_fetch_add_explicit(&__ctl(buf)->failed, n,
+					  memory_order_relaxed);
+}
+
+/* Account for `n` blocks pushed onto a locked buffer which held `length`
+ * blocks before; in `overwrite` mode, any that did not add to the length
+ * replaced older blocks. */
+static inline __nonulls void __count_pushes(ring_buffer buf,
+					    const size_t length,
+					    const size_t n)
+{
+	__count(&DS_PRIV(buf)->pushes, n);
+	__count(&DS_PRIV(buf)->overwrites, length + n - __length(buf));
+}
+
+static inline __nonulls void __count_edit(ring_buffer buf)
+{
+	__count(&DS_PRIV(buf)->edits, 1);
+}
+
+/* Move the contents of `buf` into a new data region of `capacity` slots.
+ * The contents are unwrapped on the way, so this takes at most two copies and
+ * leaves the free slots in one contiguous run after the tail. */
+static __nonulls bool __reshape(ring_buffer buf, const size_t capacity)
+{
+	void * data;
+	size_t length;
+
+	data = malloc(capacity * DS_DATA_SIZE(buf));
+	if(!data)
+		return_with_errno(ENOMEM, false);
 
-	DS_PRIV(buf)->head = __prev(buf, DS_PRIV(buf)->head);
-	memcpy(DS_PRIV(buf)->head, data, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->length = MIN(DS_PRIV(buf)->length + 1, DS_ENTRIES(buf));
+	length = __length(buf);
+	__copy_from_ring(buf, DS_PRIV(buf)->head, data, length);
+	free(DS_PRIV(buf)->data);
+	__count_edit(buf);
+
+	DS_PRIV(buf)->data = data;
+	__set_capacity(buf, capacity);
+	DS_PRIV(buf)->tail += length;
 
 	return true;
 }
 
-static __nonulls bool __push_tail(ring_buffer buf, const void * data)
+/* Ensure there are at least `n` free slots in `buf`, growing it if it is
+ * growable.  The capacity is at least doubled so that growth is amortized. */
+static __nonulls bool __make_room(ring_buffer buf, const size_t n)
 {
-	if(!DS_OVERWRITE(buf) && __is_full(buf))
+	size_t capacity;
+
+	if(__capacity(buf) - __length(buf) >= n)
+		return true;
+	if(!__is_growable(buf))
 		return_with_errno(ENOBUFS, false);
 
-	memcpy(DS_PRIV(buf)->tail, data, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->tail = __next(buf, DS_PRIV(buf)->tail);
-	DS_PRIV(buf)->length = MIN(DS_PRIV(buf)->length + 1, DS_ENTRIES(buf));
+	capacity = MAX(2 * __capacity(buf), __length(buf) + n);
+	if(DS_PROPS(buf)->power_of_two)
+		capacity = __round_pow2(capacity);
+
+	return __reshape(buf, capacity);
+}
+
+static __nonulls bool __push_head(ring_buffer buf, const void * data)
+{
+	size_t length = __length(buf);
+
+	if(!__make_room(buf, 1)) {
+		if(!DS_OVERWRITE(buf)) {
+			__count_failed(buf, 1);
+			return false;
+		}
+
+		/* Drop the block at the tail to make room. */
+		DS_PRIV(buf)->tail--;
+	}
+
+	DS_PRIV(buf)->head--;
+	memcpy(__count_to_addr(buf, DS_PRIV(buf)->head), data,
+	       DS_DATA_SIZE(buf));
 
+	__count_pushes(buf, length, 1);
+	__count_edit(buf);
 	return true;
 }
 
-static __nonulls void * __pop_head(ring_buffer buf)
+static __nonulls bool __push_tail(ring_buffer buf, const void * data)
 {
-	void * data;
+	size_t length = __length(buf);
 
-	if(__is_empty(buf))
-		return_with_errno(EFAULT, NULL);
+	if(!__make_room(buf, 1)) {
+		if(!DS_OVERWRITE(buf)) {
+			__count_failed(buf, 1);
+			return false;
+		}
 
-	data = malloc(DS_DATA_SIZE(buf));
-	if(!data)
-		return_with_errno(ENOMEM, NULL);
+		/* Drop the block at the head to make room. */
+		DS_PRIV(buf)->head++;
+	}
 
-	memcpy(data, DS_PRIV(buf)->head, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->head = __next(buf, DS_PRIV(buf)->head);
-	DS_PRIV(buf)->length--;
+	memcpy(__count_to_addr(buf, DS_PRIV(buf)->tail), data,
+	       DS_DATA_SIZE(buf));
+	DS_PRIV(buf)->tail++;
 
-	return data;
+	__count_pushes(buf, length, 1);
+	return true;
 }
 
-static __nonulls void * __pop_tail(ring_buffer buf)
+static __nonulls bool __pop_head(ring_buffer buf, void * data)
 {
-	void * data;
+	if(__is_empty(buf))
+		return_with_errno(EFAULT, false);
+
+	memcpy(data, __count_to_addr(buf, DS_PRIV(buf)->head),
+	       DS_DATA_SIZE(buf));
+	DS_PRIV(buf)->head++;
+
+	__count(&DS_PRIV(buf)->pops, 1);
+	return true;
+}
 
+static __nonulls bool __pop_tail(ring_buffer buf, void * data)
+{
 	if(__is_empty(buf))
-		return_with_errno(EFAULT, NULL);
+		return_with_errno(EFAULT, false);
 
-	data = malloc(DS_DATA_SIZE(buf));
-	if(!data)
-		return_with_errno(ENOMEM, NULL);
+	DS_PRIV(buf)->tail--;
+	memcpy(data, __count_to_addr(buf, DS_PRIV(buf)->tail),
+	       DS_DATA_SIZE(buf));
+
+	__count(&DS_PRIV(buf)->pops, 1);
+	__count_edit(buf);
+	return true;
+}
+
+static __nonulls size_t __push_head_n(ring_buffer buf,
+				      const void * data,
+				      const size_t n)
+{
+	size_t count;
+	size_t length = __length(buf);
+
+	if(DS_OVERWRITE(buf)) {
+		count = MIN(n, __capacity(buf));
+	} else {
+		__make_room(buf, n);
+		count = MIN(n, __capacity(buf) - __length(buf));
+	}
+	if(count == 0 && n > 0) {
+		__count_failed(buf, n);
+		return_with_errno(ENOBUFS, 0);
+	}
+
+	/* The block is prepended as a whole, so it keeps its order. */
+	DS_PRIV(buf)->head -= count;
+	__copy_to_ring(buf, DS_PRIV(buf)->head, data, count);
 
-	DS_PRIV(buf)->tail = __prev(buf, DS_PRIV(buf)->tail);
-	memcpy(data, DS_PRIV(buf)->tail, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->length--;
+	/* Drop any blocks at the tail that were overwritten. */
+	if(__length(buf) > __capacity(buf))
+		DS_PRIV(buf)->tail = DS_PRIV(buf)->head + __capacity(buf);
 
-	return data;
+	if(!DS_OVERWRITE(buf)) {
+		__count_failed(buf, n - count);
+		__count_pushes(buf, length, count);
+	} else {
+		__count_pushes(buf, length, n);
+	}
+	__count_edit(buf);
+
+	return DS_OVERWRITE(buf) ? n : count;
 }
 
-static void * __shift_forward(const ring_buffer buf,
-			      const size_t start,
-			      const size_t end)
+static __nonulls size_t __push_tail_n(ring_buffer buf,
+				      const void * data,
+				      const size_t n)
 {
-	void * dest;
-	void * front;
-	void * src;
+	size_t count;
+	size_t length = __length(buf);
+
+	if(DS_OVERWRITE(buf)) {
+		count = MIN(n, __capacity(buf));
+	} else {
+		__make_room(buf, n);
+		count = MIN(n, __capacity(buf) - __length(buf));
+	}
+	if(count == 0 && n > 0) {
+		__count_failed(buf, n);
+		return_with_errno(ENOBUFS, 0);
+	}
+
+	/* When overwriting, only the last `count` blocks of `data` would
+	 * survive pushing all `n` of them one at a time. */
+	if(DS_OVERWRITE(buf))
+		data = (const uint8_t *) data + (n - count) * DS_DATA_SIZE(buf);
 
-	front = dest = __prev(buf, __index_to_addr(buf, start));
-	for(ssize_t i = start; i <= end; i++) {
-		src = __index_to_addr(buf, i);
-		memcpy(dest, src, DS_DATA_SIZE(buf));
-		dest = src;
+	__copy_to_ring(buf, DS_PRIV(buf)->tail, data, count);
+	DS_PRIV(buf)->tail += count;
+
+	/* Drop any blocks at the head that were overwritten. */
+	if(__length(buf) > __capacity(buf))
+		DS_PRIV(buf)->head = DS_PRIV(buf)->tail - __capacity(buf);
+
+	if(!DS_OVERWRITE(buf)) {
+		__count_failed(buf, n - count);
+		__count_pushes(buf, length, count);
+	} else {
+		__count_pushes(buf, length, n);
 	}
 
-	return front;
+	return DS_OVERWRITE(buf) ? n : count;
+}
+
+static __nonulls size_t __pop_head_n(ring_buffer buf,
+				     void * data,
+				     const size_t n)
+{
+	size_t count;
+
+	count = MIN(n, __length(buf));
+	if(count == 0 && n > 0)
+		return_with_errno(EFAULT, 0);
+
+	__copy_from_ring(buf, DS_PRIV(buf)->head, data, count);
+	DS_PRIV(buf)->head += count;
+
+	__count(&DS_PRIV(buf)->pops, count);
+	return count;
 }
 
-static void * __shift_backward(const ring_buffer buf,
-			       const size_t start,
-			       const size_t end)
+static __nonulls size_t __pop_tail_n(ring_buffer buf,
+				     void * data,
+				     const size_t n)
 {
-	void * back;
-	void * dest;
-	void * src;
+	size_t count;
+
+	count = MIN(n, __length(buf));
+	if(count == 0 && n > 0)
+		return_with_errno(EFAULT, 0);
+
+	DS_PRIV(buf)->tail -= count;
+	__copy_from_ring(buf, DS_PRIV(buf)->tail, data, count);
+
+	__count(&DS_PRIV(buf)->pops, count);
+	__count_edit(buf);
+	return count;
+}
 
-	back = dest = __next(buf, __index_to_addr(buf, end));
-	for(ssize_t i = end; i >= start; i--) {
-		src = __index_to_addr(buf, i);
-		memcpy(dest, src, DS_DATA_SIZE(buf));
-		dest = src;
+/* Move the blocks at indices `start..end-1` one slot towards the head.
+ *
+ * The blocks are moved as whole contiguous segments, in order from the head
+ * end so that no block is overwritten before it has been moved.  Only the
+ * block in slot `0` has to wrap around to the last slot, so this takes at most
+ * three memmove() calls. */
+static void __shift_forward(const ring_buffer buf,
+			    const size_t start,
+			    const size_t end)
+{
+	size_t count = DS_PRIV(buf)->head + start;
+	size_t n = end - start;
+
+	while(n > 0) {
+		size_t slot = __slot(buf, count);
+		size_t len;
+
+		if(slot == 0) {
+			memcpy(__slot_addr(buf, __capacity(buf) - 1),
+			       __slot_addr(buf, 0),
+			       DS_DATA_SIZE(buf));
+			len = 1;
+		} else {
+			len = MIN(n, __capacity(buf) - slot);
+			memmove(__slot_addr(buf, slot - 1),
+				__slot_addr(buf, slot),
+				len * DS_DATA_SIZE(buf));
+		}
+
+		count += len;
+		n -= len;
 	}
+}
 
-	return back;
+/* Move the blocks at indices `start..end-1` one slot towards the tail.
+ *
+ * This mirrors __shift_forward(), working from the tail end instead. */
+static void __shift_backward(const ring_buffer buf,
+			     const size_t start,
+			     const size_t end)
+{
+	size_t count = DS_PRIV(buf)->head + end;
+	size_t n = end - start;
+
+	while(n > 0) {
+		size_t slot = __slot(buf, count - 1);
+		size_t len;
+
+		if(slot == __capacity(buf) - 1) {
+			memcpy(__slot_addr(buf, 0),
+			       __slot_addr(buf, slot),
+			       DS_DATA_SIZE(buf));
+			len = 1;
+		} else {
+			len = MIN(n, slot + 1);
+			memmove(__slot_addr(buf, slot + 2 - len),
+				__slot_addr(buf, slot + 1 - len),
+				len * DS_DATA_SIZE(buf));
+		}
+
+		count -= len;
+		n -= len;
+	}
 }
 
 static void __open_gap(ring_buffer buf,
 	               const size_t index)
 {
-	size_t end;
-	void * mark;
+	size_t length;
 
-	end = DS_PRIV(buf)->length - 1;
-	if(index <= (end - index)) {
-		mark = __shift_forward(buf, 0, index);
-		DS_PRIV(buf)->head = mark;
+	/* Shift whichever side of `index` has fewer blocks. */
+	length = __length(buf);
+	if(index <= (length - index)) {
+		__shift_forward(buf, 0, index);
+		DS_PRIV(buf)->head--;
 	} else {
-		mark = __shift_backward(buf, index, end);
-		DS_PRIV(buf)->tail = __next(buf, mark);
+		__shift_backward(buf, index, length);
+		DS_PRIV(buf)->tail++;
 	}
-
-	(DS_PRIV(buf)->length)++;
 }
 
 static __nonulls bool __insert(ring_buffer buf,
@@ -226,10 +657,13 @@ static __nonulls bool __insert(ring_buffer buf,
 			       const ssize_t relative)
 {
 	size_t absolute;
+	size_t length = __length(buf);
 	void * addr;
 
-	if(!DS_OVERWRITE(buf) && __is_full(buf))
-		return_with_errno(ENOBUFS, false);
+	if(!DS_OVERWRITE(buf) && !__make_room(buf, 1)) {
+		__count_failed(buf, 1);
+		return false;
+	}
 
 	absolute = INDEX_ABS(buf, relative);
 	if(!DS_OVERWRITE(buf))
@@ -238,165 +672,1949 @@ static __nonulls bool __insert(ring_buffer buf,
 	addr = __index_to_addr(buf, absolute);
 	memcpy(addr, data, DS_DATA_SIZE(buf));
 
+	__count_pushes(buf, length, 1);
+	__count_edit(buf);
 	return true;
 }
 
-static void * __pure __nonulls __fetch(const ring_buffer buf,
-	                               const ssize_t relative)
+static __nonulls void * __peek(const ring_buffer buf,
+			       const ssize_t relative,
+			       size_t * span)
 {
-	void * addr;
-	void * data;
+	size_t index;
 
 	if(__is_empty(buf))
 		return_with_errno(EFAULT, NULL);
 
-	data = malloc(DS_DATA_SIZE(buf));
-	if(!data)
-		return_with_errno(ENOMEM, NULL);
-
-	addr = __index_to_addr(buf, INDEX_ABS(buf, relative));
-	memcpy(data, addr, DS_DATA_SIZE(buf));
-	return data;
+	index = INDEX_ABS(buf, relative);
+	*span = __span(buf, DS_PRIV(buf)->head + index, __length(buf) - index);
+	return __index_to_addr(buf, index);
 }
 
-ring_buffer rb_create(const struct ds_properties * props)
+/* Reserve up to `*n` free slots at the tail for the caller to fill in place,
+ * limited to the run that is contiguous in memory. */
+static __nonulls void * __reserve_tail(ring_buffer buf, size_t * n)
 {
-	ring_buffer buf;
-	struct ring_buffer_priv * priv;
+	size_t count;
+	size_t tail;
+
+	/* Optimistic readers cannot see the reserved slots being filled, but
+	 * growing moves every block and resets `head` and `tail`, so that much
+	 * is marked as a write. */
+	__write_begin(buf);
+	__make_room(buf, *n);
+	__write_end(buf);
+
+	tail = DS_PRIV(buf)->tail;
+	count = MIN(*n, __span(buf, tail, __capacity(buf) - __length(buf)));
+	if(count == 0) {
+		__count_failed(buf, *n);
+		return_with_errno(ENOBUFS, NULL);
+	}
 
-	DS_ALLOC(buf);
-	if(!buf)
-		return_with_errno(ENOMEM, NULL);
+	__ctl(buf)->reserved = count;
+	*n = count;
+	return __count_to_addr(buf, tail);
+}
 
-	DS_INIT(buf, props, &mgmt_ops, &hof_ops);
+static __nonulls bool __commit_tail(ring_buffer buf, const size_t n)
+{
+	size_t reserved = __ctl(buf)->reserved;
 
-	/* Set up private data section. */
-	priv = DS_PRIV(buf);
-	priv->data = malloc(__space(buf));
-	if(!priv->data)
-		goto_with_errno(ENOMEM, exit);
+	__ctl(buf)->reserved = 0;
+	if(n > reserved)
+		return_with_errno(EINVAL, false);
 
-	priv->head = priv->data;
-	priv->tail = priv->data;
-	priv->length = 0;
+	DS_PRIV(buf)->tail += n;
+	__count(&DS_PRIV(buf)->pushes, n);
+	return true;
+}
 
-	if(rwlock_alloc(&priv->rwlock) < 0)
-		goto_with_errno(errno, exit);
+/* Acquire up to `*n` stored blocks at the head for the caller to read in
+ * place, limited to the run that is contiguous in memory. */
+static __nonulls void * __acquire_head(ring_buffer buf, size_t * n)
+{
+	size_t count;
+	size_t head;
 
-	return buf;
+	head = DS_PRIV(buf)->head;
+	count = MIN(*n, __span(buf, head, __length(buf)));
+	if(count == 0)
+		return_with_errno(EFAULT, NULL);
 
-exit:
-	rb_destroy(&buf);
-	return NULL;
+	__ctl(buf)->acquired = count;
+	*n = count;
+	return __count_to_addr(buf, head);
 }
 
-void rb_destroy(ring_buffer * buf)
+static __nonulls bool __release_head(ring_buffer buf, const size_t n)
 {
-	/* Destroy the private data section. */
-	free_null(DS_PRIV(*buf)->data);
-	rwlock_free(&DS_PRIV(*buf)->rwlock);
+	size_t acquired = __ctl(buf)->acquired;
 
-	/* Deallocate the data structure. */
-	DS_FREE(buf);
+	__ctl(buf)->acquired = 0;
+	if(n > acquired)
+		return_with_errno(EINVAL, false);
+
+	DS_PRIV(buf)->head += n;
+	__count(&DS_PRIV(buf)->pops, n);
+	return true;
 }
 
-size_t rb_size(const ring_buffer buf)
+static inline __pure bool __is_spsc(const ring_buffer buf)
 {
-	size_t size;
-
-	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
-	size = __length(buf);
-	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
-
-	return size;
+	return (DS_CONCURRENCY(buf) == DS_SPSC);
 }
 
-bool rb_empty(const ring_buffer buf)
+static inline __pure bool __is_mpmc(const ring_buffer buf)
 {
-	bool success;
+	return (DS_CONCURRENCY(buf) == DS_MPMC);
+}
 
-	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
-	success = __is_empty(buf);
-	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+static inline __pure bool __is_broadcast(const ring_buffer buf)
+{
+	return (DS_CONCURRENCY(buf) == DS_BROADCAST);
+}
 
-	return success;
+static inline __pure bool __is_lockfree(const ring_buffer buf)
+{
+	return (DS_CONCURRENCY(buf) != DS_LOCKED);
 }
 
-bool rb_full(const ring_buffer buf)
+/* Find the cursor of the slowest reader of a broadcast buffer, or `write` if
+ * no reader is attached.  Cursors are compared by their distance behind
+ * `write`, since a reader may have moved past `write` since it was loaded.
+ * This is the one place a broadcast buffer blocks: the reader lock keeps the
+ * list from changing under the scan, so it waits out an attach or detach. */
+static __nonulls size_t __broadcast_min(const ring_buffer buf,
+					const size_t write)
 {
-	bool success;
+	size_t min = write;
 
 	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
-	success = __is_full(buf);
+	for(rb_reader r = DS_PRIV(buf)->readers; r; r = r->next) {
+		size_t cursor = atomic_load_explicit(&r->cursor,
+						     memory_order_acquire);
+
+		if((ssize_t) (write - cursor) > (ssize_t) (write - min))
+			min = cursor;
+	}
 	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
 
-	return success;
+	return min;
 }
 
-bool rb_push_head(ring_buffer buf, const void * data)
+static inline __nonulls size_t __lockfree_length(const ring_buffer buf)
 {
-	bool success;
-
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	success = __push_head(buf, data);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	size_t read;
+	size_t write;
+
+	/* Load `read` first: `write` never falls behind `read`, so the
+	 * difference can never appear negative.  With several consumers,
+	 * `read` may move on between the loads and overstate the length. */
+	if(__is_broadcast(buf)) {
+		write = atomic_load_explicit(&__ctl(buf)->write,
+					     memory_order_acquire);
+		read  = __broadcast_min(buf, write);
+		return ((ssize_t) (write - read) < 0) ? 0 :
+			MIN(write - read, __capacity(buf));
+	}
 
-	return success;
+	read  = atomic_load_explicit(&__ctl(buf)->read, memory_order_acquire);
+	write = atomic_load_explicit(&__ctl(buf)->write, memory_order_acquire);
+	return MIN(write - read, __capacity(buf));
 }
 
-bool rb_push_tail(ring_buffer buf, const void * data)
+/* Determine how many slots the producer may fill, starting at `write`.  The
+ * consumer's `read` is only reloaded, acquiring the slots it has finished
+ * with, when the cached copy shows fewer than `want` free slots. */
+static inline __nonulls size_t __spsc_free(ring_buffer buf,
+					   const size_t write,
+					   const size_t want)
 {
-	bool success;
+	size_t read = __ctl(buf)->read_cache;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	success = __push_tail(buf, data);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	if(__capacity(buf) - (write - read) < want) {
+		read = atomic_load_explicit(&__ctl(buf)->read,
+					    memory_order_acquire);
+		__ctl(buf)->read_cache = read;
+	}
 
-	return success;
+	return __capacity(buf) - (write - read);
 }
 
-void * rb_pop_head(ring_buffer buf)
+/* Determine how many blocks the consumer may read, starting at `read`.  The
+ * producer's `write` is only reloaded when the cached copy shows fewer than
+ * `want` stored blocks. */
+static inline __nonulls size_t __spsc_used(ring_buffer buf,
+					   const size_t read,
+					   const size_t want)
 {
-	void * data;
+	size_t write = __ctl(buf)->write_cache;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	data = __pop_head(buf);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	if(write - read < want) {
+		write = atomic_load_explicit(&__ctl(buf)->write,
+					     memory_order_acquire);
+		__ctl(buf)->write_cache = write;
+	}
 
-	return data;
+	return write - read;
 }
 
-void * rb_pop_tail(ring_buffer buf)
+static __nonulls bool __spsc_push_tail(ring_buffer buf, const void * data)
 {
-	void * data;
+	size_t write;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	data = __pop_tail(buf);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	/* The producer owns `write`, so it can be loaded relaxed. */
+	write = atomic_load_explicit(&__ctl(buf)->write, memory_order_relaxed);
+	if(__spsc_free(buf, write, 1) == 0) {
+		__count_failed(buf, 1);
+		return_with_errno(ENOBUFS, false);
+	}
 
-	return data;
+	memcpy(__count_to_addr(buf, write), data, DS_DATA_SIZE(buf));
+	atomic_store_explicit(&__ctl(buf)->write, write + 1,
+			      memory_order_release);
+
+	return true;
+}
+
+static __nonulls bool __spsc_pop_head(ring_buffer buf, void * data)
+{
+	size_t read;
+
+	read = atomic_load_explicit(&__ctl(buf)->read, memory_order_relaxed);
+	if(__spsc_used(buf, read, 1) == 0)
+		return_with_errno(EFAULT, false);
+
+	memcpy(data, __count_to_addr(buf, read), DS_DATA_SIZE(buf));
+	atomic_store_explicit(&__ctl(buf)->read, read + 1,
+			      memory_order_release);
+
+	return true;
+}
+
+static __nonulls size_t __spsc_push_tail_n(ring_buffer buf,
+					   const void * data,
+					   const size_t n)
+{
+	size_t count;
+	size_t write;
+
+	write = atomic_load_explicit(&__ctl(buf)->write, memory_order_relaxed);
+	count = MIN(n, __spsc_free(buf, write, n));
+	__count_failed(buf, n - count);
+	if(count == 0 && n > 0)
+		return_with_errno(ENOBUFS, 0);
+
+	__copy_to_ring(buf, write, data, count);
+	atomic_store_explicit(&__ctl(buf)->write, write + count,
+			      memory_order_release);
+
+	return count;
+}
+
+static __nonulls size_t __spsc_pop_head_n(ring_buffer buf,
+					  void * data,
+					  const size_t n)
+{
+	size_t count;
+	size_t read;
+
+	read  = atomic_load_explicit(&__ctl(buf)->read, memory_order_relaxed);
+	count = MIN(n, __spsc_used(buf, read, n));
+	if(count == 0 && n > 0)
+		return_with_errno(EFAULT, 0);
+
+	__copy_from_ring(buf, read, data, count);
+	atomic_store_explicit(&__ctl(buf)->read, read + count,
+			      memory_order_release);
+
+	return count;
+}
+
+static __nonulls void * __spsc_peek(const ring_buffer buf,
+				    const ssize_t relative,
+				    size_t * span)
+{
+	size_t read;
+	size_t length;
+	size_t index;
+
+	/* Only the consumer may peek, so the slot cannot be reused by the
+	 * producer until the consumer advances `read` itself.  Indices are
+	 * relative to the current length, so always reload `write`. */
+	read   = atomic_load_explicit(&__ctl(buf)->read, memory_order_relaxed);
+	length = __spsc_used(buf, read, SIZE_MAX);
+	if(length == 0)
+		return_with_errno(EFAULT, NULL);
+
+	index = mod(relative, (ssize_t) length);
+	*span = __span(buf, read + index, length - index);
+	return __count_to_addr(buf, read + index);
+}
+
+static __nonulls void * __spsc_reserve_tail(ring_buffer buf, size_t * n)
+{
+	size_t count;
+	size_t write;
+
+	write = atomic_load_explicit(&__ctl(buf)->write, memory_order_relaxed);
+	count = MIN(*n, __span(buf, write, __spsc_free(buf, write, *n)));
+	if(count == 0) {
+		__count_failed(buf, *n);
+		return_with_errno(ENOBUFS, NULL);
+	}
+
+	__ctl(buf)->reserved = count;
+	*n = count;
+	return __count_to_addr(buf, write);
+}
+
+static __nonulls bool __spsc_commit_tail(ring_buffer buf, const size_t n)
+{
+	size_t reserved = __ctl(buf)->reserved;
+
+	__ctl(buf)->reserved = 0;
+	if(n > reserved)
+		return_with_errno(EINVAL, false);
+
+	/* Publish the blocks written in place by the producer. */
+	atomic_fetch_add_explicit(&__ctl(buf)->write, n, memory_order_release);
+	return true;
+}
+
+static __nonulls void * __spsc_acquire_head(ring_buffer buf, size_t * n)
+{
+	size_t count;
+	size_t read;
+
+	read  = atomic_load_explicit(&__ctl(buf)->read, memory_order_relaxed);
+	count = MIN(*n, __span(buf, read, __spsc_used(buf, read, *n)));
+	if(count == 0)
+		return_with_errno(EFAULT, NULL);
+
+	__ctl(buf)->acquired = count;
+	*n = count;
+	return __count_to_addr(buf, read);
+}
+
+static __nonulls bool __spsc_release_head(ring_buffer buf, const size_t n)
+{
+	size_t acquired = __ctl(buf)->acquired;
+
+	__ctl(buf)->acquired = 0;
+	if(n > acquired)
+		return_with_errno(EINVAL, false);
+
+	/* Hand the slots back only after the consumer is done reading them. */
+	atomic_fetch_add_explicit(&__ctl(buf)->read, n, memory_order_release);
+	return true;
+}
+
+static __nonulls bool __mpmc_push_tail(ring_buffer buf, const void * data)
+{
+	size_t seq;
+	size_t write;
+	ssize_t diff;
+	atomic_size_t * slot;
+
+	write = atomic_load_explicit(&__ctl(buf)->write, memory_order_relaxed);
+	for(;;) {
+		slot = &DS_PRIV(buf)->seq[__slot(buf, write)];
+		seq  = atomic_load_explicit(slot, memory_order_acquire);
+		diff = (ssize_t) (seq - write);
+
+		if(diff == 0) {
+			/* The slot is free; try to claim it.  On failure
+			 * `write` is reloaded with the current counter. */
+			if(atomic_compare_exchange_weak_explicit(
+				   &__ctl(buf)->write, &write, write + 1,
+				   memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if(diff < 0) {
+			/* The slot still holds data from the previous lap. */
+			__count_failed(buf, 1);
+			return_with_errno(ENOBUFS, false);
+		} else {
+			/* Another producer claimed this slot first. */
+			write = atomic_load_explicit(&__ctl(buf)->write,
+						     memory_order_relaxed);
+		}
+	}
+
+	memcpy(__count_to_addr(buf, write), data, DS_DATA_SIZE(buf));
+	atomic_store_explicit(slot, write + 1, memory_order_release);
+
+	return true;
+}
+
+static __nonulls bool __mpmc_pop_head(ring_buffer buf, void * data)
+{
+	size_t seq;
+	size_t read;
+	ssize_t diff;
+	atomic_size_t * slot;
+
+	read = atomic_load_explicit(&__ctl(buf)->read, memory_order_relaxed);
+	for(;;) {
+		slot = &DS_PRIV(buf)->seq[__slot(buf, read)];
+		seq  = atomic_load_explicit(slot, memory_order_acquire);
+		diff = (ssize_t) (seq - (read + 1));
+
+		if(diff == 0) {
+			if(atomic_compare_exchange_weak_explicit(
+				   &__ctl(buf)->read, &read, read + 1,
+				   memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if(diff < 0) {
+			/* No producer has published this slot yet. */
+			return_with_errno(EFAULT, false);
+		} else {
+			read = atomic_load_explicit(&__ctl(buf)->read,
+						    memory_order_relaxed);
+		}
+	}
+
+	memcpy(data, __count_to_addr(buf, read), DS_DATA_SIZE(buf));
+
+	/* Hand the slot to the producer that will claim it on the next lap. */
+	atomic_store_explicit(slot, read + __capacity(buf),
+			      memory_order_release);
+
+	return true;
+}
+
+/* Like __spsc_free(), but against the slowest reader.  The cached cursor can
+ * only be behind the real one, so using it never overwrites unread data. */
+static inline __nonulls size_t __broadcast_free(ring_buffer buf,
+						const size_t write,
+						const size_t want)
+{
+	size_t read = __ctl(buf)->read_cache;
+
+	if(__capacity(buf) - (write - read) < want) {
+		read = __broadcast_min(buf, write);
+		__ctl(buf)->read_cache = read;
+	}
+
+	return __capacity(buf) - (write - read);
+}
+
+static __nonulls size_t __broadcast_push_tail_n(ring_buffer buf,
+						const void * data,
+						const size_t n)
+{
+	size_t count;
+	size_t write;
+
+	write = atomic_load_explicit(&__ctl(buf)->write, memory_order_relaxed);
+	if(!DS_OVERWRITE(buf)) {
+		count = MIN(n, __broadcast_free(buf, write, n));
+		__count_failed(buf, n - count);
+		if(count == 0 && n > 0)
+			return_with_errno(ENOBUFS, 0);
+
+		__copy_to_ring(buf, write, data, count);
+		atomic_store_explicit(&__ctl(buf)->write, write + count,
+				      memory_order_release);
+
+		return count;
+	}
+
+	/* As for the locked buffer, only the last `count` blocks of `data`
+	 * would survive pushing all `n` of them one at a time.  The counter
+	 * still advances by `n`, so readers count the others as lost. */
+	count = MIN(n, __capacity(buf));
+	data = (const uint8_t *) data + (n - count) * DS_DATA_SIZE(buf);
+
+	/* Announce the slots being overwritten before touching them. */
+	atomic_store_explicit(&__ctl(buf)->claim, write + n,
+			      memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	__copy_to_ring(buf, write + n - count, data, count);
+	atomic_store_explicit(&__ctl(buf)->write, write + n,
+			      memory_order_release);
+
+	return n;
+}
+
+static __nonulls size_t __reader_pop_n(rb_reader reader,
+				       void * data,
+				       const size_t n)
+{
+	size_t count;
+	size_t claim;
+	size_t write;
+	size_t cursor;
+	ring_buffer buf = reader->buf;
+
+	cursor = atomic_load_explicit(&reader->cursor, memory_order_relaxed);
+	for(;;) {
+		write = atomic_load_explicit(&__ctl(buf)->write,
+					     memory_order_acquire);
+
+		/* Skip over anything the producer has lapped us on. */
+		if(write - cursor > __capacity(buf)) {
+			reader->lost += write - __capacity(buf) - cursor;
+			cursor = write - __capacity(buf);
+		}
+
+		count = MIN(n, write - cursor);
+		if(count == 0)
+			break;
+
+		__copy_from_ring(buf, cursor, data, count);
+		if(!DS_OVERWRITE(buf))
+			break;
+
+		/* The copy is only good if the producer did not start to
+		 * overwrite any of it in the meantime. */
+		atomic_thread_fence(memory_order_acquire);
+		claim = atomic_load_explicit(&__ctl(buf)->claim,
+					     memory_order_relaxed);
+		if(claim - cursor <= __capacity(buf))
+			break;
+
+		reader->lost += claim - __capacity(buf) - cursor;
+		cursor = claim - __capacity(buf);
+	}
+
+	atomic_store_explicit(&reader->cursor, cursor + count,
+			      memory_order_release);
+	if(count == 0 && n > 0)
+		return_with_errno(EFAULT, 0);
+
+	return count;
+}
+
+/* Wake any threads parked in rb_pop_head_wait() after `count` blocks were
+ * added to the buffer. */
+static inline __nonulls size_t __wake_consumers(const ring_buffer buf,
+						const size_t count)
+{
+	if(count)
+		waitq_wake(DS_PRIV(buf)->not_empty);
+
+	return count;
+}
+
+/* Wake any threads parked in rb_push_tail_wait() after `count` blocks were
+ * removed from the buffer. */
+static inline __nonulls size_t __wake_producers(const ring_buffer buf,
+						const size_t count)
+{
+	if(count)
+		waitq_wake(DS_PRIV(buf)->not_full);
+
+	return count;
+}
+
+static bool __not_empty(const void * buf)
+{
+	return !rb_empty((const ring_buffer) buf);
+}
+
+static bool __not_full(const void * buf)
+{
+	return !rb_full((const ring_buffer) buf);
+}
+
+static size_t __gcd(size_t a, size_t b)
+{
+	while(b) {
+		size_t t = a % b;
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+/* Map the data region twice, back to back, over one shared memory object so
+ * that the slots past the end of the region alias those at its start. */
+static __nonulls bool __map_mirrored(ring_buffer buf)
+{
+	int fd;
+	size_t space;
+	uint8_t * addr;
+
+	space = __space(buf);
+
+	fd = memfd_create("focs-ring-buffer", MFD_CLOEXEC);
+	if(fd < 0)
+		return false;
+
+	if(ftruncate(fd, space) < 0)
+		goto_with_errno(errno, close_fd);
+
+	/* Reserve enough address space for both copies first, so the second
+	 * mapping is guaranteed to land directly after the first. */
+	addr = mmap(NULL, 2 * space, PROT_NONE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(addr == MAP_FAILED)
+		goto_with_errno(errno, close_fd);
+
+	if(mmap(addr, space, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+		goto_with_errno(errno, unmap);
+	if(mmap(addr + space, space, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+		goto_with_errno(errno, unmap);
+
+	close(fd);
+
+	DS_PRIV(buf)->data = addr;
+	DS_PRIV(buf)->backing |= RB_BACKING_MIRRORED;
+	return true;
+
+unmap:
+	munmap(addr, 2 * space);
+close_fd:
+	close(fd);
+	return false;
+}
+
+static inline __pure size_t __round_up(const size_t n, const size_t align)
+{
+	return (n + align - 1) / align * align;
+}
+
+static inline __pure size_t __huge_size(const ring_buffer buf)
+{
+	return __round_up(__space(buf), RB_HUGEPAGE_SIZE);
+}
+
+static inline __pure bool __is_huge(const ring_buffer buf)
+{
+	return (DS_PRIV(buf)->backing &
+		(RB_BACKING_HUGETLB | RB_BACKING_HUGEPAGE));
+}
+
+/* The size of the data region's mapping, including the mirror. */
+static inline __pure size_t __mapped_size(const ring_buffer buf)
+{
+	return __is_mirrored(buf) ? 2 * __space(buf) : __space(buf);
+}
+
+/* Map the data region on huge pages, preferring explicit huge pages, which
+ * are only available if the administrator reserved some, and falling back to
+ * transparent huge pages. */
+static __nonulls bool __map_huge(ring_buffer buf)
+{
+	void * addr;
+	size_t size = __huge_size(buf);
+
+#ifdef MAP_HUGETLB
+	addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if(addr != MAP_FAILED) {
+		DS_PRIV(buf)->data = addr;
+		DS_PRIV(buf)->backing |= RB_BACKING_HUGETLB;
+		return true;
+	}
+#endif /* MAP_HUGETLB */
+
+#ifdef MADV_HUGEPAGE
+	addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(addr == MAP_FAILED)
+		return false;
+
+	if(madvise(addr, size, MADV_HUGEPAGE) == 0) {
+		DS_PRIV(buf)->data = addr;
+		DS_PRIV(buf)->backing |= RB_BACKING_HUGEPAGE;
+		return true;
+	}
+
+	munmap(addr, size);
+#endif /* MADV_HUGEPAGE */
+
+	return false;
+}
+
+/* Fault in and lock the data region as requested, so that the first lap
+ * around the buffer does not pay for it. */
+static __nonulls void __pin(ring_buffer buf)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	volatile uint8_t * data = DS_PRIV(buf)->data;
+
+	if(DS_PROPS(buf)->lock_memory &&
+	   mlock(DS_PRIV(buf)->data, __mapped_size(buf)) == 0)
+		DS_PRIV(buf)->backing |= RB_BACKING_LOCKED |
+			RB_BACKING_PREFAULTED;
+
+	/* Write to each page: reading would only map the shared zero page. */
+	if(DS_PROPS(buf)->prefault &&
+	   !(DS_PRIV(buf)->backing & RB_BACKING_PREFAULTED)) {
+		for(size_t off = 0; off < __mapped_size(buf); off += page)
+			data[off] = 0;
+
+		DS_PRIV(buf)->backing |= RB_BACKING_PREFAULTED;
+	}
+}
+
+/* Identifies a fully initialized shared memory object ("focsrb" and a layout
+ * version).  The cache line size is mixed in because it changes the layout. */
+#define RB_SHARED_MAGIC (0x666f637372620100ULL | RB_CACHELINE_SIZE)
+
+static __nonulls void __init_ctl(struct ring_buffer_shared * ctl)
+{
+	atomic_init(&ctl->read, 0);
+	atomic_init(&ctl->write, 0);
+	ctl->read_cache = 0;
+	ctl->write_cache = 0;
+	ctl->reserved = 0;
+	ctl->acquired = 0;
+	atomic_init(&ctl->failed, 0);
+	atomic_init(&ctl->claim, 0);
+}
+
+static __nonulls void __init_seq(ring_buffer buf)
+{
+	for(size_t i = 0; i < __capacity(buf); i++)
+		atomic_init(&DS_PRIV(buf)->seq[i], i);
+}
+
+/* Allocate a buffer and the parts of its state which are always private to
+ * the calling process.  The caller sets up the capacity and data region.
+ * `line_size` is the cache line size the caller was built with, which must
+ * match the library's for the two to agree on the buffer's layout. */
+static __nonulls ring_buffer __alloc(const struct ds_properties * props,
+				     size_t line_size)
+{
+	ring_buffer buf;
+	struct ring_buffer_priv * priv;
+
+	if(line_size != RB_CACHELINE_SIZE)
+		return_with_errno(EINVAL, NULL);
+
+	DS_ALLOC_ALIGNED(buf);
+	if(!buf)
+		return_with_errno(ENOMEM, NULL);
+
+	DS_INIT(buf, props, &mgmt_ops, &hof_ops);
+
+	/* Set up private data section. */
+	priv = DS_PRIV(buf);
+	priv->data = NULL;
+	priv->capacity = 0;
+	priv->backing = RB_BACKING_HEAP;
+	priv->seq = NULL;
+	priv->rwlock = NULL;
+	priv->not_empty = NULL;
+	priv->not_full = NULL;
+	priv->shared = &priv->local;
+	priv->readers = NULL;
+	__init_ctl(&priv->local);
+	atomic_init(&priv->version, 0);
+	atomic_init(&priv->pushes, 0);
+	atomic_init(&priv->pops, 0);
+	atomic_init(&priv->overwrites, 0);
+	atomic_init(&priv->edits, 0);
+
+	if(rwlock_alloc(&priv->rwlock) < 0)
+		goto_with_errno(ENOMEM, exit);
+	if(waitq_alloc(&priv->not_empty) < 0)
+		goto_with_errno(ENOMEM, exit);
+	if(waitq_alloc(&priv->not_full) < 0)
+		goto_with_errno(ENOMEM, exit);
+
+	return buf;
+
+exit:
+	rb_destroy(&buf);
+	return NULL;
+}
+
+ring_buffer __rb_create(const struct ds_properties * props, size_t line_size)
+{
+	ring_buffer buf;
+	size_t capacity;
+
+	if(props->entries == 0 || props->data_size == 0)
+		return_with_errno(EINVAL, NULL);
+	if((props->concurrency == DS_SPSC || props->concurrency == DS_MPMC) &&
+	   props->overwrite)
+		return_with_errno(EINVAL, NULL);
+	if(props->growable && (props->concurrency != DS_LOCKED ||
+			       props->overwrite || props->mirrored))
+		return_with_errno(EINVAL, NULL);
+
+	buf = __alloc(props, line_size);
+	if(!buf)
+		return NULL;
+
+	capacity = DS_ENTRIES(buf);
+	if(props->power_of_two)
+		capacity = __round_pow2(capacity);
+
+	/* The mirror can only be mapped in whole pages, so the data region
+	 * has to span a whole number of pages. */
+	if(props->mirrored) {
+		size_t page = sysconf(_SC_PAGESIZE);
+
+		capacity = __round_up(capacity,
+				      page / __gcd(page, DS_DATA_SIZE(buf)));
+	}
+
+	__set_capacity(buf, capacity);
+
+	if(props->mirrored) {
+		__map_mirrored(buf);
+	} else if(props->huge_pages && !props->growable) {
+		__map_huge(buf);
+	}
+
+	if(!DS_PRIV(buf)->data) {
+		DS_PRIV(buf)->data = malloc(__space(buf));
+		if(!DS_PRIV(buf)->data)
+			goto_with_errno(ENOMEM, exit);
+	}
+
+	if(!props->growable)
+		__pin(buf);
+
+	if(__is_mpmc(buf)) {
+		DS_PRIV(buf)->seq = malloc(capacity * sizeof(*DS_PRIV(buf)->seq));
+		if(!DS_PRIV(buf)->seq)
+			goto_with_errno(ENOMEM, exit);
+
+		__init_seq(buf);
+	}
+
+	return buf;
+
+exit:
+	rb_destroy(&buf);
+	return NULL;
+}
+
+/* Point `buf` at a shared memory object mapped at `addr`. */
+static __nonulls void __use_shared(ring_buffer buf, void * addr)
+{
+	struct ring_buffer_shared * ctl = addr;
+
+	DS_PRIV(buf)->shared = ctl;
+	DS_PRIV(buf)->backing = RB_BACKING_SHARED;
+	DS_PRIV(buf)->data = (uint8_t *) addr + ctl->data_offset;
+	if(ctl->concurrency == DS_MPMC)
+		DS_PRIV(buf)->seq = (void *) ((uint8_t *) addr + ctl->seq_offset);
+}
+
+ring_buffer __rb_create_shared(const char * name,
+			       const struct ds_properties * props,
+			       size_t line_size)
+{
+	int fd;
+	int err;
+	size_t size;
+	ring_buffer buf;
+	struct ring_buffer_shared * ctl;
+	struct ring_buffer_shared layout;
+
+	if(props->entries == 0 || props->data_size == 0)
+		return_with_errno(EINVAL, NULL);
+	if((props->concurrency != DS_SPSC && props->concurrency != DS_MPMC) ||
+	   props->overwrite || props->growable)
+		return_with_errno(EINVAL, NULL);
+
+	buf = __alloc(props, line_size);
+	if(!buf)
+		return NULL;
+
+	layout.data_size = DS_DATA_SIZE(buf);
+	layout.capacity = DS_ENTRIES(buf);
+	if(props->power_of_two)
+		layout.capacity = __round_pow2(layout.capacity);
+	layout.concurrency = props->concurrency;
+
+	/* The control block, the sequence numbers and the data each start on
+	 * their own cache line. */
+	layout.seq_offset = __round_up(sizeof(layout), RB_CACHELINE_SIZE);
+	layout.data_offset = layout.seq_offset;
+	if(layout.concurrency == DS_MPMC)
+		layout.data_offset += __round_up(layout.capacity *
+						 sizeof(atomic_size_t),
+						 RB_CACHELINE_SIZE);
+	size = layout.data_offset + layout.capacity * layout.data_size;
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(fd < 0)
+		goto_with_errno(errno, exit);
+
+	if(ftruncate(fd, size) < 0)
+		goto_with_errno(errno, unlink);
+
+	ctl = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(ctl == MAP_FAILED)
+		goto_with_errno(errno, unlink);
+	close(fd);
+
+	ctl->data_size   = layout.data_size;
+	ctl->capacity    = layout.capacity;
+	ctl->seq_offset  = layout.seq_offset;
+	ctl->data_offset = layout.data_offset;
+	ctl->concurrency = layout.concurrency;
+	__init_ctl(ctl);
+
+	__set_capacity(buf, ctl->capacity);
+	__use_shared(buf, ctl);
+	if(__is_mpmc(buf))
+		__init_seq(buf);
+
+	/* Publish the object to processes attaching to it. */
+	atomic_store_explicit(&ctl->magic, RB_SHARED_MAGIC,
+			      memory_order_release);
+
+	return buf;
+
+unlink:
+	err = errno;
+	close(fd);
+	shm_unlink(name);
+	errno = err;
+exit:
+	rb_destroy(&buf);
+	return NULL;
+}
+
+ring_buffer __rb_attach_shared(const char * name,
+			       const struct ds_properties * props,
+			       size_t line_size)
+{
+	int fd;
+	struct stat st;
+	ring_buffer buf;
+	struct ring_buffer_shared * ctl;
+
+	buf = __alloc(props, line_size);
+	if(!buf)
+		return NULL;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if(fd < 0)
+		goto_with_errno(errno, exit);
+
+	if(fstat(fd, &st) < 0) {
+		int err = errno;
+
+		close(fd);
+		goto_with_errno(err, exit);
+	}
+
+	/* The creator may not have sized the object yet. */
+	if((size_t) st.st_size < sizeof(*ctl)) {
+		close(fd);
+		goto_with_errno(EAGAIN, exit);
+	}
+
+	ctl = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(ctl == MAP_FAILED)
+		goto_with_errno(errno, exit);
+
+	if(atomic_load_explicit(&ctl->magic, memory_order_acquire) !=
+	   RB_SHARED_MAGIC) {
+		munmap(ctl, st.st_size);
+		goto_with_errno(EAGAIN, exit);
+	}
+
+	if(ctl->data_size != DS_DATA_SIZE(buf) ||
+	   ctl->concurrency != DS_CONCURRENCY(buf) ||
+	   ctl->capacity < DS_ENTRIES(buf) ||
+	   ctl->data_offset + ctl->capacity * ctl->data_size !=
+	   (size_t) st.st_size) {
+		munmap(ctl, st.st_size);
+		goto_with_errno(EINVAL, exit);
+	}
+
+	__set_capacity(buf, ctl->capacity);
+	__use_shared(buf, ctl);
+
+	return buf;
+
+exit:
+	rb_destroy(&buf);
+	return NULL;
+}
+
+bool rb_unlink_shared(const char * name)
+{
+	return (shm_unlink(name) == 0);
+}
+
+void rb_destroy(ring_buffer * buf)
+{
+	/* Destroy the private data section. */
+	if(__is_shared(*buf)) {
+		munmap(__ctl(*buf), __ctl(*buf)->data_offset + __space(*buf));
+	} else {
+		if(DS_PRIV(*buf)->backing & RB_BACKING_LOCKED)
+			munlock(DS_PRIV(*buf)->data, __mapped_size(*buf));
+
+		if(__is_mirrored(*buf))
+			munmap(DS_PRIV(*buf)->data, 2 * __space(*buf));
+		else if(__is_huge(*buf))
+			munmap(DS_PRIV(*buf)->data, __huge_size(*buf));
+		else
+			free(DS_PRIV(*buf)->data);
+
+		free(DS_PRIV(*buf)->seq);
+	}
+	DS_PRIV(*buf)->data = NULL;
+	DS_PRIV(*buf)->seq = NULL;
+
+	if(DS_PRIV(*buf)->rwlock)
+		rwlock_free(&DS_PRIV(*buf)->rwlock);
+	if(DS_PRIV(*buf)->not_empty)
+		waitq_free(&DS_PRIV(*buf)->not_empty);
+	if(DS_PRIV(*buf)->not_full)
+		waitq_free(&DS_PRIV(*buf)->not_full);
+
+	/* Deallocate the data structure. */
+	DS_FREE(buf);
+}
+
+size_t rb_size(const ring_buffer buf)
+{
+	size_t head;
+
+	if(__is_lockfree(buf))
+		return __lockfree_length(buf);
+
+	return __optimistic_snapshot(buf, &head);
+}
+
+bool rb_empty(const ring_buffer buf)
+{
+	size_t head;
+
+	if(__is_lockfree(buf))
+		return (__lockfree_length(buf) == 0);
+
+	return (__optimistic_snapshot(buf, &head) == 0);
+}
+
+bool rb_full(const ring_buffer buf)
+{
+	size_t head;
+
+	if(__is_lockfree(buf))
+		return (__lockfree_length(buf) >= __capacity(buf));
+
+	return (__optimistic_snapshot(buf, &head) >= __capacity(buf));
+}
+
+unsigned int rb_backing(const ring_buffer buf)
+{
+	return DS_PRIV(buf)->backing;
+}
+
+size_t rb_capacity(const ring_buffer buf)
+{
+	size_t capacity;
+
+	if(!__is_growable(buf))
+		return __capacity(buf);
+
+	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+	capacity = __capacity(buf);
+	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+
+	return capacity;
+}
+
+void rb_stats(const ring_buffer buf, struct rb_stats * stats)
+{
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	stats->failed = atomic_load_explicit(&__ctl(buf)->failed,
+					     memory_order_relaxed);
+	if(__is_lockfree(buf)) {
+		stats->pushes = atomic_load_explicit(&__ctl(buf)->write,
+						     memory_order_relaxed);
+		stats->pops = __is_broadcast(buf) ? 0 :
+			atomic_load_explicit(&__ctl(buf)->read,
+					     memory_order_relaxed);
+		stats->overwrites = 0;
+		return;
+	}
+
+	stats->pushes = atomic_load_explicit(&priv->pushes,
+					     memory_order_relaxed);
+	stats->pops = atomic_load_explicit(&priv->pops, memory_order_relaxed);
+	stats->overwrites = atomic_load_explicit(&priv->overwrites,
+						 memory_order_relaxed);
+}
+
+/* Drop the first `skip` of `count` blocks copied to `dst`. */
+static __nonulls size_t __trim_snapshot(const ring_buffer buf,
+					void * dst,
+					const size_t count,
+					const size_t skip)
+{
+	if(skip >= count)
+		return 0;
+
+	if(skip > 0)
+		memmove(dst, (uint8_t *) dst + skip * DS_DATA_SIZE(buf),
+			(count - skip) * DS_DATA_SIZE(buf));
+
+	return count - skip;
+}
+
+/* Copy the locked buffer without the lock.  A push onto the tail can only
+ * overwrite the oldest blocks, and the tail it leaves behind tells which, so
+ * those are simply dropped; any other kind of modification bumps `edits`,
+ * and then the copy has to be taken again. */
+static __nonulls size_t __optimistic_snapshot_copy(const ring_buffer buf,
+						   void * dst)
+{
+	size_t edits;
+	size_t head;
+	size_t length;
+	size_t tail;
+	size_t tail_head;
+	ssize_t skip;
+
+	do {
+		edits  = atomic_load_explicit(&DS_PRIV(buf)->edits,
+					      memory_order_acquire);
+		length = __optimistic_snapshot(buf, &head);
+		__copy_from_ring(buf, head, dst, length);
+
+		/* Find where the tail got to while copying. */
+		atomic_thread_fence(memory_order_acquire);
+		tail  = __optimistic_snapshot(buf, &tail_head);
+		tail += tail_head;
+	} while(atomic_load_explicit(&DS_PRIV(buf)->edits,
+				     memory_order_relaxed) != edits);
+
+	/* The slot of each block before `tail - capacity` may be reused. */
+	skip = (ssize_t) (tail - __capacity(buf) - head);
+	return __trim_snapshot(buf, dst, length, MAX(skip, 0));
+}
+
+/* Copy an SPSC buffer from any thread.  The producer only reuses a slot once
+ * the consumer has moved past it, so the blocks behind the consumer's
+ * position after the copy are dropped. */
+static __nonulls size_t __spsc_snapshot(const ring_buffer buf, void * dst)
+{
+	size_t read;
+	size_t write;
+	size_t length;
+	ssize_t skip;
+
+	read  = atomic_load_explicit(&__ctl(buf)->read, memory_order_acquire);
+	write = atomic_load_explicit(&__ctl(buf)->write, memory_order_acquire);
+	length = MIN(write - read, __capacity(buf));
+	__copy_from_ring(buf, read, dst, length);
+
+	atomic_thread_fence(memory_order_acquire);
+	skip = (ssize_t) (atomic_load_explicit(&__ctl(buf)->read,
+					       memory_order_relaxed) - read);
+	return __trim_snapshot(buf, dst, length, MAX(skip, 0));
+}
+
+size_t rb_snapshot(const ring_buffer buf, void * dst)
+{
+	size_t length;
+
+	if(__is_spsc(buf))
+		return __spsc_snapshot(buf, dst);
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, 0);
+
+	if(!__is_growable(buf))
+		return __optimistic_snapshot_copy(buf, dst);
+
+	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+	length = __length(buf);
+	__copy_from_ring(buf, DS_PRIV(buf)->head, dst, length);
+	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+
+	return length;
+}
+
+bool rb_push_head(ring_buffer buf, const void * data)
+{
+	bool success;
+
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, false);
+
+	__writer_entry(buf);
+	success = __push_head(buf, data);
+	__writer_exit(buf);
+
+	return __wake_consumers(buf, success);
+}
+
+bool rb_push_tail(ring_buffer buf, const void * data)
+{
+	bool success;
+
+	if(__is_spsc(buf))
+		return __wake_consumers(buf, __spsc_push_tail(buf, data));
+	if(__is_mpmc(buf))
+		return __wake_consumers(buf, __mpmc_push_tail(buf, data));
+	if(__is_broadcast(buf))
+		return __broadcast_push_tail_n(buf, data, 1);
+
+	__writer_entry(buf);
+	success = __push_tail(buf, data);
+	__writer_exit(buf);
+
+	return __wake_consumers(buf, success);
+}
+
+bool rb_push_tail_wait(ring_buffer buf,
+		       const void * data,
+		       const struct timespec * timeout)
+{
+	int err;
+	struct timespec deadline;
+
+	/* Wait queues are private to each process, so a waiter could never be
+	 * woken by a peer in another process. */
+	if(__is_shared(buf))
+		return_with_errno(ENOTSUP, false);
+
+	if(timeout)
+		waitq_deadline(&deadline, timeout);
+
+	while(!rb_push_tail(buf, data)) {
+		if(errno != ENOBUFS)
+			return false;
+
+		err = waitq_wait(DS_PRIV(buf)->not_full, __not_full, buf,
+				 timeout ? &deadline : NULL);
+		if(err < 0)
+			return_with_errno(-err, false);
+	}
+
+	return true;
+}
+
+/* Allocate a data block and fill it using one of the *_into() functions.
+ * On failure the block is released again and `errno` is left untouched. */
+#define ALLOC_INTO(buf, into_fn, ...)				\
+	({							\
+		void * data_ = malloc(DS_DATA_SIZE(buf));	\
+		if(!data_)					\
+			return_with_errno(ENOMEM, NULL);	\
+		if(!into_fn(buf, ##__VA_ARGS__, data_)) {	\
+			int err_ = errno;			\
+			free(data_);				\
+			return_with_errno(err_, NULL);		\
+		}						\
+		data_;						\
+	})
+
+void * rb_pop_head(ring_buffer buf)
+{
+	return ALLOC_INTO(buf, rb_pop_head_into);
+}
+
+bool rb_pop_head_into(ring_buffer buf, void * data)
+{
+	bool success;
+
+	if(__is_spsc(buf))
+		return __wake_producers(buf, __spsc_pop_head(buf, data));
+	if(__is_mpmc(buf))
+		return __wake_producers(buf, __mpmc_pop_head(buf, data));
+	if(__is_broadcast(buf))
+		return_with_errno(ENOTSUP, false);
+
+	__writer_entry(buf);
+	success = __pop_head(buf, data);
+	__writer_exit(buf);
+
+	return __wake_producers(buf, success);
+}
+
+void * rb_pop_head_wait(ring_buffer buf, const struct timespec * timeout)
+{
+	return ALLOC_INTO(buf, rb_pop_head_wait_into, timeout);
+}
+
+bool rb_pop_head_wait_into(ring_buffer buf,
+			   const struct timespec * timeout,
+			   void * data)
+{
+	int err;
+	struct timespec deadline;
+
+	/* Wait queues are private to each process, so a waiter could never be
+	 * woken by a peer in another process. */
+	if(__is_shared(buf))
+		return_with_errno(ENOTSUP, false);
+
+	if(timeout)
+		waitq_deadline(&deadline, timeout);
+
+	/* Another consumer may empty the buffer again between the wakeup and
+	 * the pop, so keep waiting until the pop itself succeeds. */
+	while(!rb_pop_head_into(buf, data)) {
+		if(errno != EFAULT)
+			return false;
+
+		err = waitq_wait(DS_PRIV(buf)->not_empty, __not_empty, buf,
+				 timeout ? &deadline : NULL);
+		if(err < 0)
+			return_with_errno(-err, false);
+	}
+
+	return true;
+}
+
+void * rb_pop_tail(ring_buffer buf)
+{
+	return ALLOC_INTO(buf, rb_pop_tail_into);
+}
+
+bool rb_pop_tail_into(ring_buffer buf, void * data)
+{
+	bool success;
+
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, false);
+
+	__writer_entry(buf);
+	success = __pop_tail(buf, data);
+	__writer_exit(buf);
+
+	return __wake_producers(buf, success);
+}
+
+size_t rb_push_head_n(ring_buffer buf, const void * data, const size_t n)
+{
+	size_t count;
+
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, 0);
+
+	__writer_entry(buf);
+	count = __push_head_n(buf, data, n);
+	__writer_exit(buf);
+
+	return __wake_consumers(buf, count);
+}
+
+size_t rb_push_tail_n(ring_buffer buf, const void * data, const size_t n)
+{
+	size_t count;
+
+	if(__is_spsc(buf))
+		return __wake_consumers(buf, __spsc_push_tail_n(buf, data, n));
+	if(__is_broadcast(buf))
+		return __broadcast_push_tail_n(buf, data, n);
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, 0);
+
+	__writer_entry(buf);
+	count = __push_tail_n(buf, data, n);
+	__writer_exit(buf);
+
+	return __wake_consumers(buf, count);
+}
+
+size_t rb_pop_head_n(ring_buffer buf, void * data, const size_t n)
+{
+	size_t count;
+
+	if(__is_spsc(buf))
+		return __wake_producers(buf, __spsc_pop_head_n(buf, data, n));
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, 0);
+
+	__writer_entry(buf);
+	count = __pop_head_n(buf, data, n);
+	__writer_exit(buf);
+
+	return __wake_producers(buf, count);
+}
+
+size_t rb_pop_tail_n(ring_buffer buf, void * data, const size_t n)
+{
+	size_t count;
+
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, 0);
+
+	__writer_entry(buf);
+	count = __pop_tail_n(buf, data, n);
+	__writer_exit(buf);
+
+	return __wake_producers(buf, count);
 }
 
 bool rb_insert(ring_buffer buf, const void * data, const ssize_t pos)
 {
 	bool success;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, false);
+
+	__writer_entry(buf);
 	success = __insert(buf, data, pos);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	__writer_exit(buf);
+
+	return __wake_consumers(buf, success);
+}
+
+void * rb_reserve_tail(ring_buffer buf, size_t * n)
+{
+	void * addr;
+
+	if(__is_spsc(buf))
+		return __spsc_reserve_tail(buf, n);
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, NULL);
+
+	/* The writer lock is held until rb_commit_tail() so that nobody else
+	 * can claim or observe the slots while the caller fills them. */
+	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	addr = __reserve_tail(buf, n);
+	if(!addr)
+		rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+
+	return addr;
+}
+
+bool rb_commit_tail(ring_buffer buf, const size_t n)
+{
+	bool success;
+
+	if(__is_spsc(buf)) {
+		success = __spsc_commit_tail(buf, n);
+	} else if(__is_lockfree(buf)) {
+		return_with_errno(ENOTSUP, false);
+	} else {
+		__write_begin(buf);
+		success = __commit_tail(buf, n);
+		__writer_exit(buf);
+	}
+
+	if(success)
+		__wake_consumers(buf, n);
 
 	return success;
 }
 
-void * __nonulls rb_fetch(const ring_buffer buf, const ssize_t pos)
+void * rb_acquire_head(ring_buffer buf, size_t * n)
 {
-	void * data;
+	void * addr;
+
+	if(__is_spsc(buf))
+		return __spsc_acquire_head(buf, n);
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, NULL);
+
+	/* The writer lock is held until rb_release_head(), which consumes the
+	 * blocks, so they cannot be popped or overwritten in the meantime. */
+	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	addr = __acquire_head(buf, n);
+	if(!addr)
+		rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+
+	return addr;
+}
+
+bool rb_release_head(ring_buffer buf, const size_t n)
+{
+	bool success;
+
+	if(__is_spsc(buf)) {
+		success = __spsc_release_head(buf, n);
+	} else if(__is_lockfree(buf)) {
+		return_with_errno(ENOTSUP, false);
+	} else {
+		__write_begin(buf);
+		success = __release_head(buf, n);
+		__writer_exit(buf);
+	}
+
+	if(success)
+		__wake_producers(buf, n);
+
+	return success;
+}
+
+ssize_t rb_read_fd(ring_buffer buf, const int fd, const size_t max)
+{
+	bool grew;
+	size_t capacity;
+	size_t count;
+	ssize_t n;
+	struct iovec iov[2];
+
+	if(DS_DATA_SIZE(buf) != 1)
+		return_with_errno(EINVAL, -1);
+	if(__is_mpmc(buf) || __is_broadcast(buf))
+		return_with_errno(ENOTSUP, -1);
+	if(max == 0)
+		return 0;
+
+	if(__is_spsc(buf)) {
+		size_t write;
+
+		write = atomic_load_explicit(&__ctl(buf)->write,
+					     memory_order_relaxed);
+		count = MIN(max, __spsc_free(buf, write, max));
+		if(count == 0)
+			return_with_errno(ENOBUFS, -1);
+
+		n = readv(fd, iov, __ring_iov(buf, write, count, iov));
+		if(n > 0) {
+			atomic_store_explicit(&__ctl(buf)->write, write + n,
+					      memory_order_release);
+			__wake_consumers(buf, n);
+		}
+
+		return n;
+	}
+
+	/* Growing the buffer moves every block and resets `head` and `tail`,
+	 * so it must be marked as a write.  Optimistic readers cannot see the
+	 * free slots being filled, though, so unless the buffer grew, the
+	 * readv() runs outside the write section and only the update of `tail`
+	 * is marked. */
+	__writer_entry(buf);
+
+	capacity = __capacity(buf);
+	__make_room(buf, 1);
+	grew = (__capacity(buf) != capacity);
+
+	count = MIN(max, __capacity(buf) - __length(buf));
+	if(count == 0) {
+		__writer_exit(buf);
+		return_with_errno(ENOBUFS, -1);
+	}
+
+	if(!grew)
+		__write_end(buf);
+
+	n = readv(fd, iov, __ring_iov(buf, DS_PRIV(buf)->tail, count, iov));
+
+	if(!grew)
+		__write_begin(buf);
+	if(n > 0) {
+		DS_PRIV(buf)->tail += n;
+		__count(&DS_PRIV(buf)->pushes, n);
+	}
+	__writer_exit(buf);
+
+	if(n > 0)
+		__wake_consumers(buf, n);
+
+	return n;
+}
+
+ssize_t rb_write_fd(ring_buffer buf, const int fd, const size_t max)
+{
+	size_t count;
+	ssize_t n;
+	struct iovec iov[2];
+
+	if(DS_DATA_SIZE(buf) != 1)
+		return_with_errno(EINVAL, -1);
+	if(__is_mpmc(buf) || __is_broadcast(buf))
+		return_with_errno(ENOTSUP, -1);
+	if(max == 0)
+		return 0;
+
+	if(__is_spsc(buf)) {
+		size_t read;
+
+		read = atomic_load_explicit(&__ctl(buf)->read,
+					    memory_order_relaxed);
+		count = MIN(max, __spsc_used(buf, read, max));
+		if(count == 0)
+			return_with_errno(EFAULT, -1);
+
+		n = writev(fd, iov, __ring_iov(buf, read, count, iov));
+		if(n > 0) {
+			atomic_store_explicit(&__ctl(buf)->read, read + n,
+					      memory_order_release);
+			__wake_producers(buf, n);
+		}
+
+		return n;
+	}
+
+	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+
+	count = MIN(max, __length(buf));
+	if(count == 0) {
+		rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+		return_with_errno(EFAULT, -1);
+	}
+
+	n = writev(fd, iov, __ring_iov(buf, DS_PRIV(buf)->head, count, iov));
+
+	__write_begin(buf);
+	if(n > 0) {
+		DS_PRIV(buf)->head += n;
+		__count(&DS_PRIV(buf)->pops, n);
+	}
+	__writer_exit(buf);
+
+	if(n > 0)
+		__wake_producers(buf, n);
+
+	return n;
+}
+
+rb_reader rb_reader_attach(ring_buffer buf)
+{
+	rb_reader reader;
+
+	if(!__is_broadcast(buf))
+		return_with_errno(ENOTSUP, NULL);
+
+	DS_ALLOC_ALIGNED(reader);
+	if(!reader)
+		return_with_errno(ENOMEM, NULL);
+
+	reader->lost = 0;
+	reader->buf = buf;
+
+	/* Holding the lock keeps the producer from scanning the cursors until
+	 * the new one is in place; it starts out at the tail, which the
+	 * producer's cached view of the slowest reader is never ahead of. */
+	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	atomic_init(&reader->cursor,
+		    atomic_load_explicit(&__ctl(buf)->write,
+					 memory_order_acquire));
+	reader->next = DS_PRIV(buf)->readers;
+	DS_PRIV(buf)->readers = reader;
+	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+
+	return reader;
+}
+
+void rb_reader_detach(rb_reader * reader)
+{
+	rb_reader * link;
+	ring_buffer buf = (*reader)->buf;
 
 	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	data = __fetch(buf, pos);
+	for(link = &DS_PRIV(buf)->readers; *link; link = &(*link)->next) {
+		if(*link == *reader) {
+			*link = (*reader)->next;
+			break;
+		}
+	}
 	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
 
-	return data;
+	__wake_producers(buf, 1);
+	free_null(*reader);
+}
+
+bool rb_reader_pop_into(rb_reader reader, void * data)
+{
+	return __wake_producers(reader->buf, __reader_pop_n(reader, data, 1));
+}
+
+size_t rb_reader_pop_n(rb_reader reader, void * data, const size_t n)
+{
+	return __wake_producers(reader->buf, __reader_pop_n(reader, data, n));
+}
+
+size_t rb_reader_size(const rb_reader reader)
+{
+	size_t cursor;
+	size_t write;
+
+	cursor = atomic_load_explicit(&reader->cursor, memory_order_relaxed);
+	write  = atomic_load_explicit(&__ctl(reader->buf)->write,
+				      memory_order_acquire);
+	return MIN(write - cursor, __capacity(reader->buf));
+}
+
+size_t rb_reader_lost(const rb_reader reader)
+{
+	return reader->lost;
+}
+
+bool rb_shrink_to_fit(ring_buffer buf)
+{
+	bool success = true;
+	size_t capacity;
+
+	if(!__is_growable(buf))
+		return_with_errno(ENOTSUP, false);
+
+	__writer_entry(buf);
+
+	/* Never shrink below the capacity the buffer was created with. */
+	capacity = MAX(__length(buf), DS_ENTRIES(buf));
+	if(DS_PROPS(buf)->power_of_two)
+		capacity = __round_pow2(capacity);
+	if(capacity < __capacity(buf))
+		success = __reshape(buf, capacity);
+
+	__writer_exit(buf);
+
+	return success;
+}
+
+void * rb_fetch(const ring_buffer buf, const ssize_t pos)
+{
+	return ALLOC_INTO(buf, rb_fetch_into, pos);
+}
+
+bool rb_fetch_into(const ring_buffer buf, const ssize_t pos, void * data)
+{
+	if(__is_spsc(buf)) {
+		size_t span;
+		void * addr = __spsc_peek(buf, pos, &span);
+		if(!addr)
+			return false;
+
+		memcpy(data, addr, DS_DATA_SIZE(buf));
+		return true;
+	}
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, false);
+
+	/* A growable buffer may free its data region while an optimistic
+	 * reader is still copying from it, so it has to be read under lock. */
+	if(__is_growable(buf)) {
+		size_t span;
+		void * addr;
+
+		rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+		addr = __peek(buf, pos, &span);
+		if(addr)
+			memcpy(data, addr, DS_DATA_SIZE(buf));
+		rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+
+		return (addr != NULL);
+	}
+
+	return __optimistic_fetch(buf, pos, data);
+}
+
+void * rb_peek(const ring_buffer buf, const ssize_t pos)
+{
+	size_t span;
+
+	return rb_peek_span(buf, pos, &span);
+}
+
+void * rb_peek_span(const ring_buffer buf, const ssize_t pos, size_t * n)
+{
+	void * addr;
+
+	if(__is_spsc(buf))
+		return __spsc_peek(buf, pos, n);
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, NULL);
+
+	/* The reader lock is held until rb_peek_release() so that no writer
+	 * can move or overwrite the block while the caller is using it. */
+	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+	addr = __peek(buf, pos, n);
+	if(!addr)
+		rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+
+	return addr;
+}
+
+void rb_peek_release(const ring_buffer buf)
+{
+	if(__is_lockfree(buf))
+		return;
+
+	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+}
+
+/* Locate the stored blocks as two runs that are each contiguous in memory,
+ * the second of which is empty unless the contents wrap around. */
+static __nonulls void __runs(const ring_buffer buf,
+			     uint8_t ** base,
+			     size_t * bytes)
+{
+	size_t length = __length(buf);
+	size_t first = __span(buf, DS_PRIV(buf)->head, length);
+
+	base[0]  = __count_to_addr(buf, DS_PRIV(buf)->head);
+	bytes[0] = first * DS_DATA_SIZE(buf);
+	base[1]  = DS_PRIV(buf)->data;
+	bytes[1] = (length - first) * DS_DATA_SIZE(buf);
+}
+
+/* Store the result of a user function into `dest`, releasing it if the user
+ * allocated a new block for it. */
+static inline void __take_result(const ring_buffer buf,
+				 void * dest,
+				 void * result)
+{
+	if(result != dest) {
+		memcpy(dest, result, DS_DATA_SIZE(buf));
+		free(result);
+	}
+}
+
+void rb_map(ring_buffer buf, map_fn fn)
+{
+	size_t size = DS_DATA_SIZE(buf);
+	size_t bytes[2];
+	uint8_t * base[2];
+
+	if(__is_lockfree(buf)) {
+		errno = ENOTSUP;
+		return;
+	}
+
+	__writer_entry(buf);
+	__runs(buf, base, bytes);
+	for(int r = 0; r < 2; r++) {
+		for(uint8_t * p = base[r]; p < base[r] + bytes[r]; p += size)
+			__take_result(buf, p, fn(p));
+	}
+	__count_edit(buf);
+	__writer_exit(buf);
+}
+
+void * rb_foldr(const ring_buffer buf, foldr_fn fn, const void * init)
+{
+	size_t size = DS_DATA_SIZE(buf);
+	size_t bytes[2];
+	uint8_t * base[2];
+	void * acc;
+
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, NULL);
+
+	acc = malloc(size);
+	if(!acc)
+		return_with_errno(ENOMEM, NULL);
+	memcpy(acc, init, size);
+
+	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+	__runs(buf, base, bytes);
+	for(int r = 1; r >= 0; r--) {
+		for(uint8_t * p = base[r] + bytes[r]; p > base[r]; p -= size)
+			__take_result(buf, acc, fn(p - size, acc));
+	}
+	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+
+	return acc;
+}
+
+void * rb_foldl(const ring_buffer buf, foldl_fn fn, const void * init)
+{
+	size_t size = DS_DATA_SIZE(buf);
+	size_t bytes[2];
+	uint8_t * base[2];
+	void * acc;
+
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, NULL);
+
+	acc = malloc(size);
+	if(!acc)
+		return_with_errno(ENOMEM, NULL);
+	memcpy(acc, init, size);
+
+	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+	__runs(buf, base, bytes);
+	for(int r = 0; r < 2; r++) {
+		for(uint8_t * p = base[r]; p < base[r] + bytes[r]; p += size)
+			__take_result(buf, acc, fn(acc, p));
+	}
+	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+
+	return acc;
+}
+
+/* Determine whether any block's result from `p` equals `match`. */
+static __nonulls bool __any_matches(const ring_buffer buf,
+				    pred_fn p,
+				    const bool match)
+{
+	bool found = false;
+	size_t size = DS_DATA_SIZE(buf);
+	size_t bytes[2];
+	uint8_t * base[2];
+
+	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+	__runs(buf, base, bytes);
+	for(int r = 0; r < 2 && !found; r++) {
+		for(uint8_t * c = base[r]; c < base[r] + bytes[r]; c += size) {
+			if(p(c) == match) {
+				found = true;
+				break;
+			}
+		}
+	}
+	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+
+	return found;
+}
+
+bool rb_any(const ring_buffer buf, pred_fn p)
+{
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, false);
+
+	return __any_matches(buf, p, true);
+}
+
+bool rb_all(const ring_buffer buf, pred_fn p)
+{
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, false);
+
+	return !__any_matches(buf, p, false);
+}
+
+bool rb_filter(ring_buffer buf, pred_fn p)
+{
+	size_t size = DS_DATA_SIZE(buf);
+	size_t kept = 0;
+	size_t removed;
+	size_t bytes[2];
+	uint8_t * base[2];
+	uint8_t * dest;
+	uint8_t * end;
+
+	if(__is_lockfree(buf))
+		return_with_errno(ENOTSUP, false);
+
+	__writer_entry(buf);
+	__runs(buf, base, bytes);
+
+	/* Compact the kept blocks towards the head.  `dest` never overtakes
+	 * the block being tested, and wraps just like the runs do. */
+	dest = base[0];
+	end  = (uint8_t *) DS_PRIV(buf)->data + __space(buf);
+	for(int r = 0; r < 2; r++) {
+		for(uint8_t * c = base[r]; c < base[r] + bytes[r]; c += size) {
+			if(!p(c))
+				continue;
+
+			if(dest == end)
+				dest = DS_PRIV(buf)->data;
+			if(dest != c)
+				memcpy(dest, c, size);
+			dest += size;
+			kept++;
+		}
+	}
+
+	removed = __length(buf) - kept;
+	DS_PRIV(buf)->tail = DS_PRIV(buf)->head + kept;
+	__count_edit(buf);
+	__writer_exit(buf);
+
+	return __wake_producers(buf, removed);
 }
 
 #ifdef DEBUG
@@ -412,7 +2630,7 @@ void rb_dump(ring_buffer buf)
 
 	priv = DS_PRIV(buf);
 
-	printf("Buffer length: %ld", priv->length);
+	printf("Buffer length: %zu", __length(buf));
 	if(__is_empty(buf))
 		puts(" (empty)\n");
 	else if(__is_full(buf))
@@ -420,20 +2638,23 @@ void rb_dump(ring_buffer buf)
 	else
 		puts("\n");
 
-	for(size_t i = 0; i < DS_ENTRIES(buf); i++) {
+	for(size_t i = 0; i < __space(buf); i++) {
 		uint8_t * addr;
+		size_t slot;
 		size_t pos;
 
 		addr = ((uint8_t *) priv->data) + i;
-		pos  = __addr_to_index(buf, addr);
+		slot = i / DS_DATA_SIZE(buf);
+		pos  = mod((ssize_t) (slot - __slot(buf, priv->head)),
+			   (ssize_t) __capacity(buf));
 
-		printf("%p [%lu]: %#04x", addr, pos, *addr);
+		printf("%p [%zu]: %#04x", addr, pos, *addr);
 
 		if(addr == priv->data)
 			printf(" <data>");
-		if(addr == priv->head)
+		if(addr == __count_to_addr(buf, priv->head))
 			printf(" (head)");
-		if(addr == priv->tail)
+		if(addr == __count_to_addr(buf, priv->tail))
 			printf(" (tail)");
 
 		putchar('\n');
@@ -20,25 +20,31 @@
 
 #include "list/single_list.h"
 
-static struct sl_element * __create_element(void * data,
-					    size_t data_size)
+static struct sl_element * __create_element(single_list list, void * data)
 {
 	struct sl_element * elem;
 
-	elem = malloc(sizeof(*elem));
+	elem = slab_get(DS_PRIV(list)->slab);
 	if(!elem)
-		return_with_errno(ENOMEM, NULL);
-
-	elem->data = malloc(data_size);
-	if(!elem->data)
-		goto_with_errno(ENOMEM, exit);
+		return NULL;
 
-	memcpy(elem->data, data, data_size);
+	memcpy(elem->data, data, DS_DATA_SIZE(list));
 	return elem;
+}
 
-exit:
-	free(elem);
-	return NULL;
+static void __destroy_element(single_list list, struct sl_element * elem)
+{
+	slab_put(DS_PRIV(list)->slab, elem);
+}
+
+/* Copies the data out of an unlinked element into @data, a buffer owned by
+ * the caller, and returns the element to the slab cache. */
+static void __release_element(single_list list,
+			      struct sl_element * elem,
+			      void * data)
+{
+	memcpy(data, elem->data, DS_DATA_SIZE(list));
+	__destroy_element(list, elem);
 }
 
 static struct sl_element * __lookup_element(single_list list, size_t pos)
@@ -189,8 +195,7 @@ static void __delete_before(single_list list, struct sl_element * mark)
 	struct sl_element * current;
 
 	linked_list_while_safe(list, current, current != mark) {
-		free(current->data);
-		free(current);
+		__destroy_element(list, current);
 
 		(DS_PRIV(list)->length)--;
 	}
@@ -207,8 +212,7 @@ static void __delete_after(single_list list, struct sl_element * mark)
 
 	linked_list_foreach_safe(list, current) {
 		if(!passover || !mark) {
-			free(current->data);
-			free(current);
+			__destroy_element(list, current);
 
 			(DS_PRIV(list)->length)--;
 		}
@@ -224,6 +228,119 @@ static void __delete_after(single_list list, struct sl_element * mark)
 		DS_PRIV(list)->head = NULL;
 }
 
+/* Enter the writer locks of two different lists in address order, so that
+ * two threads locking the same pair of lists cannot deadlock. */
+static void __writer_entry_pair(single_list a, single_list b)
+{
+	single_list tmp;
+
+	if((uintptr_t) a > (uintptr_t) b) {
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	rwlock_writer_entry(DS_PRIV(a)->rwlock);
+	rwlock_writer_entry(DS_PRIV(b)->rwlock);
+}
+
+static void __writer_exit_pair(single_list a, single_list b)
+{
+	rwlock_writer_exit(DS_PRIV(a)->rwlock);
+	rwlock_writer_exit(DS_PRIV(b)->rwlock);
+}
+
+/* Cut the chain of elements starting at @head after at most @count elements,
+ * returning the remainder of the chain. */
+static struct sl_element * __cut_run(struct sl_element * head, size_t count)
+{
+	struct sl_element * rest;
+
+	if(!head)
+		return NULL;
+
+	while(--count && head->next)
+		head = head->next;
+
+	rest = head->next;
+	head->next = NULL;
+
+	return rest;
+}
+
+/* Merge the sorted chains @a and @b onto @link, and return the link following
+ * the last merged element.  Ties are taken from @a so that merges are
+ * stable. */
+static struct sl_element ** __merge_runs(struct sl_element ** link,
+					 struct sl_element * a,
+					 struct sl_element * b,
+					 comp_fn comp)
+{
+	while(a && b) {
+		if(comp(b->data, a->data)) {
+			*link = b;
+			b = b->next;
+		} else {
+			*link = a;
+			a = a->next;
+		}
+
+		link = &(*link)->next;
+	}
+
+	for(*link = a ? a : b; *link; link = &(*link)->next) {}
+
+	return link;
+}
+
+static bool __compatible(single_list dst, single_list src)
+{
+	return dst != src && DS_DATA_SIZE(dst) == DS_DATA_SIZE(src);
+}
+
+/* Move every element of @src into @dst at @pos.  Both lists' writer locks
+ * must be held. */
+static bool __splice(single_list dst, size_t pos, single_list src)
+{
+	struct sl_element * prev;
+
+	if(pos > DS_PRIV(dst)->length)
+		return_with_errno(EINVAL, false);
+
+	if(DS_PRIV(src)->length == 0)
+		return true;
+
+	/* The elements of @src now belong to @dst, so @dst must release
+	 * them. */
+	slab_cache_absorb(DS_PRIV(dst)->slab, DS_PRIV(src)->slab);
+
+	if(pos == 0)
+		prev = NULL;
+	else if(pos == DS_PRIV(dst)->length)
+		prev = DS_PRIV(dst)->tail;
+	else
+		prev = __lookup_element(dst, pos - 1);
+
+	if(prev) {
+		DS_PRIV(src)->tail->next = prev->next;
+		prev->next = DS_PRIV(src)->head;
+	} else {
+		DS_PRIV(src)->tail->next = DS_PRIV(dst)->head;
+		DS_PRIV(dst)->head = DS_PRIV(src)->head;
+	}
+
+	if(!DS_PRIV(src)->tail->next)
+		DS_PRIV(dst)->tail = DS_PRIV(src)->tail;
+
+	DS_PRIV(dst)->length += DS_PRIV(src)->length;
+
+	DS_PRIV(src)->head = NULL;
+	DS_PRIV(src)->tail = NULL;
+	DS_PRIV(src)->length = 0;
+
+	return true;
+}
+
 single_list sl_create(const struct ds_properties * props)
 {
 	single_list list;
@@ -239,6 +356,12 @@ single_list sl_create(const struct ds_properties * props)
 	priv->head = NULL;
 	priv->tail = NULL;
 	priv->length = 0;
+	priv->slab = NULL;
+	priv->rwlock = NULL;
+
+	if(slab_cache_alloc(&priv->slab,
+			    sizeof(struct sl_element) + DS_DATA_SIZE(list)) < 0)
+		goto exit;
 
 	if(rwlock_alloc(&priv->rwlock) < 0)
 		goto exit;
@@ -255,15 +378,21 @@ void sl_free(single_list * list)
 {
 	struct sl_element * current;
 
-	rwlock_writer_entry(DS_PRIV(*list)->rwlock);
+	/* Every element lives in the list's slab cache, so releasing the
+	 * cache frees them all without walking the list.  A cache shared with
+	 * other lists outlives this one, though, so the elements are handed
+	 * back to it first. */
+	if(DS_PRIV(*list)->slab) {
+		if(slab_cache_shared(DS_PRIV(*list)->slab)) {
+			linked_list_foreach_safe(*list, current)
+				__destroy_element(*list, current);
+		}
 
-	linked_list_foreach_safe(*list, current) {
-		free(current->data);
-		free(current);
+		slab_cache_free(&DS_PRIV(*list)->slab);
 	}
 
-	rwlock_writer_exit(DS_PRIV(*list)->rwlock);
-	rwlock_free(&DS_PRIV(*list)->rwlock);
+	if(DS_PRIV(*list)->rwlock)
+		rwlock_free(&DS_PRIV(*list)->rwlock);
 
 	DS_FREE(list);
 }
@@ -283,10 +412,10 @@ void sl_push_head(single_list list, void * data)
 {
 	struct sl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_head(list, current);
+	current = __create_element(list, data);
+	if(current)
+		__push_head(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
@@ -294,43 +423,51 @@ void sl_push_tail(single_list list, void * data)
 {
 	struct sl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_tail(list, current);
+	current = __create_element(list, data);
+	if(current)
+		__push_tail(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
 void * sl_pop_head(single_list list)
 {
-	void * data = NULL;
+	void * data;
 	struct sl_element * current;
 
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __pop_head(list);
+	if(current)
+		__release_element(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
+	if(!current)
+		free_null(data);
 
 	return data;
 }
 
 void * sl_pop_tail(single_list list)
 {
-	void * data = NULL;
+	void * data;
 	struct sl_element * current;
 
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __pop_tail(list);
+	if(current)
+		__release_element(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
+	if(!current)
+		free_null(data);
 
 	return data;
 }
@@ -340,10 +477,11 @@ bool sl_insert(single_list list, void * data, size_t pos)
 	bool success;
 	struct sl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	success = __insert_element(list, current, pos);
+	current = __create_element(list, data);
+	success = current && __insert_element(list, current, pos);
+	if(current && !success)
+		__destroy_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return success;
@@ -355,31 +493,30 @@ bool sl_delete(single_list list, size_t pos)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __remove_element(list, pos);
+	if(current)
+		__destroy_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		free(current->data);
-		free(current);
-
-		return true;
-	}
-
-	return false;
+	return current != NULL;
 }
 
 void * sl_remove(single_list list, size_t pos)
 {
-	void * data = NULL;
+	void * data;
 	struct sl_element * current;
 
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __remove_element(list, pos);
+	if(current)
+		__release_element(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
+	if(!current)
+		free_null(data);
 
 	return data;
 }
@@ -519,8 +656,7 @@ bool sl_filter(single_list list, pred_fn p)
 			changed = true;
 
 			__delete_element(list, current);
-			free(current->data);
-			free(current);
+			__destroy_element(list, current);
 		}
 	}
 
@@ -640,6 +776,210 @@ void sl_reverse(single_list list)
 	DS_PRIV(list)->tail = tmp;
 }
 
+/**
+ * sl_sort() - Sort a list in place.
+ * @list: The list to sort
+ * @comp: A function returning true if its first argument orders strictly
+ *        before its second
+ *
+ * Runtime: O(n log n)
+ *
+ * A stable, bottom-up merge sort: adjacent runs of 1, 2, 4, ... elements are
+ * merged until a single run spans the list.  The existing elements are
+ * relinked, so nothing is allocated or copied.
+ */
+void sl_sort(single_list list, comp_fn comp)
+{
+	size_t width;
+	struct sl_element * a, * b, * rest;
+	struct sl_element ** link = NULL;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	for(width = 1; width < DS_PRIV(list)->length; width *= 2) {
+		rest = DS_PRIV(list)->head;
+		link = &DS_PRIV(list)->head;
+
+		while(rest) {
+			a = rest;
+			b = __cut_run(a, width);
+			rest = __cut_run(b, width);
+			link = __merge_runs(link, a, b, comp);
+		}
+	}
+
+	/* The last pass leaves @link at the tail's next pointer. */
+	if(link)
+		DS_PRIV(list)->tail = container_of(link,
+						   struct sl_element,
+						   next);
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+/**
+ * sl_merge() - Merge one sorted list into another.
+ * @dst: The list to merge into, sorted by @comp
+ * @src: The list to merge from, sorted by @comp
+ * @comp: A function returning true if its first argument orders strictly
+ *        before its second
+ *
+ * Runtime: O(n + m)
+ *
+ * Relinks every element of @src into @dst in sorted order, leaving @src
+ * empty.  Elements of @dst come before equal elements of @src.  @src hands
+ * its slab cache over to @dst along with its elements.
+ */
+bool sl_merge(single_list dst, single_list src, comp_fn comp)
+{
+	struct sl_element ** link;
+
+	if(!__compatible(dst, src))
+		return_with_errno(EINVAL, false);
+
+	__writer_entry_pair(dst, src);
+
+	if(DS_PRIV(src)->length > 0) {
+		slab_cache_absorb(DS_PRIV(dst)->slab, DS_PRIV(src)->slab);
+
+		link = __merge_runs(&DS_PRIV(dst)->head,
+				    DS_PRIV(dst)->head,
+				    DS_PRIV(src)->head,
+				    comp);
+
+		DS_PRIV(dst)->tail = container_of(link,
+						  struct sl_element,
+						  next);
+		DS_PRIV(dst)->length += DS_PRIV(src)->length;
+
+		DS_PRIV(src)->head = NULL;
+		DS_PRIV(src)->tail = NULL;
+		DS_PRIV(src)->length = 0;
+	}
+
+	__writer_exit_pair(dst, src);
+
+	return true;
+}
+
+/**
+ * sl_splice() - Move every element of one list into another.
+ * @dst: The list to move elements into
+ * @pos: The position in @dst to move them to
+ * @src: The list to move elements from
+ *
+ * Runtime: O(1) at the head or tail of @dst, otherwise O(pos)
+ *
+ * Relinks the elements of @src, in order, into @dst starting at index @pos,
+ * leaving @src empty.  @src hands its slab cache over to @dst along with its
+ * elements.
+ */
+bool sl_splice(single_list dst, size_t pos, single_list src)
+{
+	bool success;
+
+	if(!__compatible(dst, src))
+		return_with_errno(EINVAL, false);
+
+	__writer_entry_pair(dst, src);
+	success = __splice(dst, pos, src);
+	__writer_exit_pair(dst, src);
+
+	return success;
+}
+
+/**
+ * sl_concat() - Move every element of one list onto the tail of another.
+ * @dst: The list to append to
+ * @src: The list to move elements from
+ *
+ * Runtime: O(1)
+ */
+bool sl_concat(single_list dst, single_list src)
+{
+	bool success;
+
+	if(!__compatible(dst, src))
+		return_with_errno(EINVAL, false);
+
+	__writer_entry_pair(dst, src);
+	success = __splice(dst, DS_PRIV(dst)->length, src);
+	__writer_exit_pair(dst, src);
+
+	return success;
+}
+
+/**
+ * sl_split_at() - Split a list in two at a given position.
+ * @list: The list to split
+ * @pos: The position to split @list at
+ *
+ * Runtime: O(pos)
+ *
+ * Moves the elements of @list from index @pos onwards into a new list by
+ * cutting the chain.  The elements stay in the slab cache of @list: if they
+ * all move, the new list takes the cache over, and otherwise the two lists
+ * share it from then on.
+ */
+single_list sl_split_at(single_list list, size_t pos)
+{
+	size_t length;
+	struct slab_cache * slab;
+	struct sl_element * prev;
+	struct sl_element * mark;
+	single_list rest;
+
+	rest = sl_create(DS_PROPS(list));
+	if(!rest)
+		return NULL;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	length = DS_PRIV(list)->length;
+	if(pos > length) {
+		rwlock_writer_exit(DS_PRIV(list)->rwlock);
+		sl_free(&rest);
+		return_with_errno(EINVAL, NULL);
+	}
+
+	/* The last element to keep in @list and the first to move into @rest,
+	 * either of which may be NULL. */
+	if(pos == 0)
+		prev = NULL;
+	else if(pos == length)
+		prev = DS_PRIV(list)->tail;
+	else
+		prev = __lookup_element(list, pos - 1);
+	mark = prev ? prev->next : DS_PRIV(list)->head;
+
+	if(pos == 0) {
+		slab = DS_PRIV(list)->slab;
+		DS_PRIV(list)->slab = DS_PRIV(rest)->slab;
+		DS_PRIV(rest)->slab = slab;
+	} else if(mark) {
+		slab_cache_free(&DS_PRIV(rest)->slab);
+		DS_PRIV(rest)->slab = slab_cache_share(DS_PRIV(list)->slab);
+	}
+
+	if(mark) {
+		DS_PRIV(rest)->head = mark;
+		DS_PRIV(rest)->tail = DS_PRIV(list)->tail;
+
+		DS_PRIV(list)->tail = prev;
+		if(prev)
+			prev->next = NULL;
+		else
+			DS_PRIV(list)->head = NULL;
+	}
+
+	DS_PRIV(rest)->length = length - pos;
+	DS_PRIV(list)->length = pos;
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return rest;
+}
+
 /**
  * sl_foldr() - Right associative fold for linked lists.
  * @list: A list of values to reduce
@@ -0,0 +1,722 @@
+/* unrolled_list.c - Unrolled Linked List Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "list/unrolled_list.h"
+
+static inline uint8_t * __slot(unrolled_list list,
+			       struct ul_node * node,
+			       size_t i)
+{
+	return node->data + i * DS_DATA_SIZE(list);
+}
+
+static struct ul_node * __create_node(unrolled_list list)
+{
+	struct ul_node * node;
+
+	node = slab_get(DS_PRIV(list)->slab);
+	if(!node)
+		return NULL;
+
+	node->next = NULL;
+	node->prev = NULL;
+	node->count = 0;
+
+	return node;
+}
+
+/* Link @node into the list directly after @mark, or at the head if @mark is
+ * NULL. */
+static void __link_node(unrolled_list list,
+			struct ul_node * mark,
+			struct ul_node * node)
+{
+	node->prev = mark;
+	node->next = mark ? mark->next : DS_PRIV(list)->head;
+
+	if(node->next)
+		node->next->prev = node;
+	else
+		DS_PRIV(list)->tail = node;
+
+	if(mark)
+		mark->next = node;
+	else
+		DS_PRIV(list)->head = node;
+}
+
+/* Unlink @node from the list and release it, along with any elements it still
+ * holds. */
+static void __destroy_node(unrolled_list list, struct ul_node * node)
+{
+	if(node->prev)
+		node->prev->next = node->next;
+	else
+		DS_PRIV(list)->head = node->next;
+
+	if(node->next)
+		node->next->prev = node->prev;
+	else
+		DS_PRIV(list)->tail = node->prev;
+
+	DS_PRIV(list)->length -= node->count;
+	slab_put(DS_PRIV(list)->slab, node);
+}
+
+/* Find the node holding the element at @pos, walking from whichever end of the
+ * list is closer, and store the element's index within that node in @idx. */
+static struct ul_node * __locate(unrolled_list list, size_t pos, size_t * idx)
+{
+	size_t rpos;
+	struct ul_node * node;
+
+	if(pos >= DS_PRIV(list)->length)
+		return NULL;
+
+	if(pos < DS_PRIV(list)->length / 2) {
+		linked_list_while(list, node, pos >= node->count)
+			pos -= node->count;
+
+		*idx = pos;
+	} else {
+		rpos = DS_PRIV(list)->length - 1 - pos;
+		double_list_while_rev(list, node, rpos >= node->count)
+			rpos -= node->count;
+
+		*idx = node->count - 1 - rpos;
+	}
+
+	return node;
+}
+
+/* Store a copy of @data at index @idx of @node, which must not be full. */
+static void __insert_at(unrolled_list list,
+			struct ul_node * node,
+			size_t idx,
+			void * data)
+{
+	memmove(__slot(list, node, idx + 1),
+		__slot(list, node, idx),
+		(node->count - idx) * DS_DATA_SIZE(list));
+	memcpy(__slot(list, node, idx), data, DS_DATA_SIZE(list));
+
+	node->count++;
+	(DS_PRIV(list)->length)++;
+}
+
+/* Remove the element at index @idx of @node.  An emptied node is released, and
+ * a node left less than half full absorbs its successor when both fit. */
+static void __remove_at(unrolled_list list, struct ul_node * node, size_t idx)
+{
+	struct ul_node * next = node->next;
+
+	memmove(__slot(list, node, idx),
+		__slot(list, node, idx + 1),
+		(node->count - idx - 1) * DS_DATA_SIZE(list));
+
+	node->count--;
+	(DS_PRIV(list)->length)--;
+
+	if(node->count == 0) {
+		__destroy_node(list, node);
+	} else if(next && node->count < DS_PRIV(list)->capacity / 2 &&
+		  node->count + next->count <= DS_PRIV(list)->capacity) {
+		memcpy(__slot(list, node, node->count),
+		       next->data,
+		       next->count * DS_DATA_SIZE(list));
+		node->count += next->count;
+
+		/* The moved elements are still in the list. */
+		DS_PRIV(list)->length += next->count;
+		__destroy_node(list, next);
+	}
+}
+
+/* Move the upper half of the full node @node into a new node after it. */
+static bool __split_node(unrolled_list list, struct ul_node * node)
+{
+	size_t keep = node->count / 2;
+	struct ul_node * split;
+
+	split = __create_node(list);
+	if(!split)
+		return false;
+
+	split->count = node->count - keep;
+	memcpy(split->data,
+	       __slot(list, node, keep),
+	       split->count * DS_DATA_SIZE(list));
+	node->count = keep;
+
+	__link_node(list, node, split);
+
+	return true;
+}
+
+static bool __push_head(unrolled_list list, void * data)
+{
+	struct ul_node * node = DS_PRIV(list)->head;
+
+	if(!node || node->count == DS_PRIV(list)->capacity) {
+		node = __create_node(list);
+		if(!node)
+			return false;
+
+		__link_node(list, NULL, node);
+	}
+
+	__insert_at(list, node, 0, data);
+
+	return true;
+}
+
+static bool __push_tail(unrolled_list list, void * data)
+{
+	struct ul_node * node = DS_PRIV(list)->tail;
+
+	if(!node || node->count == DS_PRIV(list)->capacity) {
+		node = __create_node(list);
+		if(!node)
+			return false;
+
+		__link_node(list, DS_PRIV(list)->tail, node);
+	}
+
+	__insert_at(list, node, node->count, data);
+
+	return true;
+}
+
+/* Find the first element for which @p returns @want, storing its index within
+ * the returned node in @idx.  Returns NULL if there is no such element. */
+static struct ul_node * __find(unrolled_list list,
+			       pred_fn p,
+			       bool want,
+			       size_t * idx)
+{
+	size_t size = DS_DATA_SIZE(list);
+	uint8_t * slot;
+	uint8_t * end;
+	struct ul_node * node;
+
+	linked_list_foreach(list, node) {
+		end = __slot(list, node, node->count);
+		for(slot = node->data; slot < end; slot += size) {
+			if(p(slot) == want) {
+				*idx = (slot - node->data) / size;
+				return node;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Release every node after @mark, or every node if @mark is NULL. */
+static void __destroy_after(unrolled_list list, struct ul_node * mark)
+{
+	while(DS_PRIV(list)->tail != mark)
+		__destroy_node(list, DS_PRIV(list)->tail);
+}
+
+/* Release every node before @mark, or every node if @mark is NULL. */
+static void __destroy_before(unrolled_list list, struct ul_node * mark)
+{
+	while(DS_PRIV(list)->head != mark)
+		__destroy_node(list, DS_PRIV(list)->head);
+}
+
+static void __swap(uint8_t * a, uint8_t * b, size_t size)
+{
+	uint8_t tmp;
+
+	for(size_t i = 0; i < size; i++) {
+		tmp = a[i];
+		a[i] = b[i];
+		b[i] = tmp;
+	}
+}
+
+unrolled_list ul_create(const struct ds_properties * props)
+{
+	size_t capacity;
+	unrolled_list list;
+	struct unrolled_list_priv * priv;
+
+	if(props->data_size == 0)
+		return_with_errno(EINVAL, NULL);
+
+	list = malloc(sizeof(*list));
+	if(!list)
+		return_with_errno(ENOMEM, NULL);
+
+	DS_INIT(list, props, &mgmt_ops, &hof_ops);
+
+	capacity = (UL_NODE_SIZE - sizeof(struct ul_node)) / props->data_size;
+	if(capacity < UL_MIN_CAPACITY)
+		capacity = UL_MIN_CAPACITY;
+
+	priv = DS_PRIV(list);
+	priv->head = NULL;
+	priv->tail = NULL;
+	priv->length = 0;
+	priv->capacity = capacity;
+	priv->slab = NULL;
+	priv->rwlock = NULL;
+
+	if(slab_cache_alloc(&priv->slab, sizeof(struct ul_node) +
+			    capacity * props->data_size) < 0)
+		goto exit;
+
+	if(rwlock_alloc(&priv->rwlock) < 0)
+		goto exit;
+
+	return list;
+
+exit:
+	ul_free(&list);
+
+	return NULL;
+}
+
+void ul_free(unrolled_list * list)
+{
+	if(DS_PRIV(*list)->slab)
+		slab_cache_free(&DS_PRIV(*list)->slab);
+
+	if(DS_PRIV(*list)->rwlock)
+		rwlock_free(&DS_PRIV(*list)->rwlock);
+
+	DS_FREE(list);
+}
+
+bool ul_null(unrolled_list list)
+{
+	return ul_length(list) == 0;
+}
+
+size_t ul_length(unrolled_list list)
+{
+	size_t length;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	length = DS_PRIV(list)->length;
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return length;
+}
+
+void ul_push_head(unrolled_list list, void * data)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__push_head(list, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void ul_push_tail(unrolled_list list, void * data)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__push_tail(list, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void * ul_pop_head(unrolled_list list)
+{
+	return ul_remove(list, 0);
+}
+
+void * ul_pop_tail(unrolled_list list)
+{
+	void * data;
+	struct ul_node * node;
+
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	node = DS_PRIV(list)->tail;
+	if(node) {
+		memcpy(data,
+		       __slot(list, node, node->count - 1),
+		       DS_DATA_SIZE(list));
+		__remove_at(list, node, node->count - 1);
+	}
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	if(!node)
+		free_null(data);
+
+	return data;
+}
+
+bool ul_insert(unrolled_list list, void * data, size_t pos)
+{
+	bool success = false;
+	size_t idx;
+	struct ul_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	if(pos == DS_PRIV(list)->length) {
+		success = __push_tail(list, data);
+	} else if((node = __locate(list, pos, &idx))) {
+		if(node->count == DS_PRIV(list)->capacity) {
+			if(!__split_node(list, node))
+				goto exit;
+
+			if(idx > node->count) {
+				idx -= node->count;
+				node = node->next;
+			}
+		}
+
+		__insert_at(list, node, idx, data);
+		success = true;
+	}
+
+exit:
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_delete(unrolled_list list, size_t pos)
+{
+	size_t idx;
+	struct ul_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	node = __locate(list, pos, &idx);
+	if(node)
+		__remove_at(list, node, idx);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return node != NULL;
+}
+
+void * ul_remove(unrolled_list list, size_t pos)
+{
+	void * data;
+	size_t idx;
+	struct ul_node * node;
+
+	data = malloc(DS_DATA_SIZE(list));
+	if(!data)
+		return_with_errno(ENOMEM, NULL);
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	node = __locate(list, pos, &idx);
+	if(node) {
+		memcpy(data, __slot(list, node, idx), DS_DATA_SIZE(list));
+		__remove_at(list, node, idx);
+	}
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	if(!node)
+		free_null(data);
+
+	return data;
+}
+
+void * ul_fetch(unrolled_list list, size_t pos)
+{
+	size_t idx;
+	struct ul_node * node;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	node = __locate(list, pos, &idx);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	if(node)
+		return __slot(list, node, idx);
+
+	return NULL;
+}
+
+bool ul_contains(unrolled_list list, void * data)
+{
+	bool success = false;
+	size_t size = DS_DATA_SIZE(list);
+	uint8_t first = *(uint8_t *) data;
+	uint8_t * slot;
+	uint8_t * end;
+	struct ul_node * node;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+
+	/* Elements are packed, so checking the first byte inline rules out
+	 * most of them without a call to memcmp(). */
+	linked_list_while(list, node, !success) {
+		end = __slot(list, node, node->count);
+		for(slot = node->data; slot < end && !success; slot += size) {
+			success = (*slot == first &&
+				   memcmp(slot, data, size) == 0);
+		}
+	}
+
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_any(unrolled_list list, pred_fn p)
+{
+	bool success;
+	size_t idx;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = (__find(list, p, true, &idx) != NULL);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_all(unrolled_list list, pred_fn p)
+{
+	bool success;
+	size_t idx;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = (DS_PRIV(list)->length > 0 &&
+		   __find(list, p, false, &idx) == NULL);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_filter(unrolled_list list, pred_fn p)
+{
+	size_t orig_length;
+	size_t kept = 0;
+	size_t out = 0;
+	struct ul_node * node;
+	struct ul_node * dest;
+	uint8_t * slot;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	orig_length = DS_PRIV(list)->length;
+	dest = DS_PRIV(list)->head;
+
+	/* Pack the surviving elements towards the head.  The write position
+	 * (dest, out) never passes the read position, so elements are never
+	 * overwritten before they are tested. */
+	linked_list_foreach(list, node) {
+		for(size_t i = 0; i < node->count; i++) {
+			slot = __slot(list, node, i);
+			if(!p(slot))
+				continue;
+
+			if(out == DS_PRIV(list)->capacity) {
+				dest->count = out;
+				dest = dest->next;
+				out = 0;
+			}
+
+			if(slot != __slot(list, dest, out))
+				memcpy(__slot(list, dest, out),
+				       slot,
+				       DS_DATA_SIZE(list));
+
+			out++;
+			kept++;
+		}
+	}
+
+	if(dest) {
+		dest->count = out;
+		__destroy_after(list, out ? dest : dest->prev);
+		DS_PRIV(list)->length = kept;
+	}
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return (orig_length != kept);
+}
+
+bool ul_drop_while(unrolled_list list, pred_fn p)
+{
+	size_t orig_length;
+	size_t idx;
+	struct ul_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	orig_length = DS_PRIV(list)->length;
+
+	/* Delete everything before the first element that doesn't satisfy the
+	 * predicate, or the entire list if there is no such element. */
+	node = __find(list, p, false, &idx);
+	__destroy_before(list, node);
+	if(node && idx > 0) {
+		memmove(node->data,
+			__slot(list, node, idx),
+			(node->count - idx) * DS_DATA_SIZE(list));
+		node->count -= idx;
+		DS_PRIV(list)->length -= idx;
+	}
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return (orig_length != DS_PRIV(list)->length);
+}
+
+bool ul_take_while(unrolled_list list, pred_fn p)
+{
+	size_t orig_length;
+	size_t idx;
+	struct ul_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	orig_length = DS_PRIV(list)->length;
+
+	/* Delete the first element that doesn't satisfy the predicate and
+	 * every one after it. */
+	node = __find(list, p, false, &idx);
+	if(node) {
+		__destroy_after(list, node);
+		DS_PRIV(list)->length -= node->count - idx;
+		node->count = idx;
+		if(idx == 0)
+			__destroy_node(list, node);
+	}
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return (orig_length != DS_PRIV(list)->length);
+}
+
+void ul_map(unrolled_list list, map_fn fn)
+{
+	void * result;
+	size_t size = DS_DATA_SIZE(list);
+	uint8_t * slot;
+	uint8_t * end;
+	struct ul_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	linked_list_foreach(list, node) {
+		end = __slot(list, node, node->count);
+		for(slot = node->data; slot < end; slot += size) {
+			result = fn(slot);
+
+			/* See dl_map(). */
+			if(result != slot) {
+				memcpy(slot, result, size);
+				free(result);
+			}
+		}
+	}
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void ul_reverse(unrolled_list list)
+{
+	struct ul_node * node;
+	struct ul_node * tmp;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	linked_list_foreach_safe(list, node) {
+		for(size_t i = 0; i < node->count / 2; i++)
+			__swap(__slot(list, node, i),
+			       __slot(list, node, node->count - 1 - i),
+			       DS_DATA_SIZE(list));
+
+		tmp = node->prev;
+		node->prev = node->next;
+		node->next = tmp;
+	}
+
+	tmp = DS_PRIV(list)->head;
+	DS_PRIV(list)->head = DS_PRIV(list)->tail;
+	DS_PRIV(list)->tail = tmp;
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void * ul_foldr(const unrolled_list list,
+		foldr_fn fn,
+		const void * init)
+{
+	void * result;
+	void * accumulator;
+	size_t size = DS_DATA_SIZE(list);
+	uint8_t * slot;
+	uint8_t * end;
+	struct ul_node * node;
+
+	accumulator = malloc(size);
+	if(!accumulator)
+		return_with_errno(ENOMEM, NULL);
+	memcpy(accumulator, init, size);
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	linked_list_foreach(list, node) {
+		end = __slot(list, node, node->count);
+		for(slot = node->data; slot < end; slot += size) {
+			result = fn(slot, accumulator);
+
+			/* See dl_foldr(). */
+			if(result != accumulator) {
+				memcpy(accumulator, result, size);
+				free(result);
+			}
+		}
+	}
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return accumulator;
+}
+
+void * ul_foldl(const unrolled_list list,
+		foldl_fn fn,
+		const void * init)
+{
+	void * result;
+	void * accumulator;
+	size_t size = DS_DATA_SIZE(list);
+	uint8_t * slot;
+	uint8_t * end;
+	struct ul_node * node;
+
+	accumulator = malloc(size);
+	if(!accumulator)
+		return_with_errno(ENOMEM, NULL);
+	memcpy(accumulator, init, size);
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	linked_list_foreach(list, node) {
+		end = __slot(list, node, node->count);
+		for(slot = node->data; slot < end; slot += size) {
+			result = fn(accumulator, slot);
+
+			/* See dl_foldl(). */
+			if(result != accumulator) {
+				memcpy(accumulator, result, size);
+				free(result);
+			}
+		}
+	}
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return accumulator;
+}
@@ -0,0 +1,352 @@
+/* slab.c - Slab Allocator Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sched.h>
+
+#include "mem/slab.h"
+
+#define SLAB_ALIGN __BIGGEST_ALIGNMENT__
+
+/* Each slab begins with a header linking it into its cache; the objects
+ * follow at the next SLAB_ALIGN boundary. */
+struct slab {
+	struct slab * next;
+	uint8_t objects[] __attribute__((__aligned__(SLAB_ALIGN)));
+};
+
+static inline size_t __align(size_t size)
+{
+	return (size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+}
+
+static bool __grow(struct slab_cache * cache)
+{
+	struct slab * slab;
+
+	slab = malloc(sizeof(*slab) + cache->per_slab * cache->object_size);
+	if(!slab)
+		return false;
+
+	if(!cache->slabs)
+		cache->last = slab;
+
+	slab->next = cache->slabs;
+	cache->slabs = slab;
+	cache->fresh = slab->objects;
+	cache->fresh_count = cache->per_slab;
+
+	return true;
+}
+
+/* Find the cache which holds the slabs of @cache, following any forwarding
+ * left by slab_cache_absorb(), and report whether any cache on the way is
+ * shared (in which case other owners may use the result concurrently). */
+static struct slab_cache * __root(struct slab_cache * cache, bool * shared)
+{
+	struct slab_cache * next;
+
+	*shared = false;
+
+	for(;;) {
+		if(atomic_load_explicit(&cache->refs, memory_order_acquire) > 1)
+			*shared = true;
+
+		next = atomic_load_explicit(&cache->forward,
+					    memory_order_acquire);
+		if(!next)
+			return cache;
+
+		cache = next;
+	}
+}
+
+static void __lock(struct slab_cache * cache)
+{
+	while(atomic_flag_test_and_set_explicit(&cache->lock,
+						memory_order_acquire))
+		sched_yield();
+}
+
+static void __unlock(struct slab_cache * cache)
+{
+	atomic_flag_clear_explicit(&cache->lock, memory_order_release);
+}
+
+/* Find the cache which holds the slabs of @cache and, if it is shared, lock
+ * it.  Forwarding is only ever added under the lock, so a cache found to be
+ * forwarded once locked is given up and the search repeated. */
+static struct slab_cache * __enter(struct slab_cache * cache, bool * locked)
+{
+	struct slab_cache * root;
+
+	for(;;) {
+		root = __root(cache, locked);
+		if(!*locked)
+			return root;
+
+		__lock(root);
+		if(!atomic_load_explicit(&root->forward, memory_order_relaxed))
+			return root;
+		__unlock(root);
+	}
+}
+
+static void __exit(struct slab_cache * cache, bool locked)
+{
+	if(locked)
+		__unlock(cache);
+}
+
+static void * __get(struct slab_cache * cache)
+{
+	void * object;
+
+	if(cache->free) {
+		object = cache->free;
+		cache->free = *(void **) object;
+
+		return object;
+	}
+
+	if(!cache->fresh_count && !__grow(cache))
+		return_with_errno(ENOMEM, NULL);
+
+	object = cache->fresh;
+	cache->fresh += cache->object_size;
+	cache->fresh_count--;
+
+	return object;
+}
+
+static void __put(struct slab_cache * cache, void * object)
+{
+	/* The first object freed onto an empty list stays at its end until
+	 * the list drains again. */
+	if(!cache->free)
+		cache->free_last = object;
+
+	*(void **) object = cache->free;
+	cache->free = object;
+}
+
+int slab_cache_alloc(struct slab_cache ** cache, size_t object_size)
+{
+	*cache = malloc(sizeof(**cache));
+	if(!*cache)
+		return -ENOMEM;
+
+	/* Free objects store the free list link in their first word. */
+	if(object_size < sizeof(void *))
+		object_size = sizeof(void *);
+
+	(*cache)->object_size = __align(object_size);
+	(*cache)->per_slab = (SLAB_SIZE - sizeof(struct slab)) /
+		(*cache)->object_size;
+	if((*cache)->per_slab < SLAB_MIN_OBJECTS)
+		(*cache)->per_slab = SLAB_MIN_OBJECTS;
+
+	(*cache)->slabs = NULL;
+	(*cache)->last = NULL;
+	(*cache)->free = NULL;
+	(*cache)->free_last = NULL;
+	(*cache)->fresh = NULL;
+	(*cache)->fresh_count = 0;
+
+	atomic_init(&(*cache)->refs, 1);
+	atomic_init(&(*cache)->forward, NULL);
+	atomic_flag_clear(&(*cache)->lock);
+
+	return 0;
+}
+
+/* Drop a reference to a cache.  The last reference releases its slabs, or the
+ * reference it holds on the cache it was forwarded to. */
+void slab_cache_free(struct slab_cache ** cache)
+{
+	struct slab * slab, * next;
+	struct slab_cache * forward;
+
+	if(atomic_fetch_sub_explicit(&(*cache)->refs, 1,
+				     memory_order_acq_rel) > 1) {
+		*cache = NULL;
+		return;
+	}
+
+	forward = atomic_load_explicit(&(*cache)->forward,
+				       memory_order_acquire);
+	if(forward)
+		slab_cache_free(&forward);
+
+	for(slab = (*cache)->slabs; slab; slab = next) {
+		next = slab->next;
+		free(slab);
+	}
+
+	free_null(*cache);
+}
+
+/* Take another reference to a cache for a new owner.  The caller must already
+ * hold a reference. */
+struct slab_cache * slab_cache_share(struct slab_cache * cache)
+{
+	atomic_fetch_add_explicit(&cache->refs, 1, memory_order_relaxed);
+
+	return cache;
+}
+
+bool slab_cache_shared(struct slab_cache * cache)
+{
+	bool shared;
+
+	__root(cache, &shared);
+
+	return shared;
+}
+
+void * slab_get(struct slab_cache * cache)
+{
+	bool locked;
+	void * object;
+
+	cache = __enter(cache, &locked);
+	object = __get(cache);
+	__exit(cache, locked);
+
+	return object;
+}
+
+void slab_put(struct slab_cache * cache, void * object)
+{
+	bool locked;
+
+	if(!object)
+		return;
+
+	cache = __enter(cache, &locked);
+	__put(cache, object);
+	__exit(cache, locked);
+}
+
+/* Lock, in address order, whichever of the two distinct caches holding the
+ * slabs of @cache and @donor are shared.  Returns false if they turn out to be
+ * the same cache. */
+static bool __enter_pair(struct slab_cache ** cache,
+			 struct slab_cache ** donor,
+			 bool * cache_locked,
+			 bool * donor_locked)
+{
+	struct slab_cache * a, * b;
+	bool a_locked, b_locked;
+
+	for(;;) {
+		a = __root(*cache, &a_locked);
+		b = __root(*donor, &b_locked);
+		if(a == b)
+			return false;
+
+		if((uintptr_t) a < (uintptr_t) b) {
+			if(a_locked)
+				__lock(a);
+			if(b_locked)
+				__lock(b);
+		} else {
+			if(b_locked)
+				__lock(b);
+			if(a_locked)
+				__lock(a);
+		}
+
+		if(!atomic_load_explicit(&a->forward, memory_order_relaxed) &&
+		   !atomic_load_explicit(&b->forward, memory_order_relaxed))
+			break;
+
+		__exit(a, a_locked);
+		__exit(b, b_locked);
+	}
+
+	*cache = a;
+	*donor = b;
+	*cache_locked = a_locked;
+	*donor_locked = b_locked;
+
+	return true;
+}
+
+/* Hand every slab held for @donor over to @cache, so that objects allocated
+ * from @donor may be freed to, and are released along with, @cache.  If no
+ * other owner shares @donor, it is left empty but usable; otherwise it is
+ * forwarded to @cache, so that all of its owners allocate from @cache from
+ * then on.  Both caches must hold objects of the same size.  This runs in
+ * constant time, apart from threading the donor's never-used objects onto the
+ * free list when both caches have some (at most one slab's worth). */
+int slab_cache_absorb(struct slab_cache * cache, struct slab_cache * donor)
+{
+	bool cache_locked, donor_locked;
+
+	if(!__enter_pair(&cache, &donor, &cache_locked, &donor_locked))
+		return 0;
+
+	if(cache->object_size != donor->object_size) {
+		__exit(cache, cache_locked);
+		__exit(donor, donor_locked);
+		return -EINVAL;
+	}
+
+	if(donor->slabs) {
+		donor->last->next = cache->slabs;
+		cache->slabs = donor->slabs;
+		if(!cache->last)
+			cache->last = donor->last;
+	}
+
+	if(donor->free) {
+		*(void **) donor->free_last = cache->free;
+		if(!cache->free)
+			cache->free_last = donor->free_last;
+		cache->free = donor->free;
+	}
+
+	if(!cache->fresh_count) {
+		cache->fresh = donor->fresh;
+		cache->fresh_count = donor->fresh_count;
+	} else {
+		for(; donor->fresh_count; donor->fresh_count--) {
+			__put(cache, donor->fresh);
+			donor->fresh += donor->object_size;
+		}
+	}
+
+	donor->slabs = NULL;
+	donor->last = NULL;
+	donor->free = NULL;
+	donor->free_last = NULL;
+	donor->fresh = NULL;
+	donor->fresh_count = 0;
+
+	if(donor_locked) {
+		slab_cache_share(cache);
+		atomic_store_explicit(&donor->forward, cache,
+				      memory_order_release);
+	}
+
+	__exit(cache, cache_locked);
+	__exit(donor, donor_locked);
+
+	return 0;
+}
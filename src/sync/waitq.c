@@ -0,0 +1,120 @@
+/* waitq.c - Wait Queue Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sync/waitq.h"
+
+int waitq_alloc(struct waitq ** waitq)
+{
+	int err;
+	pthread_condattr_t attr;
+
+	*waitq = malloc(sizeof(**waitq));
+	if(!*waitq)
+		return -ENOMEM;
+
+	err = pthread_mutex_init(&(*waitq)->lock, NULL);
+	if(err)
+		goto free_waitq;
+
+	/* Deadlines are measured on the monotonic clock so that they are not
+	 * affected by changes to the system time. */
+	err = pthread_condattr_init(&attr);
+	if(err)
+		goto destroy_mutex;
+	err = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if(!err)
+		err = pthread_cond_init(&(*waitq)->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	if(err)
+		goto destroy_mutex;
+
+	atomic_init(&(*waitq)->waiters, 0);
+
+	return 0;
+
+destroy_mutex:
+	pthread_mutex_destroy(&(*waitq)->lock);
+free_waitq:
+	free_null(*waitq);
+
+	return -err;
+}
+
+void waitq_free(struct waitq ** waitq)
+{
+	pthread_mutex_destroy(&(*waitq)->lock);
+	pthread_cond_destroy(&(*waitq)->cond);
+
+	free(*waitq);
+	*waitq = NULL;
+}
+
+void waitq_deadline(struct timespec * deadline, const struct timespec * timeout)
+{
+	clock_gettime(CLOCK_MONOTONIC, deadline);
+
+	deadline->tv_sec += timeout->tv_sec;
+	deadline->tv_nsec += timeout->tv_nsec;
+	if(deadline->tv_nsec >= 1000000000L) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000L;
+	}
+}
+
+int waitq_wait(struct waitq * waitq,
+	       waitq_pred_fn pred,
+	       const void * arg,
+	       const struct timespec * deadline)
+{
+	int err = 0;
+	bool ready;
+
+	pthread_mutex_lock(&waitq->lock);
+
+	/* Announce the waiter before testing the predicate.  This pairs with
+	 * the fence in waitq_wake(): either the waker sees a waiter and takes
+	 * the lock to signal it, or the predicate sees the waker's update. */
+	atomic_fetch_add(&waitq->waiters, 1);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	while(!(ready = pred(arg)) && !err) {
+		if(deadline)
+			err = pthread_cond_timedwait(&waitq->cond,
+						     &waitq->lock,
+						     deadline);
+		else
+			err = pthread_cond_wait(&waitq->cond, &waitq->lock);
+	}
+
+	atomic_fetch_sub(&waitq->waiters, 1);
+	pthread_mutex_unlock(&waitq->lock);
+
+	return (ready ? 0 : -err);
+}
+
+void waitq_wake(struct waitq * waitq)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load_explicit(&waitq->waiters, memory_order_relaxed) == 0)
+		return;
+
+	pthread_mutex_lock(&waitq->lock);
+	pthread_cond_broadcast(&waitq->cond);
+	pthread_mutex_unlock(&waitq->lock);
+}
@@ -0,0 +1,236 @@
+/* rank_tree.c - Order Statistic Tree Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tree/rank_tree.h"
+
+static inline size_t __size(const struct rank_node * node)
+{
+	return node ? node->size : 0;
+}
+
+static inline void __update(struct rank_node * node)
+{
+	node->size = __size(node->left) + 1 + __size(node->right);
+}
+
+/* xorshift32; the priorities only need to be independent of the order in
+ * which values are inserted. */
+static uint32_t __priority(struct rank_tree * tree)
+{
+	uint32_t x = tree->seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return tree->seed = x;
+}
+
+/* Split @node into the first @count values (@left) and the rest (@right). */
+static void __split(struct rank_node * node,
+		    size_t count,
+		    struct rank_node ** left,
+		    struct rank_node ** right)
+{
+	if(!node) {
+		*left = NULL;
+		*right = NULL;
+		return;
+	}
+
+	if(__size(node->left) < count) {
+		__split(node->right, count - __size(node->left) - 1,
+			&node->right, right);
+		*left = node;
+	} else {
+		__split(node->left, count, left, &node->left);
+		*right = node;
+	}
+
+	__update(node);
+}
+
+/* Join two trees, every value of @left preceding every value of @right. */
+static struct rank_node * __merge(struct rank_node * left,
+				  struct rank_node * right)
+{
+	if(!left)
+		return right;
+	if(!right)
+		return left;
+
+	if(left->priority > right->priority) {
+		left->right = __merge(left->right, right);
+		__update(left);
+		return left;
+	}
+
+	right->left = __merge(left, right->left);
+	__update(right);
+	return right;
+}
+
+static void __destroy(struct rank_tree * tree, struct rank_node * node)
+{
+	if(!node)
+		return;
+
+	__destroy(tree, node->left);
+	__destroy(tree, node->right);
+	slab_put(tree->slab, node);
+}
+
+/* Translate a position in the sequence into a position in the tree. */
+static inline size_t __physical(const struct rank_tree * tree, size_t pos)
+{
+	return tree->reversed ? __size(tree->root) - 1 - pos : pos;
+}
+
+int rank_tree_alloc(struct rank_tree ** tree)
+{
+	int err;
+
+	*tree = malloc(sizeof(**tree));
+	if(!*tree)
+		return -ENOMEM;
+
+	err = slab_cache_alloc(&(*tree)->slab, sizeof(struct rank_node));
+	if(err < 0) {
+		free_null(*tree);
+		return err;
+	}
+
+	(*tree)->root = NULL;
+	(*tree)->seed = 2463534242u;
+	(*tree)->reversed = false;
+
+	return 0;
+}
+
+void rank_tree_free(struct rank_tree ** tree)
+{
+	slab_cache_free(&(*tree)->slab);
+
+	free_null(*tree);
+}
+
+size_t rank_tree_size(const struct rank_tree * tree)
+{
+	return __size(tree->root);
+}
+
+void * rank_tree_fetch(const struct rank_tree * tree, size_t pos)
+{
+	struct rank_node * node = tree->root;
+
+	if(pos >= __size(node))
+		return NULL;
+
+	pos = __physical(tree, pos);
+	while(pos != __size(node->left)) {
+		if(pos < __size(node->left)) {
+			node = node->left;
+		} else {
+			pos -= __size(node->left) + 1;
+			node = node->right;
+		}
+	}
+
+	return node->value;
+}
+
+bool rank_tree_insert(struct rank_tree * tree, size_t pos, void * value)
+{
+	struct rank_node * node;
+	struct rank_node * left;
+	struct rank_node * right;
+
+	if(pos > __size(tree->root))
+		return false;
+
+	node = slab_get(tree->slab);
+	if(!node)
+		return false;
+
+	node->left = NULL;
+	node->right = NULL;
+	node->size = 1;
+	node->priority = __priority(tree);
+	node->value = value;
+
+	/* In a reversed tree, inserting before position `pos` means inserting
+	 * after the value at the mirrored position. */
+	if(tree->reversed)
+		pos = __size(tree->root) - pos;
+
+	__split(tree->root, pos, &left, &right);
+	tree->root = __merge(__merge(left, node), right);
+
+	return true;
+}
+
+void * rank_tree_remove(struct rank_tree * tree, size_t pos)
+{
+	void * value;
+	struct rank_node * left;
+	struct rank_node * node;
+	struct rank_node * right;
+
+	if(pos >= __size(tree->root))
+		return NULL;
+
+	__split(tree->root, __physical(tree, pos), &left, &right);
+	__split(right, 1, &node, &right);
+	tree->root = __merge(left, right);
+
+	value = node->value;
+	slab_put(tree->slab, node);
+
+	return value;
+}
+
+void rank_tree_drop_head(struct rank_tree * tree, size_t count)
+{
+	struct rank_node * left;
+	struct rank_node * right;
+
+	count = MIN(count, __size(tree->root));
+
+	if(tree->reversed) {
+		__split(tree->root, __size(tree->root) - count, &left, &right);
+		__destroy(tree, right);
+		tree->root = left;
+	} else {
+		__split(tree->root, count, &left, &right);
+		__destroy(tree, left);
+		tree->root = right;
+	}
+}
+
+void rank_tree_drop_tail(struct rank_tree * tree, size_t count)
+{
+	tree->reversed = !tree->reversed;
+	rank_tree_drop_head(tree, count);
+	tree->reversed = !tree->reversed;
+}
+
+void rank_tree_reverse(struct rank_tree * tree)
+{
+	tree->reversed = !tree->reversed;
+}
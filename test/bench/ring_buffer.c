@@ -0,0 +1,284 @@
+/* ring_buffer.c - Ring Buffer Benchmarks
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "list/ring_buffer.h"
+
+#define BENCH_ENTRIES 1024
+#define BENCH_ITEMS   (1 << 20)
+
+struct bench_thread {
+	ring_buffer buf;
+	size_t items;
+};
+
+static double __now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void * __producer(void * arg)
+{
+	struct bench_thread * thread = arg;
+
+	for(uint64_t i = 0; i < thread->items; i++) {
+		while(!rb_push_tail(thread->buf, &i))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void * __consumer(void * arg)
+{
+	struct bench_thread * thread = arg;
+	void * out;
+
+	for(size_t i = 0; i < thread->items; i++) {
+		while(!(out = rb_pop_head(thread->buf)))
+			sched_yield();
+
+		free(out);
+	}
+
+	return NULL;
+}
+
+/* Run `threads` producers against `threads` consumers on one buffer and
+ * return the throughput in elements per second. */
+static double bench_push_pop(enum ds_concurrency concurrency, size_t threads)
+{
+	double start;
+	double elapsed;
+	ring_buffer buf;
+	pthread_t producers[threads];
+	pthread_t consumers[threads];
+	struct bench_thread thread;
+	struct ds_properties props = {
+		.data_size   = sizeof(uint64_t),
+		.entries     = BENCH_ENTRIES,
+		.concurrency = concurrency,
+	};
+
+	buf = rb_create(&props);
+	if(!buf) {
+		perror("rb_create");
+		exit(EXIT_FAILURE);
+	}
+
+	thread.buf   = buf;
+	thread.items = BENCH_ITEMS / threads;
+
+	start = __now();
+	for(size_t i = 0; i < threads; i++) {
+		pthread_create(&producers[i], NULL, __producer, &thread);
+		pthread_create(&consumers[i], NULL, __consumer, &thread);
+	}
+
+	for(size_t i = 0; i < threads; i++) {
+		pthread_join(producers[i], NULL);
+		pthread_join(consumers[i], NULL);
+	}
+	elapsed = __now() - start;
+
+	rb_destroy(&buf);
+
+	return (thread.items * threads) / elapsed;
+}
+
+#define BENCH_READ_SECONDS 0.5
+
+/* How a reader thread reads the buffer.  `READ_LOCKED` is the baseline that
+ * takes the reader lock around both the size query and the fetch, as every
+ * read did before reads became optimistic. */
+enum bench_read_mode {
+	READ_LOCKED,
+	READ_PEEK,
+	READ_OPTIMISTIC,
+};
+
+struct bench_reader {
+	ring_buffer buf;
+	atomic_bool * stop;
+	enum bench_read_mode mode;
+	size_t ops;
+};
+
+/* Read the buffer the way a monitoring thread would: check the size, then
+ * look at one element. */
+static void * __reader(void * arg)
+{
+	struct bench_reader * reader = arg;
+	struct rwlock * rwlock = DS_PRIV(reader->buf)->rwlock;
+	uint64_t * addr;
+	uint64_t out;
+	size_t size;
+
+	while(!atomic_load_explicit(reader->stop, memory_order_relaxed)) {
+		switch(reader->mode) {
+		case READ_LOCKED:
+			rwlock_reader_entry(rwlock);
+			size = rb_size(reader->buf);
+			rwlock_reader_exit(rwlock);
+
+			rwlock_reader_entry(rwlock);
+			rb_fetch_into(reader->buf, size, &out);
+			rwlock_reader_exit(rwlock);
+			break;
+		case READ_PEEK:
+			size = rb_size(reader->buf);
+			addr = rb_peek(reader->buf, size);
+			if(addr) {
+				out = *addr;
+				rb_peek_release(reader->buf);
+			}
+			break;
+		case READ_OPTIMISTIC:
+			size = rb_size(reader->buf);
+			rb_fetch_into(reader->buf, size, &out);
+			break;
+		}
+
+		reader->ops++;
+	}
+
+	(void) out;
+	return NULL;
+}
+
+static void * __writer(void * arg)
+{
+	struct bench_reader * writer = arg;
+	uint64_t val = 0;
+
+	while(!atomic_load_explicit(writer->stop, memory_order_relaxed)) {
+		rb_pop_head_into(writer->buf, &val);
+		rb_push_tail(writer->buf, &val);
+		writer->ops++;
+	}
+
+	return NULL;
+}
+
+/* Run one writer against `readers` reader threads for a fixed time and report
+ * the reader and writer throughput in operations per second. */
+static void bench_readers(enum bench_read_mode mode,
+			  size_t readers,
+			  double * read_rate,
+			  double * write_rate)
+{
+	double elapsed;
+	atomic_bool stop;
+	ring_buffer buf;
+	pthread_t writer_thread;
+	pthread_t reader_threads[readers];
+	struct bench_reader writer;
+	struct bench_reader reader[readers];
+	struct ds_properties props = {
+		.data_size = sizeof(uint64_t),
+		.entries   = BENCH_ENTRIES,
+	};
+
+	buf = rb_create(&props);
+	if(!buf) {
+		perror("rb_create");
+		exit(EXIT_FAILURE);
+	}
+
+	for(uint64_t i = 0; i < BENCH_ENTRIES / 2; i++)
+		rb_push_tail(buf, &i);
+
+	atomic_init(&stop, false);
+	writer = (struct bench_reader) { buf, &stop, mode, 0 };
+	for(size_t i = 0; i < readers; i++)
+		reader[i] = writer;
+
+	elapsed = __now();
+	pthread_create(&writer_thread, NULL, __writer, &writer);
+	for(size_t i = 0; i < readers; i++)
+		pthread_create(&reader_threads[i], NULL, __reader, &reader[i]);
+
+	while(__now() - elapsed < BENCH_READ_SECONDS)
+		sched_yield();
+	atomic_store(&stop, true);
+
+	pthread_join(writer_thread, NULL);
+	for(size_t i = 0; i < readers; i++)
+		pthread_join(reader_threads[i], NULL);
+	elapsed = __now() - elapsed;
+
+	*read_rate = 0;
+	for(size_t i = 0; i < readers; i++)
+		*read_rate += reader[i].ops / elapsed;
+	*write_rate = writer.ops / elapsed;
+
+	rb_destroy(&buf);
+}
+
+int main(void)
+{
+	static const size_t thread_counts[] = {1, 2, 4, 8, 16};
+
+	puts("push_tail/pop_head throughput (elements/s), "
+	     "N producers + N consumers");
+	printf("%8s %14s %14s %8s\n", "threads", "locked", "mpmc", "speedup");
+
+	for(size_t i = 0; i < sizeof(thread_counts) / sizeof(*thread_counts); i++) {
+		double locked;
+		double mpmc;
+
+		locked = bench_push_pop(DS_LOCKED, thread_counts[i]);
+		mpmc   = bench_push_pop(DS_MPMC, thread_counts[i]);
+
+		printf("%8zu %14.0f %14.0f %7.2fx\n",
+		       thread_counts[i], locked, mpmc, mpmc / locked);
+	}
+
+	puts("\nrb_size + fetch throughput (ops/s), N readers + 1 writer");
+	printf("%8s %11s %11s %11s %11s %11s %11s\n", "readers",
+	       "lock reads", "writes", "peek reads", "writes",
+	       "seq reads", "writes");
+
+	for(size_t i = 0; i < sizeof(thread_counts) / sizeof(*thread_counts); i++) {
+		double lock_reads, lock_writes;
+		double peek_reads, peek_writes;
+		double seq_reads, seq_writes;
+
+		bench_readers(READ_LOCKED, thread_counts[i],
+			      &lock_reads, &lock_writes);
+		bench_readers(READ_PEEK, thread_counts[i],
+			      &peek_reads, &peek_writes);
+		bench_readers(READ_OPTIMISTIC, thread_counts[i],
+			      &seq_reads, &seq_writes);
+
+		printf("%8zu %11.0f %11.0f %11.0f %11.0f %11.0f %11.0f\n",
+		       thread_counts[i], lock_reads, lock_writes,
+		       peek_reads, peek_writes, seq_reads, seq_writes);
+	}
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+/* ring_buffer_layout.c - Ring Buffer Layout Benchmark
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This benchmark is built twice, with and without `-DRB_CACHELINE_SIZE=8`,
+ * each time together with the ring buffer sources themselves so that the
+ * benchmark and the buffer agree on the layout.  Each build prints one line;
+ * `make bench` compares the two. */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "list/ring_buffer.h"
+
+#define BENCH_ENTRIES    1024
+#define BENCH_PING_PONGS (1 << 18)
+#define BENCH_ROUNDS     5
+
+struct bench_pair {
+	ring_buffer ping;
+	ring_buffer pong;
+};
+
+static double __now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Pin the calling thread to `cpu`, if the system has that many CPUs, so the
+ * two sides of a ping-pong run on different cores. */
+static void __pin(int cpu)
+{
+	cpu_set_t set;
+
+	if(cpu >= sysconf(_SC_NPROCESSORS_ONLN))
+		return;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void * __ponger(void * arg)
+{
+	struct bench_pair * pair = arg;
+	uint64_t val;
+
+	__pin(1);
+	for(size_t i = 0; i < BENCH_PING_PONGS; i++) {
+		while(!rb_pop_head_into(pair->ping, &val))
+			sched_yield();
+		while(!rb_push_tail(pair->pong, &val))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+/* Bounce a single element between two threads through a pair of `DS_SPSC`
+ * buffers and return the number of round trips per second. */
+static double bench_ping_pong(void)
+{
+	double start;
+	double elapsed;
+	pthread_t ponger;
+	struct bench_pair pair;
+	struct ds_properties props = {
+		.data_size   = sizeof(uint64_t),
+		.entries     = BENCH_ENTRIES,
+		.concurrency = DS_SPSC,
+	};
+
+	pair.ping = rb_create(&props);
+	pair.pong = rb_create(&props);
+	if(!pair.ping || !pair.pong) {
+		perror("rb_create");
+		exit(EXIT_FAILURE);
+	}
+
+	start = __now();
+	pthread_create(&ponger, NULL, __ponger, &pair);
+	for(uint64_t i = 0; i < BENCH_PING_PONGS; i++) {
+		uint64_t val;
+
+		while(!rb_push_tail(pair.ping, &i))
+			sched_yield();
+		while(!rb_pop_head_into(pair.pong, &val))
+			sched_yield();
+	}
+	pthread_join(ponger, NULL);
+	elapsed = __now() - start;
+
+	rb_destroy(&pair.ping);
+	rb_destroy(&pair.pong);
+
+	return BENCH_PING_PONGS / elapsed;
+}
+
+int main(void)
+{
+	double best = 0;
+
+	__pin(0);
+	for(int round = 0; round < BENCH_ROUNDS; round++) {
+		double rate = bench_ping_pong();
+
+		if(rate > best)
+			best = rate;
+	}
+
+	printf("%-10s %10d %14.0f\n",
+	       RB_CACHELINE_SIZE < 64 ? "compact" : "separated",
+	       RB_CACHELINE_SIZE, best);
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+/* unrolled_list.c - Unrolled Linked List Benchmarks
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "list/unrolled_list.h"
+
+#define BENCH_ITEMS  (1 << 20)
+#define BENCH_ROUNDS 5
+
+static const struct ds_properties props = {
+	.data_size = sizeof(uint64_t),
+};
+
+static double __now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Keeps a pseudo-random half of the values. */
+static bool __coin(const void * data)
+{
+	return ((*(const uint64_t *) data * 0x9e3779b97f4a7c15ULL) >> 63) != 0;
+}
+
+static void * __sum(void * acc, const void * c)
+{
+	*(uint64_t *) acc += *(const uint64_t *) c;
+	return acc;
+}
+
+/* Return the best time, in seconds, of BENCH_ROUNDS full traversals using
+ * either a left fold or a failed search. */
+static double bench_dl(double_list list, bool fold)
+{
+	double start;
+	double best = 0;
+	uint64_t zero = 0;
+	uint64_t absent = BENCH_ITEMS;
+
+	for(int i = 0; i < BENCH_ROUNDS; i++) {
+		start = __now();
+		if(fold)
+			free(dl_foldl(list, __sum, &zero));
+		else
+			dl_contains(list, &absent);
+		if(!i || __now() - start < best)
+			best = __now() - start;
+	}
+
+	return best;
+}
+
+static double bench_ul(unrolled_list list, bool fold)
+{
+	double start;
+	double best = 0;
+	uint64_t zero = 0;
+	uint64_t absent = BENCH_ITEMS;
+
+	for(int i = 0; i < BENCH_ROUNDS; i++) {
+		start = __now();
+		if(fold)
+			free(ul_foldl(list, __sum, &zero));
+		else
+			ul_contains(list, &absent);
+		if(!i || __now() - start < best)
+			best = __now() - start;
+	}
+
+	return best;
+}
+
+int main(void)
+{
+	double dl_time;
+	double ul_time;
+	double_list dl;
+	unrolled_list ul;
+
+	dl = dl_create(&props);
+	ul = ul_create(&props);
+
+	for(uint64_t i = 0; i < BENCH_ITEMS; i++) {
+		dl_push_tail(dl, &i);
+		ul_push_tail(ul, &i);
+	}
+
+	printf("traversals of %d elements, best of %d (ms)\n",
+	       BENCH_ITEMS, BENCH_ROUNDS);
+	printf("%10s %14s %14s %8s\n", "operation", "double_list",
+	       "unrolled_list", "speedup");
+
+	dl_time = bench_dl(dl, true);
+	ul_time = bench_ul(ul, true);
+	printf("%10s %14.2f %14.2f %7.2fx\n", "foldl",
+	       dl_time * 1e3, ul_time * 1e3, dl_time / ul_time);
+
+	dl_time = bench_dl(dl, false);
+	ul_time = bench_ul(ul, false);
+	printf("%10s %14.2f %14.2f %7.2fx\n", "contains",
+	       dl_time * 1e3, ul_time * 1e3, dl_time / ul_time);
+
+	/* Churn the lists: drop a random half of the elements, then push as
+	 * many again.  The new double list elements reuse the freed slots, so
+	 * the list no longer walks memory in order. */
+	dl_filter(dl, __coin);
+	ul_filter(ul, __coin);
+	for(uint64_t i = BENCH_ITEMS; ul_length(ul) < BENCH_ITEMS; i++) {
+		dl_push_tail(dl, &i);
+		ul_push_tail(ul, &i);
+	}
+
+	dl_time = bench_dl(dl, true);
+	ul_time = bench_ul(ul, true);
+	printf("%10s %14.2f %14.2f %7.2fx\n", "foldl*",
+	       dl_time * 1e3, ul_time * 1e3, dl_time / ul_time);
+
+	dl_time = bench_dl(dl, false);
+	ul_time = bench_ul(ul, false);
+	printf("%10s %14.2f %14.2f %7.2fx\n", "contains*",
+	       dl_time * 1e3, ul_time * 1e3, dl_time / ul_time);
+	printf("* after replacing a random half of the elements\n");
+
+	dl_free(&dl);
+	ul_free(&ul);
+
+	return 0;
+}
@@ -18,6 +18,7 @@
  */
 
 #include <check.h>
+#include <pthread.h>
 
 #include "list/double_list.h"
 
@@ -25,6 +26,15 @@ static const struct ds_properties props = {
 	.data_size = sizeof(uint8_t),
 };
 
+static const struct ds_properties props_int = {
+	.data_size = sizeof(int32_t),
+};
+
+static const struct ds_properties props_indexed = {
+	.data_size = sizeof(int32_t),
+	.indexed = true,
+};
+
 START_TEST(test_dl_alloc)
 {
 	int err;
@@ -471,6 +481,43 @@ START_TEST(test_dl_delete_multiple)
 }
 END_TEST
 
+START_TEST(test_dl_delete_recycle)
+{
+	uint8_t in1 = 1;
+	uint8_t in2 = 2;
+	uint8_t * out;
+	struct dl_element * first;
+	double_list list;
+
+	list = dl_create(&props);
+
+	/* A deleted element is reused by the next insertion. */
+	dl_push_tail(list, &in1);
+	first = DS_PRIV(list)->head;
+	ck_assert(dl_delete(list, 0));
+	dl_push_tail(list, &in2);
+	ck_assert_ptr_eq(DS_PRIV(list)->head, first);
+	ck_assert_int_eq(*(uint8_t *) DS_PRIV(list)->head->data, in2);
+
+	/* Span several slabs, then drain the list. */
+	for(size_t i = 0; i < 1000; i++)
+		dl_push_tail(list, &in1);
+	ck_assert_int_eq(DS_PRIV(list)->length, 1001);
+
+	out = dl_pop_head(list);
+	ck_assert_int_eq(*out, in2);
+	free(out);
+	for(size_t i = 0; i < 1000; i++) {
+		out = dl_pop_head(list);
+		ck_assert_int_eq(*out, in1);
+		free(out);
+	}
+	ck_assert(dl_null(list));
+
+	dl_free(&list);
+}
+END_TEST
+
 START_TEST(test_dl_remove_empty)
 {
 	void * val1;
@@ -1545,6 +1592,500 @@ START_TEST(test_dl_foldl_multiple)
 }
 END_TEST
 
+bool pred_not_div3(int32_t * n)
+{
+	return *n % 3 != 0;
+}
+
+bool pred_lt500(int32_t * n)
+{
+	return *n < 500;
+}
+
+/* Check every position of a list against a walk of the list. */
+static void check_positions(double_list list, const int32_t * model, size_t n)
+{
+	size_t i = 0;
+	struct dl_element * current;
+
+	ck_assert_int_eq(DS_PRIV(list)->length, n);
+	if(DS_PRIV(list)->index)
+		ck_assert_int_eq(rank_tree_size(DS_PRIV(list)->index), n);
+
+	linked_list_foreach(list, current) {
+		ck_assert_ptr_eq(dl_fetch(list, i), current->data);
+		ck_assert_int_eq(*(int32_t *) current->data, model[i]);
+		i++;
+	}
+	ck_assert(!dl_fetch(list, n));
+}
+
+/* Apply random positional edits to a list and a flat array together, and
+ * check that they agree throughout. */
+static void random_edits(const struct ds_properties * list_props)
+{
+	int32_t val;
+	int32_t * out;
+	size_t pos;
+	size_t n = 0;
+	size_t keep;
+	int32_t model[1024];
+	double_list list;
+
+	list = dl_create(list_props);
+	srand(7);
+
+	for(int32_t step = 0; step < 4000; step++) {
+		pos = (size_t) rand() % (n + 1);
+		switch(rand() % 6) {
+		case 0:
+			dl_push_head(list, &step);
+			memmove(model + 1, model, n * sizeof(*model));
+			model[0] = step;
+			n++;
+			break;
+		case 1:
+			dl_push_tail(list, &step);
+			model[n++] = step;
+			break;
+		case 2:
+		case 3:
+			ck_assert(dl_insert(list, &step, pos));
+			memmove(model + pos + 1, model + pos,
+				(n - pos) * sizeof(*model));
+			model[pos] = step;
+			n++;
+			break;
+		case 4:
+			if(pos == n)
+				break;
+			out = dl_remove(list, pos);
+			ck_assert_int_eq(*out, model[pos]);
+			free(out);
+			memmove(model + pos, model + pos + 1,
+				(n - pos - 1) * sizeof(*model));
+			n--;
+			break;
+		case 5:
+			if(rand() % 2)
+				out = dl_pop_head(list);
+			else
+				out = dl_pop_tail(list);
+			if(!out)
+				break;
+			if(*out == model[0])
+				memmove(model, model + 1, --n * sizeof(*model));
+			else
+				ck_assert_int_eq(*out, model[--n]);
+			free(out);
+			break;
+		}
+
+		if(n > 800) {
+			dl_reverse(list);
+			for(size_t i = 0; i < n / 2; i++) {
+				val = model[i];
+				model[i] = model[n - 1 - i];
+				model[n - 1 - i] = val;
+			}
+
+			dl_filter(list, (pred_fn) pred_not_div3);
+			keep = 0;
+			for(size_t i = 0; i < n; i++)
+				if(pred_not_div3(&model[i]))
+					model[keep++] = model[i];
+			n = keep;
+
+			check_positions(list, model, n);
+		}
+	}
+
+	check_positions(list, model, n);
+
+	/* drop_while and take_while trim the index from either end. */
+	dl_drop_while(list, (pred_fn) pred_lt500);
+	for(keep = 0; keep < n && model[keep] < 500; keep++) {}
+	memmove(model, model + keep, (n - keep) * sizeof(*model));
+	n -= keep;
+	check_positions(list, model, n);
+
+	dl_reverse(list);
+	for(size_t i = 0; i < n / 2; i++) {
+		val = model[i];
+		model[i] = model[n - 1 - i];
+		model[n - 1 - i] = val;
+	}
+	dl_take_while(list, (pred_fn) pred_not_div3);
+	for(keep = 0; keep < n && pred_not_div3(&model[keep]); keep++) {}
+	n = keep;
+	check_positions(list, model, n);
+
+	dl_free(&list);
+}
+
+START_TEST(test_dl_indexed)
+{
+	double_list list;
+
+	list = dl_create(&props_indexed);
+	ck_assert(DS_PRIV(list)->index);
+	dl_free(&list);
+
+	random_edits(&props_indexed);
+}
+END_TEST
+
+START_TEST(test_dl_finger)
+{
+	int32_t val;
+	double_list list;
+
+	random_edits(&props_int);
+
+	list = dl_create(&props_int);
+	for(val = 0; val < 100; val++)
+		dl_push_tail(list, &val);
+
+	/* Sequential lookups leave the finger on the last position. */
+	for(size_t i = 0; i < 100; i++) {
+		ck_assert_int_eq(*(int32_t *) dl_fetch(list, i), i);
+		ck_assert_int_eq(DS_PRIV(list)->finger_pos, i);
+	}
+	for(size_t i = 100; i-- > 0;)
+		ck_assert_int_eq(*(int32_t *) dl_fetch(list, i), i);
+
+	/* Edits before the finger shift it; removing its element moves it
+	 * back one. */
+	dl_fetch(list, 50);
+	val = -1;
+	dl_push_head(list, &val);
+	ck_assert_int_eq(DS_PRIV(list)->finger_pos, 51);
+	free(dl_pop_head(list));
+	ck_assert_int_eq(DS_PRIV(list)->finger_pos, 50);
+	ck_assert(dl_delete(list, 50));
+	ck_assert_int_eq(DS_PRIV(list)->finger_pos, 49);
+	ck_assert_int_eq(*(int32_t *) DS_PRIV(list)->finger->data, 49);
+	ck_assert_int_eq(*(int32_t *) dl_fetch(list, 50), 51);
+
+	dl_reverse(list);
+	ck_assert_int_eq(DS_PRIV(list)->finger_pos, 48);
+	ck_assert_int_eq(*(int32_t *) dl_fetch(list, 48), 51);
+
+	/* Bulk deletions forget the finger. */
+	dl_take_while(list, (pred_fn) pred_lt500);
+	ck_assert(DS_PRIV(list)->finger);
+	dl_drop_while(list, (pred_fn) pred_not_div3);
+	ck_assert(!DS_PRIV(list)->finger);
+
+	dl_free(&list);
+}
+END_TEST
+
+/* Orders values by their tens alone, so that equal keys can be told apart to
+ * check stability. */
+bool comp_tens(const int32_t * a, const int32_t * b)
+{
+	return (*a / 10) < (*b / 10);
+}
+
+/* Check that walking a list backwards visits the same elements as walking it
+ * forwards. */
+static void check_backwards(double_list list)
+{
+	size_t i = DS_PRIV(list)->length;
+	struct dl_element * current;
+
+	double_list_foreach_rev(list, current)
+		ck_assert_ptr_eq(dl_fetch(list, --i), current->data);
+	ck_assert_int_eq(i, 0);
+}
+
+static void sort_lists(const struct ds_properties * list_props)
+{
+	size_t i;
+	int32_t val;
+	int32_t model[300];
+	double_list list;
+
+	list = dl_create(list_props);
+
+	dl_sort(list, (comp_fn) comp_tens);
+	ck_assert(dl_null(list));
+
+	for(size_t n = 0; n < 300; n++) {
+		/* Sort after each push so that every length is covered, and
+		 * keep the model sorted with a stable insertion sort. */
+		val = (n * 7919) % 1000;
+		dl_push_tail(list, &val);
+
+		for(i = n; i > 0 && comp_tens(&val, &model[i - 1]); i--)
+			model[i] = model[i - 1];
+		model[i] = val;
+
+		dl_fetch(list, n / 2);
+		dl_sort(list, (comp_fn) comp_tens);
+		check_positions(list, model, n + 1);
+		check_backwards(list);
+	}
+
+	dl_free(&list);
+}
+
+START_TEST(test_dl_sort)
+{
+	sort_lists(&props_int);
+	sort_lists(&props_indexed);
+}
+END_TEST
+
+static void merge_lists(const struct ds_properties * list_props)
+{
+	size_t i, j, n = 0;
+	int32_t val;
+	int32_t a[200], b[150], model[350];
+	int32_t * out;
+	double_list dst, src;
+
+	dst = dl_create(list_props);
+	src = dl_create(list_props);
+
+	for(i = 0; i < 200; i++) {
+		a[i] = i * 5;
+		dl_push_tail(dst, &a[i]);
+	}
+	for(i = 0; i < 150; i++) {
+		b[i] = i * 7 + 1;
+		dl_push_tail(src, &b[i]);
+	}
+
+	/* Equal keys from @dst come first. */
+	for(i = 0, j = 0; i < 200 || j < 150;) {
+		if(j < 150 && (i == 200 || comp_tens(&b[j], &a[i])))
+			model[n++] = b[j++];
+		else
+			model[n++] = a[i++];
+	}
+
+	dl_fetch(dst, 100);
+	dl_fetch(src, 100);
+	ck_assert(dl_merge(dst, src, (comp_fn) comp_tens));
+	check_positions(dst, model, n);
+	check_backwards(dst);
+	check_positions(src, model, 0);
+	ck_assert(!DS_PRIV(src)->tail);
+
+	/* Both lists remain usable, and elements merged in from @src are
+	 * released by @dst. */
+	val = 7;
+	dl_push_tail(src, &val);
+	ck_assert_int_eq(*(int32_t *) dl_fetch(src, 0), 7);
+
+	while((out = dl_pop_tail(dst)))
+		free(out);
+	for(i = 0; i < 700; i++)
+		dl_push_head(dst, &val);
+	ck_assert_int_eq(DS_PRIV(dst)->length, 700);
+
+	errno = 0;
+	ck_assert(!dl_merge(dst, dst, (comp_fn) comp_tens));
+	ck_assert_int_eq(errno, EINVAL);
+
+	dl_free(&dst);
+	dl_free(&src);
+}
+
+START_TEST(test_dl_merge)
+{
+	merge_lists(&props_int);
+	merge_lists(&props_indexed);
+}
+END_TEST
+
+/* Repeatedly split a list at random positions and splice the pieces back in
+ * elsewhere, checking the list against a flat array throughout. */
+static void splice_lists(const struct ds_properties * list_props)
+{
+	size_t n = 0, pos, at, len;
+	int32_t val;
+	int32_t model[400], piece[400];
+	double_list list, rest;
+
+	list = dl_create(list_props);
+	for(val = 0; val < 400; val++) {
+		model[n++] = val;
+		dl_push_tail(list, &val);
+	}
+
+	srand(5);
+	for(size_t step = 0; step < 300; step++) {
+		pos = rand() % (n + 1);
+		dl_fetch(list, rand() % n);
+
+		rest = dl_split_at(list, pos);
+		ck_assert(rest);
+
+		len = n - pos;
+		memcpy(piece, model + pos, len * sizeof(*model));
+		n = pos;
+		check_positions(list, model, n);
+		check_positions(rest, piece, len);
+		check_backwards(rest);
+
+		if(rand() % 2) {
+			at = rand() % (n + 1);
+			ck_assert(dl_splice(list, at, rest));
+		} else {
+			at = n;
+			ck_assert(dl_concat(list, rest));
+		}
+
+		memmove(model + at + len, model + at,
+			(n - at) * sizeof(*model));
+		memcpy(model + at, piece, len * sizeof(*model));
+		n += len;
+
+		check_positions(list, model, n);
+		check_backwards(list);
+		check_positions(rest, piece, 0);
+		dl_free(&rest);
+	}
+
+	errno = 0;
+	ck_assert(!dl_split_at(list, n + 1));
+	ck_assert_int_eq(errno, EINVAL);
+
+	dl_free(&list);
+}
+
+START_TEST(test_dl_splice)
+{
+	int32_t val;
+	double_list dst, src;
+
+	splice_lists(&props_int);
+	splice_lists(&props_indexed);
+
+	dst = dl_create(&props_int);
+	src = dl_create(&props_int);
+	for(val = 0; val < 10; val++) {
+		dl_push_tail(dst, &val);
+		dl_push_tail(src, &val);
+	}
+
+	/* Splicing before the finger moves it up. */
+	dl_fetch(dst, 6);
+	ck_assert(dl_splice(dst, 0, src));
+	ck_assert_int_eq(DS_PRIV(dst)->finger_pos, 16);
+	ck_assert_int_eq(*(int32_t *) DS_PRIV(dst)->finger->data, 6);
+
+	errno = 0;
+	ck_assert(!dl_splice(dst, 21, src));
+	ck_assert_int_eq(errno, EINVAL);
+	errno = 0;
+	ck_assert(!dl_concat(dst, dst));
+	ck_assert_int_eq(errno, EINVAL);
+
+	dl_free(&dst);
+	dl_free(&src);
+}
+END_TEST
+
+START_TEST(test_dl_split_shared)
+{
+	int32_t val;
+	int32_t * kept;
+	int32_t * moved;
+	double_list list, rest, other;
+
+	list = dl_create(&props_int);
+	other = dl_create(&props_int);
+	for(val = 0; val < 100; val++)
+		dl_push_tail(list, &val);
+	for(val = -5; val < 0; val++)
+		dl_push_tail(other, &val);
+
+	/* Splitting relinks the elements in place, so the two halves share
+	 * the slab cache they were allocated from. */
+	kept = dl_fetch(list, 10);
+	moved = dl_fetch(list, 70);
+	rest = dl_split_at(list, 50);
+	ck_assert_ptr_eq(dl_fetch(list, 10), kept);
+	ck_assert_ptr_eq(dl_fetch(rest, 20), moved);
+	ck_assert_ptr_eq(DS_PRIV(rest)->slab, DS_PRIV(list)->slab);
+	ck_assert(slab_cache_shared(DS_PRIV(list)->slab));
+
+	/* Splicing the second half elsewhere moves the whole shared cache
+	 * along with it, and @list follows. */
+	ck_assert(dl_splice(other, 2, rest));
+	ck_assert_ptr_eq(dl_fetch(other, 22), moved);
+	ck_assert(slab_cache_shared(DS_PRIV(other)->slab));
+	dl_free(&rest);
+
+	for(val = 100; val < 200; val++)
+		dl_push_tail(list, &val);
+	for(val = 0; val < 50; val++)
+		free(dl_pop_tail(other));
+	dl_free(&other);
+
+	ck_assert(!slab_cache_shared(DS_PRIV(list)->slab));
+	for(val = 0; val < 150; val++) {
+		int32_t * out = dl_pop_head(list);
+
+		ck_assert_int_eq(*out, val < 50 ? val : val + 50);
+		free(out);
+	}
+
+	dl_free(&list);
+}
+END_TEST
+
+#define SHARED_OPS 50000
+
+static void * __shared_user(void * arg)
+{
+	double_list list = arg;
+	int32_t val;
+	int32_t * out;
+
+	for(val = 0; val < SHARED_OPS; val++) {
+		dl_push_tail(list, &val);
+		out = dl_pop_head(list);
+		free(out);
+	}
+
+	return NULL;
+}
+
+START_TEST(test_dl_split_threads)
+{
+	int32_t val;
+	double_list list, rest;
+	pthread_t threads[2];
+
+	list = dl_create(&props_int);
+	for(val = 0; val < 1000; val++)
+		dl_push_tail(list, &val);
+	rest = dl_split_at(list, 500);
+
+	/* Each list is only used by its own thread, but both allocate from
+	 * the cache they share. */
+	pthread_create(&threads[0], NULL, __shared_user, list);
+	pthread_create(&threads[1], NULL, __shared_user, rest);
+	pthread_join(threads[0], NULL);
+	pthread_join(threads[1], NULL);
+
+	ck_assert_int_eq(DS_PRIV(list)->length, 500);
+	ck_assert_int_eq(DS_PRIV(rest)->length, 500);
+	ck_assert(dl_concat(list, rest));
+	for(size_t i = 0; i < 1000; i++)
+		ck_assert_int_eq(*(int32_t *) dl_fetch(list, i),
+				 SHARED_OPS - 500 + i % 500);
+
+	dl_free(&rest);
+	dl_free(&list);
+}
+END_TEST
+
 Suite * dl_suite(void)
 {
 	Suite * suite;
@@ -1567,6 +2108,11 @@ Suite * dl_suite(void)
 	TCase * case_dl_map;
 	TCase * case_dl_reverse;
 	TCase * case_dl_foldl;
+	TCase * case_dl_indexed;
+	TCase * case_dl_finger;
+	TCase * case_dl_sort;
+	TCase * case_dl_merge;
+	TCase * case_dl_splice;
 	TCase * case_dl_foldr;
 
 	suite = suite_create("Linked List");
@@ -1591,6 +2137,11 @@ Suite * dl_suite(void)
 	case_dl_reverse = tcase_create("dl_reverse");
 	case_dl_foldl = tcase_create("dl_foldl");
 	case_dl_foldr = tcase_create("dl_foldr");
+	case_dl_indexed = tcase_create("dl_indexed");
+	case_dl_finger = tcase_create("dl_finger");
+	case_dl_sort = tcase_create("dl_sort");
+	case_dl_merge = tcase_create("dl_merge");
+	case_dl_splice = tcase_create("dl_splice");
 
 	tcase_add_test(case_dl_alloc, test_dl_alloc);
 	tcase_add_test(case_dl_null, test_dl_null_true);
@@ -1610,6 +2161,7 @@ Suite * dl_suite(void)
 	tcase_add_test(case_dl_delete, test_dl_delete_empty);
 	tcase_add_test(case_dl_delete, test_dl_delete_single);
 	tcase_add_test(case_dl_delete, test_dl_delete_multiple);
+	tcase_add_test(case_dl_delete, test_dl_delete_recycle);
 	tcase_add_test(case_dl_remove, test_dl_remove_empty);
 	tcase_add_test(case_dl_remove, test_dl_remove_single);
 	tcase_add_test(case_dl_remove, test_dl_remove_multiple);
@@ -1646,6 +2198,13 @@ Suite * dl_suite(void)
 	tcase_add_test(case_dl_foldl, test_dl_foldl_empty);
 	tcase_add_test(case_dl_foldl, test_dl_foldl_single);
 	tcase_add_test(case_dl_foldl, test_dl_foldl_multiple);
+	tcase_add_test(case_dl_indexed, test_dl_indexed);
+	tcase_add_test(case_dl_finger, test_dl_finger);
+	tcase_add_test(case_dl_sort, test_dl_sort);
+	tcase_add_test(case_dl_merge, test_dl_merge);
+	tcase_add_test(case_dl_splice, test_dl_splice);
+	tcase_add_test(case_dl_splice, test_dl_split_shared);
+	tcase_add_test(case_dl_splice, test_dl_split_threads);
 
 	suite_add_tcase(suite, case_dl_alloc);
 	suite_add_tcase(suite, case_dl_null);
@@ -1667,6 +2226,11 @@ Suite * dl_suite(void)
 	suite_add_tcase(suite, case_dl_reverse);
 	suite_add_tcase(suite, case_dl_foldr);
 	suite_add_tcase(suite, case_dl_foldl);
+	suite_add_tcase(suite, case_dl_indexed);
+	suite_add_tcase(suite, case_dl_finger);
+	suite_add_tcase(suite, case_dl_sort);
+	suite_add_tcase(suite, case_dl_merge);
+	suite_add_tcase(suite, case_dl_splice);
 
 	return suite;
 }
@@ -0,0 +1,246 @@
+/* intrusive_list.c - Unit Tests for Intrusive Linked Lists
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <check.h>
+
+#include "list/intrusive_list.h"
+
+struct object {
+	int value;
+	struct isl_link snode;
+	struct idl_link dnode;
+};
+
+START_TEST(test_isl_alloc)
+{
+	isingle_list list;
+
+	list = isl_create();
+	ck_assert(list);
+	ck_assert(isl_null(list));
+
+	isl_free(&list);
+	ck_assert(!list);
+}
+END_TEST
+
+START_TEST(test_isl_push_pop)
+{
+	struct object objs[3] = {{.value = 1}, {.value = 2}, {.value = 3}};
+	struct isl_link * link;
+	struct object * obj;
+	int expected = 1;
+	isingle_list list;
+
+	list = isl_create();
+
+	/* [1, 2, 3] */
+	isl_push_tail(list, &objs[1].snode);
+	isl_push_head(list, &objs[0].snode);
+	isl_push_tail(list, &objs[2].snode);
+	ck_assert_int_eq(isl_length(list), 3);
+
+	intrusive_list_foreach(list, link, obj, snode) {
+		ck_assert_ptr_eq(obj, &objs[expected - 1]);
+		ck_assert_int_eq(obj->value, expected++);
+	}
+	ck_assert(!link);
+
+	link = isl_pop_head(list);
+	obj = intrusive_list_entry(link, struct object, snode);
+	ck_assert_ptr_eq(obj, &objs[0]);
+
+	isl_pop_head(list);
+	isl_pop_head(list);
+	ck_assert(isl_null(list));
+	ck_assert(!DS_PRIV(list)->tail);
+	ck_assert(!isl_pop_head(list));
+
+	isl_free(&list);
+}
+END_TEST
+
+START_TEST(test_isl_insert_remove_after)
+{
+	struct object objs[3] = {{.value = 1}, {.value = 2}, {.value = 3}};
+	isingle_list list;
+
+	list = isl_create();
+
+	/* [] -> [2] -> [2, 3] -> [1, 2, 3] */
+	isl_insert_after(list, NULL, &objs[1].snode);
+	isl_insert_after(list, &objs[1].snode, &objs[2].snode);
+	isl_insert_after(list, NULL, &objs[0].snode);
+	ck_assert_ptr_eq(DS_PRIV(list)->head, &objs[0].snode);
+	ck_assert_ptr_eq(DS_PRIV(list)->tail, &objs[2].snode);
+
+	/* [1, 2, 3] -> [1, 2] */
+	ck_assert_ptr_eq(isl_remove_after(list, &objs[1].snode),
+			 &objs[2].snode);
+	ck_assert_ptr_eq(DS_PRIV(list)->tail, &objs[1].snode);
+	ck_assert(!isl_remove_after(list, &objs[1].snode));
+
+	/* [1, 2] -> [2] */
+	ck_assert_ptr_eq(isl_remove_after(list, NULL), &objs[0].snode);
+	ck_assert_int_eq(isl_length(list), 1);
+
+	isl_free(&list);
+}
+END_TEST
+
+START_TEST(test_idl_push_pop)
+{
+	struct object objs[3] = {{.value = 1}, {.value = 2}, {.value = 3}};
+	struct idl_link * link;
+	struct object * obj;
+	int expected = 3;
+	idouble_list list;
+
+	list = idl_create();
+
+	/* [1, 2, 3] */
+	idl_push_tail(list, &objs[1].dnode);
+	idl_push_head(list, &objs[0].dnode);
+	idl_push_tail(list, &objs[2].dnode);
+	ck_assert_int_eq(idl_length(list), 3);
+
+	intrusive_list_foreach_rev(list, link, obj, dnode)
+		ck_assert_int_eq(obj->value, expected--);
+	ck_assert_int_eq(expected, 0);
+
+	link = idl_pop_tail(list);
+	ck_assert_ptr_eq(intrusive_list_entry(link, struct object, dnode),
+			 &objs[2]);
+	link = idl_pop_head(list);
+	ck_assert_ptr_eq(intrusive_list_entry(link, struct object, dnode),
+			 &objs[0]);
+	ck_assert_ptr_eq(DS_PRIV(list)->head, DS_PRIV(list)->tail);
+
+	idl_pop_head(list);
+	ck_assert(idl_null(list));
+	ck_assert(!idl_pop_tail(list));
+
+	idl_free(&list);
+}
+END_TEST
+
+START_TEST(test_idl_insert_delete)
+{
+	struct object objs[4] = {
+		{.value = 1}, {.value = 2}, {.value = 3}, {.value = 4}
+	};
+	struct idl_link * link;
+	struct object * obj;
+	int expected = 1;
+	idouble_list list;
+
+	list = idl_create();
+
+	/* [] -> [2] -> [2, 4] -> [1, 2, 4] -> [1, 2, 3, 4] */
+	idl_insert_before(list, NULL, &objs[1].dnode);
+	idl_insert_after(list, &objs[1].dnode, &objs[3].dnode);
+	idl_insert_after(list, NULL, &objs[0].dnode);
+	idl_insert_before(list, &objs[3].dnode, &objs[2].dnode);
+
+	intrusive_list_foreach(list, link, obj, dnode)
+		ck_assert_int_eq(obj->value, expected++);
+	ck_assert_int_eq(expected, 5);
+
+	/* Unlink every even object while walking the list. */
+	intrusive_list_foreach_safe(list, link, obj, dnode) {
+		if(obj->value % 2 == 0)
+			idl_delete(list, link);
+	}
+
+	ck_assert_int_eq(idl_length(list), 2);
+	ck_assert_ptr_eq(DS_PRIV(list)->head, &objs[0].dnode);
+	ck_assert_ptr_eq(DS_PRIV(list)->tail, &objs[2].dnode);
+	ck_assert_ptr_eq(objs[0].dnode.next, &objs[2].dnode);
+	ck_assert_ptr_eq(objs[2].dnode.prev, &objs[0].dnode);
+
+	idl_free(&list);
+}
+END_TEST
+
+START_TEST(test_intrusive_multiple_lists)
+{
+	struct object objs[2] = {{.value = 1}, {.value = 2}};
+	struct isl_link * slink;
+	struct idl_link * dlink;
+	struct object * obj;
+	isingle_list slist;
+	idouble_list dlist;
+
+	/* The same objects sit on both lists, in opposite orders. */
+	slist = isl_create();
+	dlist = idl_create();
+	isl_push_tail(slist, &objs[0].snode);
+	isl_push_tail(slist, &objs[1].snode);
+	idl_push_head(dlist, &objs[0].dnode);
+	idl_push_head(dlist, &objs[1].dnode);
+
+	slink = isl_pop_head(slist);
+	dlink = idl_pop_head(dlist);
+	obj = intrusive_list_entry(slink, struct object, snode);
+	ck_assert_int_eq(obj->value, 1);
+	obj = intrusive_list_entry(dlink, struct object, dnode);
+	ck_assert_int_eq(obj->value, 2);
+
+	isl_free(&slist);
+	idl_free(&dlist);
+}
+END_TEST
+
+Suite * intrusive_list_suite(void)
+{
+	Suite * suite;
+	TCase * case_isl;
+	TCase * case_idl;
+
+	suite = suite_create("Intrusive List");
+
+	case_isl = tcase_create("isl");
+	case_idl = tcase_create("idl");
+
+	tcase_add_test(case_isl, test_isl_alloc);
+	tcase_add_test(case_isl, test_isl_push_pop);
+	tcase_add_test(case_isl, test_isl_insert_remove_after);
+	tcase_add_test(case_idl, test_idl_push_pop);
+	tcase_add_test(case_idl, test_idl_insert_delete);
+	tcase_add_test(case_idl, test_intrusive_multiple_lists);
+
+	suite_add_tcase(suite, case_isl);
+	suite_add_tcase(suite, case_idl);
+
+	return suite;
+}
+
+int main(void)
+{
+	Suite * suite_il;
+	SRunner * suite_runner;
+
+	suite_il = intrusive_list_suite();
+
+	suite_runner = srunner_create(suite_il);
+	srunner_run_all(suite_runner, CK_NORMAL);
+	srunner_free(suite_runner);
+
+	return 0;
+}
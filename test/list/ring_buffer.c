@@ -18,6 +18,10 @@
  */
 
 #include <check.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "list/ring_buffer.h"
 
@@ -26,6 +30,29 @@ static const struct ds_properties props = {
 	.entries   = 10,              /* 10 Data Blocks. */
 };
 
+static const struct ds_properties props_batch = {
+	.data_size = sizeof(uint32_t), /* Data size is 4B. */
+	.entries   = 8,                /* 8 Data Blocks. */
+};
+
+static const struct ds_properties props_spsc = {
+	.data_size   = sizeof(uint32_t), /* Data size is 4B. */
+	.entries     = 10,               /* 10 Data Blocks. */
+	.concurrency = DS_SPSC,
+};
+
+static const struct ds_properties props_mpmc = {
+	.data_size   = sizeof(uint32_t), /* Data size is 4B. */
+	.entries     = 10,               /* 10 Data Blocks. */
+	.concurrency = DS_MPMC,
+};
+
+static const struct ds_properties props_broadcast = {
+	.data_size   = sizeof(uint32_t), /* Data size is 4B. */
+	.entries     = 4,                /* 4 Data Blocks. */
+	.concurrency = DS_BROADCAST,
+};
+
 START_TEST(test_rb_create)
 {
 	ring_buffer buf;
@@ -38,6 +65,20 @@ START_TEST(test_rb_create)
 }
 END_TEST
 
+START_TEST(test_rb_create_layout)
+{
+	errno = 0;
+	ck_assert(!__rb_create(&props, RB_CACHELINE_SIZE / 2));
+	ck_assert_int_eq(errno, EINVAL);
+
+	errno = 0;
+	ck_assert(!__rb_create_shared("/focs-test-layout", &props_spsc,
+				      RB_CACHELINE_SIZE * 2));
+	ck_assert_int_eq(errno, EINVAL);
+	ck_assert(!rb_unlink_shared("/focs-test-layout"));
+}
+END_TEST
+
 START_TEST(test_rb_push_head_single)
 {
 	bool success;
@@ -356,6 +397,64 @@ START_TEST(test_rb_insert_multiple)
 }
 END_TEST
 
+START_TEST(test_rb_insert_shift)
+{
+	uint32_t in[] = {0, 1, 2, 3, 4, 5};
+	uint32_t front = 100;
+	uint32_t back = 200;
+	uint32_t expect[] = {0, 100, 1, 2, 3, 200, 4, 5};
+	uint32_t out[8];
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+	rb_push_tail_n(buf, in, 6);
+
+	/* One insertion shifts the head side, the other the tail side. */
+	ck_assert(rb_insert(buf, &front, 1));
+	ck_assert(rb_insert(buf, &back, 5));
+
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 8), 8);
+	for(size_t i = 0; i < 8; i++)
+		ck_assert_int_eq(out[i], expect[i]);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_insert_wrap)
+{
+	uint32_t in[7] = { 0, 1, 2, 3, 4, 5, 6 };
+	uint32_t out[8];
+	uint32_t val = 100;
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+
+	/* Try every insertion point with the contents starting at every slot,
+	 * so that both shifts have to cross the end of the data region. */
+	for(size_t offset = 0; offset < 8; offset++) {
+		for(size_t pos = 0; pos < 7; pos++) {
+			size_t j = 0;
+
+			rb_push_tail_n(buf, in, offset);
+			rb_pop_head_n(buf, out, offset);
+			rb_push_tail_n(buf, in, 7);
+
+			ck_assert(rb_insert(buf, &val, pos));
+			ck_assert_int_eq(rb_pop_head_n(buf, out, 8), 8);
+			for(size_t i = 0; i < 8; i++) {
+				if(i == pos)
+					ck_assert_int_eq(out[i], val);
+				else
+					ck_assert_int_eq(out[i], in[j++]);
+			}
+		}
+	}
+
+	rb_destroy(&buf);
+}
+END_TEST
+
 START_TEST(test_rb_fetch_empty)
 {
 	uint8_t * out[2];
@@ -421,6 +520,1801 @@ START_TEST(test_rb_fetch_multiple)
 }
 END_TEST
 
+START_TEST(test_rb_pop_head_into)
+{
+	uint8_t in[] = {1, 2};
+	uint8_t out;
+	ring_buffer buf;
+
+	buf = rb_create(&props);
+	rb_push_tail(buf, &in[0]);
+	rb_push_tail(buf, &in[1]);
+
+	ck_assert(rb_pop_head_into(buf, &out));
+	ck_assert_int_eq(out, in[0]);
+	ck_assert(rb_pop_head_into(buf, &out));
+	ck_assert_int_eq(out, in[1]);
+	ck_assert(!rb_pop_head_into(buf, &out));
+	ck_assert_int_eq(errno, EFAULT);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_pop_tail_into)
+{
+	uint8_t in[] = {1, 2};
+	uint8_t out;
+	ring_buffer buf;
+
+	buf = rb_create(&props);
+	rb_push_tail(buf, &in[0]);
+	rb_push_tail(buf, &in[1]);
+
+	ck_assert(rb_pop_tail_into(buf, &out));
+	ck_assert_int_eq(out, in[1]);
+	ck_assert(rb_pop_tail_into(buf, &out));
+	ck_assert_int_eq(out, in[0]);
+	ck_assert(!rb_pop_tail_into(buf, &out));
+	ck_assert_int_eq(errno, EFAULT);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_fetch_into)
+{
+	uint8_t in[] = {1, 2, 3};
+	uint8_t out;
+	ring_buffer buf;
+
+	buf = rb_create(&props);
+	ck_assert(!rb_fetch_into(buf, 0, &out));
+	ck_assert_int_eq(errno, EFAULT);
+
+	rb_push_tail(buf, &in[0]);
+	rb_push_tail(buf, &in[1]);
+	rb_push_tail(buf, &in[2]);
+
+	ck_assert(rb_fetch_into(buf, 1, &out));
+	ck_assert_int_eq(out, in[1]);
+	ck_assert(rb_fetch_into(buf, -1, &out));
+	ck_assert_int_eq(out, in[2]);
+	ck_assert_int_eq(rb_size(buf), 3);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_peek)
+{
+	uint8_t in[] = {1, 2};
+	uint8_t * addr;
+	ring_buffer buf;
+
+	buf = rb_create(&props);
+	ck_assert(!rb_peek(buf, 0));
+	ck_assert_int_eq(errno, EFAULT);
+
+	rb_push_tail(buf, &in[0]);
+	rb_push_tail(buf, &in[1]);
+
+	addr = rb_peek(buf, 1);
+	ck_assert(addr);
+	ck_assert_int_eq(*addr, in[1]);
+	ck_assert(addr >= (uint8_t *) DS_PRIV(buf)->data);
+	ck_assert(addr < (uint8_t *) DS_PRIV(buf)->data + props.entries);
+	rb_peek_release(buf);
+
+	/* The buffer must be writable again after release. */
+	ck_assert(rb_push_tail(buf, &in[0]));
+	ck_assert_int_eq(rb_size(buf), 3);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_peek)
+{
+	uint32_t in[] = {1, 2};
+	uint32_t out;
+	uint32_t * addr;
+	ring_buffer buf;
+
+	buf = rb_create(&props_spsc);
+	rb_push_tail(buf, &in[0]);
+	rb_push_tail(buf, &in[1]);
+
+	addr = rb_peek(buf, 0);
+	ck_assert(addr);
+	ck_assert_int_eq(*addr, in[0]);
+	rb_peek_release(buf);
+
+	ck_assert(rb_fetch_into(buf, 1, &out));
+	ck_assert_int_eq(out, in[1]);
+	ck_assert(rb_pop_head_into(buf, &out));
+	ck_assert_int_eq(out, in[0]);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_push_tail_n)
+{
+	uint32_t in[10];
+	uint32_t out[10];
+	ring_buffer buf;
+
+	for(uint32_t i = 0; i < 10; i++)
+		in[i] = i;
+
+	/* Move the head to the middle so the batch has to wrap. */
+	buf = rb_create(&props_batch);
+	for(size_t i = 0; i < 5; i++) {
+		rb_push_tail(buf, &in[0]);
+		rb_pop_head_into(buf, &out[0]);
+	}
+
+	ck_assert_int_eq(rb_push_tail_n(buf, in, 10), props_batch.entries);
+	ck_assert(rb_full(buf));
+	ck_assert_int_eq(rb_push_tail_n(buf, in, 1), 0);
+	ck_assert_int_eq(errno, ENOBUFS);
+
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 10), props_batch.entries);
+	for(size_t i = 0; i < props_batch.entries; i++)
+		ck_assert_int_eq(out[i], in[i]);
+
+	ck_assert(rb_empty(buf));
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 1), 0);
+	ck_assert_int_eq(errno, EFAULT);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_push_head_n)
+{
+	uint32_t in[] = {1, 2, 3};
+	uint32_t last = 4;
+	uint32_t out[4];
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+	rb_push_head(buf, &last);
+
+	/* Create list: [1, 2, 3, 4] */
+	ck_assert_int_eq(rb_push_head_n(buf, in, 3), 3);
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 4), 4);
+
+	ck_assert_int_eq(out[0], in[0]);
+	ck_assert_int_eq(out[1], in[1]);
+	ck_assert_int_eq(out[2], in[2]);
+	ck_assert_int_eq(out[3], last);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_pop_tail_n)
+{
+	uint32_t in[] = {1, 2, 3, 4, 5};
+	uint32_t out[3];
+	uint32_t rest;
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+	rb_push_tail_n(buf, in, 5);
+
+	ck_assert_int_eq(rb_pop_tail_n(buf, out, 3), 3);
+	ck_assert_int_eq(out[0], in[2]);
+	ck_assert_int_eq(out[1], in[3]);
+	ck_assert_int_eq(out[2], in[4]);
+	ck_assert_int_eq(rb_size(buf), 2);
+
+	ck_assert(rb_pop_tail_into(buf, &rest));
+	ck_assert_int_eq(rest, in[1]);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_push_tail_n_overwrite)
+{
+	uint32_t in[12];
+	uint32_t out[8];
+	ring_buffer buf;
+	struct ds_properties props_overwrite = props_batch;
+
+	for(uint32_t i = 0; i < 12; i++)
+		in[i] = i;
+
+	props_overwrite.overwrite = true;
+	buf = rb_create(&props_overwrite);
+	rb_push_tail_n(buf, in, 3);
+
+	/* Only the newest 8 blocks survive. */
+	ck_assert_int_eq(rb_push_tail_n(buf, in, 12), 12);
+	ck_assert(rb_full(buf));
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 8), 8);
+	for(size_t i = 0; i < 8; i++)
+		ck_assert_int_eq(out[i], in[i + 4]);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_batch)
+{
+	uint32_t in[12];
+	uint32_t out[12];
+	ring_buffer buf;
+
+	for(uint32_t i = 0; i < 12; i++)
+		in[i] = i;
+
+	buf = rb_create(&props_spsc);
+	rb_push_tail_n(buf, in, 7);
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 7), 7);
+
+	/* The counters now sit at slot 7 of 10, so this batch wraps. */
+	ck_assert_int_eq(rb_push_tail_n(buf, in, 12), props_spsc.entries);
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 12), props_spsc.entries);
+	for(size_t i = 0; i < props_spsc.entries; i++)
+		ck_assert_int_eq(out[i], in[i]);
+
+	ck_assert_int_eq(rb_push_head_n(buf, in, 1), 0);
+	ck_assert_int_eq(errno, ENOTSUP);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_pow2_auto)
+{
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+
+	ck_assert_int_eq(DS_PRIV(buf)->capacity, 8);
+	ck_assert_int_eq(DS_PRIV(buf)->mask, 7);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_pow2_requested)
+{
+	uint32_t in = 1;
+	ring_buffer buf;
+	struct ds_properties props_pow2 = props_batch;
+
+	props_pow2.entries = 5;
+	props_pow2.power_of_two = true;
+	buf = rb_create(&props_pow2);
+
+	ck_assert_int_eq(DS_PRIV(buf)->capacity, 8);
+	ck_assert_int_eq(DS_PRIV(buf)->mask, 7);
+
+	for(size_t i = 0; i < 8; i++)
+		ck_assert(rb_push_tail(buf, &in));
+	ck_assert(rb_full(buf));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+/* Run the same mixed sequence of operations on a buffer with a power of two
+ * capacity and one without, and make sure both see the same contents. */
+static void __check_wrap(size_t entries)
+{
+	uint32_t out;
+	ring_buffer buf;
+	struct ds_properties props_wrap = props_batch;
+
+	props_wrap.entries = entries;
+	buf = rb_create(&props_wrap);
+
+	for(uint32_t i = 0; i < 100; i++) {
+		uint32_t val = i;
+
+		ck_assert(rb_push_head(buf, &val));
+		ck_assert(rb_push_tail(buf, &val));
+		ck_assert(rb_pop_head_into(buf, &out));
+		ck_assert_int_eq(out, val);
+		ck_assert(rb_pop_tail_into(buf, &out));
+		ck_assert_int_eq(out, val);
+	}
+
+	for(uint32_t i = 0; i < entries; i++)
+		ck_assert(rb_push_head(buf, &i));
+	for(uint32_t i = 0; i < entries; i++) {
+		ck_assert(rb_fetch_into(buf, i, &out));
+		ck_assert_int_eq(out, entries - 1 - i);
+	}
+
+	rb_destroy(&buf);
+}
+
+START_TEST(test_rb_pow2_wrap)
+{
+	__check_wrap(8);
+	__check_wrap(7);
+}
+END_TEST
+
+START_TEST(test_rb_push_head_overwrite)
+{
+	uint32_t in[] = {1, 2, 3};
+	uint32_t out[2];
+	ring_buffer buf;
+	struct ds_properties props_overwrite = props_batch;
+
+	props_overwrite.entries = 2;
+	props_overwrite.overwrite = true;
+	buf = rb_create(&props_overwrite);
+
+	/* Pushing onto the head of a full buffer drops the tail. */
+	rb_push_head(buf, &in[0]);
+	rb_push_head(buf, &in[1]);
+	ck_assert(rb_push_head(buf, &in[2]));
+	ck_assert_int_eq(rb_size(buf), 2);
+
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 2), 2);
+	ck_assert_int_eq(out[0], in[2]);
+	ck_assert_int_eq(out[1], in[1]);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_create_overwrite)
+{
+	ring_buffer buf;
+	struct ds_properties bad = props_spsc;
+
+	bad.overwrite = true;
+	buf = rb_create(&bad);
+
+	ck_assert(!buf);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_fifo)
+{
+	uint32_t in[] = {1, 2, 3};
+	uint32_t * out[3];
+	ring_buffer buf;
+
+	buf = rb_create(&props_spsc);
+
+	ck_assert(rb_push_tail(buf, &in[0]));
+	ck_assert(rb_push_tail(buf, &in[1]));
+	ck_assert(rb_push_tail(buf, &in[2]));
+	ck_assert_int_eq(rb_size(buf), 3);
+
+	out[0] = rb_fetch(buf, 1);
+	ck_assert(out[0]);
+	ck_assert_int_eq(*out[0], in[1]);
+	free(out[0]);
+
+	out[0] = rb_pop_head(buf);
+	out[1] = rb_pop_head(buf);
+	out[2] = rb_pop_head(buf);
+
+	ck_assert_int_eq(*out[0], in[0]);
+	ck_assert_int_eq(*out[1], in[1]);
+	ck_assert_int_eq(*out[2], in[2]);
+	ck_assert(rb_empty(buf));
+	ck_assert(!rb_pop_head(buf));
+	ck_assert_int_eq(errno, EFAULT);
+
+	free(out[0]);
+	free(out[1]);
+	free(out[2]);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_full)
+{
+	uint32_t in = 7;
+	uint32_t * out;
+	ring_buffer buf;
+
+	buf = rb_create(&props_spsc);
+
+	/* Wrap the counters around the buffer a few times. */
+	for(size_t i = 0; i < 3 * props_spsc.entries; i++) {
+		ck_assert(rb_push_tail(buf, &in));
+		free(rb_pop_head(buf));
+	}
+
+	for(size_t i = 0; i < props_spsc.entries; i++)
+		ck_assert(rb_push_tail(buf, &in));
+
+	ck_assert(rb_full(buf));
+	ck_assert(!rb_push_tail(buf, &in));
+	ck_assert_int_eq(errno, ENOBUFS);
+
+	out = rb_pop_head(buf);
+	ck_assert_int_eq(*out, in);
+	ck_assert(!rb_full(buf));
+
+	free(out);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_unsupported)
+{
+	uint32_t in = 1;
+	ring_buffer buf;
+
+	buf = rb_create(&props_spsc);
+
+	ck_assert(!rb_push_head(buf, &in));
+	ck_assert_int_eq(errno, ENOTSUP);
+	ck_assert(!rb_insert(buf, &in, 0));
+	ck_assert_int_eq(errno, ENOTSUP);
+	ck_assert(!rb_pop_tail(buf));
+	ck_assert_int_eq(errno, ENOTSUP);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+#define SPSC_STREAM_LENGTH 100000
+
+static void * __spsc_producer(void * arg)
+{
+	ring_buffer buf = arg;
+
+	for(uint32_t i = 0; i < SPSC_STREAM_LENGTH; i++) {
+		while(!rb_push_tail(buf, &i))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+START_TEST(test_rb_spsc_layout)
+{
+	ring_buffer buf;
+	struct ring_buffer_priv * priv;
+	size_t line_head, line_write, line_read;
+
+	buf = rb_create(&props_spsc);
+	priv = DS_PRIV(buf);
+
+	/* Producer state, consumer state and the locked buffer's counters must
+	 * never share a cache line. */
+	line_head  = (size_t) &priv->head / RB_CACHELINE_SIZE;
+	line_write = (size_t) &priv->local.write / RB_CACHELINE_SIZE;
+	line_read  = (size_t) &priv->local.read / RB_CACHELINE_SIZE;
+	ck_assert_uint_ne(line_head, line_write);
+	ck_assert_uint_ne(line_write, line_read);
+	ck_assert_uint_ne(line_read, line_head);
+	ck_assert_uint_eq((size_t) &priv->local.read % RB_CACHELINE_SIZE, 0);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_threads)
+{
+	pthread_t producer;
+	uint32_t * out;
+	ring_buffer buf;
+
+	buf = rb_create(&props_spsc);
+	pthread_create(&producer, NULL, __spsc_producer, buf);
+
+	for(uint32_t i = 0; i < SPSC_STREAM_LENGTH; i++) {
+		while(!(out = rb_pop_head(buf)))
+			sched_yield();
+
+		ck_assert_int_eq(*out, i);
+		free(out);
+	}
+
+	pthread_join(producer, NULL);
+	ck_assert(rb_empty(buf));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_mpmc_fifo)
+{
+	uint32_t in[] = {1, 2, 3};
+	uint32_t * out[3];
+	ring_buffer buf;
+
+	buf = rb_create(&props_mpmc);
+
+	ck_assert(rb_push_tail(buf, &in[0]));
+	ck_assert(rb_push_tail(buf, &in[1]));
+	ck_assert(rb_push_tail(buf, &in[2]));
+	ck_assert_int_eq(rb_size(buf), 3);
+
+	out[0] = rb_pop_head(buf);
+	out[1] = rb_pop_head(buf);
+	out[2] = rb_pop_head(buf);
+
+	ck_assert_int_eq(*out[0], in[0]);
+	ck_assert_int_eq(*out[1], in[1]);
+	ck_assert_int_eq(*out[2], in[2]);
+	ck_assert(rb_empty(buf));
+	ck_assert(!rb_pop_head(buf));
+	ck_assert_int_eq(errno, EFAULT);
+
+	free(out[0]);
+	free(out[1]);
+	free(out[2]);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_mpmc_full)
+{
+	uint32_t in = 7;
+	uint32_t * out;
+	ring_buffer buf;
+
+	buf = rb_create(&props_mpmc);
+
+	for(size_t i = 0; i < 3 * props_mpmc.entries; i++) {
+		ck_assert(rb_push_tail(buf, &in));
+		free(rb_pop_head(buf));
+	}
+
+	for(size_t i = 0; i < props_mpmc.entries; i++)
+		ck_assert(rb_push_tail(buf, &in));
+
+	ck_assert(rb_full(buf));
+	ck_assert(!rb_push_tail(buf, &in));
+	ck_assert_int_eq(errno, ENOBUFS);
+
+	out = rb_pop_head(buf);
+	ck_assert_int_eq(*out, in);
+	ck_assert(rb_push_tail(buf, &in));
+
+	free(out);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_mpmc_unsupported)
+{
+	uint32_t in = 1;
+	ring_buffer buf;
+
+	buf = rb_create(&props_mpmc);
+	rb_push_tail(buf, &in);
+
+	ck_assert(!rb_fetch(buf, 0));
+	ck_assert_int_eq(errno, ENOTSUP);
+	ck_assert(!rb_push_head(buf, &in));
+	ck_assert_int_eq(errno, ENOTSUP);
+	ck_assert(!rb_pop_tail(buf));
+	ck_assert_int_eq(errno, ENOTSUP);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+#define MPMC_THREADS       4
+#define MPMC_STREAM_LENGTH 20000
+
+static atomic_size_t mpmc_popped;
+static atomic_uchar mpmc_seen[MPMC_THREADS * MPMC_STREAM_LENGTH];
+
+static void * __mpmc_producer(void * arg)
+{
+	ring_buffer buf = arg;
+	static atomic_uint next_id;
+	uint32_t id = atomic_fetch_add(&next_id, 1);
+
+	for(uint32_t i = 0; i < MPMC_STREAM_LENGTH; i++) {
+		uint32_t val = id * MPMC_STREAM_LENGTH + i;
+
+		while(!rb_push_tail(buf, &val))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void * __mpmc_consumer(void * arg)
+{
+	ring_buffer buf = arg;
+	uint32_t * out;
+
+	while(atomic_load(&mpmc_popped) < MPMC_THREADS * MPMC_STREAM_LENGTH) {
+		out = rb_pop_head(buf);
+		if(!out) {
+			sched_yield();
+			continue;
+		}
+
+		atomic_fetch_add(&mpmc_seen[*out], 1);
+		atomic_fetch_add(&mpmc_popped, 1);
+		free(out);
+	}
+
+	return NULL;
+}
+
+START_TEST(test_rb_mpmc_threads)
+{
+	pthread_t producers[MPMC_THREADS];
+	pthread_t consumers[MPMC_THREADS];
+	ring_buffer buf;
+
+	buf = rb_create(&props_mpmc);
+
+	for(size_t i = 0; i < MPMC_THREADS; i++) {
+		pthread_create(&producers[i], NULL, __mpmc_producer, buf);
+		pthread_create(&consumers[i], NULL, __mpmc_consumer, buf);
+	}
+
+	for(size_t i = 0; i < MPMC_THREADS; i++) {
+		pthread_join(producers[i], NULL);
+		pthread_join(consumers[i], NULL);
+	}
+
+	/* Every element must have been popped exactly once. */
+	for(size_t i = 0; i < MPMC_THREADS * MPMC_STREAM_LENGTH; i++)
+		ck_assert_int_eq(mpmc_seen[i], 1);
+	ck_assert(rb_empty(buf));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_mirrored_create)
+{
+	ring_buffer buf;
+	struct ds_properties props_mirrored = props_batch;
+
+	props_mirrored.mirrored = true;
+	buf = rb_create(&props_mirrored);
+	ck_assert_ptr_ne(buf, NULL);
+
+	/* The capacity must fill whole pages, and must still be at least the
+	 * number of entries requested. */
+	ck_assert_uint_ge(DS_PRIV(buf)->capacity, props_batch.entries);
+	ck_assert_uint_eq(DS_PRIV(buf)->capacity * props_batch.data_size %
+			  sysconf(_SC_PAGESIZE), 0);
+
+	if(rb_backing(buf) & RB_BACKING_MIRRORED) {
+		/* Slot `i` and slot `i + capacity` are the same memory. */
+		uint32_t * data = DS_PRIV(buf)->data;
+		size_t capacity = DS_PRIV(buf)->capacity;
+
+		data[3] = 0xDEADBEEF;
+		ck_assert_uint_eq(data[capacity + 3], 0xDEADBEEF);
+	}
+
+	rb_destroy(&buf);
+
+	buf = rb_create(&props_batch);
+	ck_assert_uint_eq(rb_backing(buf), RB_BACKING_HEAP);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_backing_pinned)
+{
+	uint32_t in[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	uint32_t out[8];
+	ring_buffer buf;
+	struct ds_properties props_pinned = props_batch;
+
+	props_pinned.huge_pages = true;
+	props_pinned.prefault = true;
+	props_pinned.lock_memory = true;
+	buf = rb_create(&props_pinned);
+	ck_assert_ptr_ne(buf, NULL);
+
+	/* Huge pages and locking depend on the system, but whatever was
+	 * obtained, the data region is faulted in. */
+	ck_assert(rb_backing(buf) & RB_BACKING_PREFAULTED);
+	ck_assert(!(rb_backing(buf) & RB_BACKING_MIRRORED));
+	if(rb_backing(buf) & (RB_BACKING_HUGETLB | RB_BACKING_HUGEPAGE))
+		ck_assert_uint_eq((uintptr_t) DS_PRIV(buf)->data %
+				  sysconf(_SC_PAGESIZE), 0);
+
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 8), 8);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 8), 8);
+	for(uint32_t i = 0; i < 8; i++)
+		ck_assert_uint_eq(out[i], in[i]);
+	rb_destroy(&buf);
+
+	/* Mirrored buffers can still be prefaulted, through both views. */
+	props_pinned.mirrored = true;
+	buf = rb_create(&props_pinned);
+	ck_assert(rb_backing(buf) & RB_BACKING_PREFAULTED);
+	ck_assert(!(rb_backing(buf) & (RB_BACKING_HUGETLB |
+				       RB_BACKING_HUGEPAGE)));
+	rb_destroy(&buf);
+
+	/* Growable buffers ignore all of these. */
+	props_pinned.mirrored = false;
+	props_pinned.growable = true;
+	buf = rb_create(&props_pinned);
+	ck_assert_uint_eq(rb_backing(buf), RB_BACKING_HEAP);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_mirrored_span)
+{
+	uint32_t * in;
+	uint32_t * out;
+	uint32_t * span;
+	size_t capacity;
+	size_t n;
+	ring_buffer buf;
+	struct ds_properties props_mirrored = props_batch;
+
+	props_mirrored.mirrored = true;
+	buf = rb_create(&props_mirrored);
+	capacity = DS_PRIV(buf)->capacity;
+	in = malloc(capacity * sizeof(*in));
+	out = malloc(capacity * sizeof(*out));
+
+	/* Move the head close to the end of the data region so that the
+	 * contents wrap around it. */
+	for(size_t i = 0; i < capacity; i++)
+		in[i] = i;
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, capacity - 2), capacity - 2);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, capacity - 2), capacity - 2);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, capacity), capacity);
+
+	span = rb_peek_span(buf, 0, &n);
+	ck_assert_ptr_ne(span, NULL);
+	if(rb_backing(buf) & RB_BACKING_MIRRORED)
+		ck_assert_uint_eq(n, capacity);
+	else
+		ck_assert_uint_eq(n, 2);
+	for(size_t i = 0; i < n; i++)
+		ck_assert_uint_eq(span[i], i);
+	rb_peek_release(buf);
+
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, capacity), capacity);
+	for(size_t i = 0; i < capacity; i++)
+		ck_assert_uint_eq(out[i], i);
+
+	free(in);
+	free(out);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_wait_timeout)
+{
+	uint32_t in = 7;
+	ring_buffer buf;
+	struct timespec timeout = { .tv_sec = 0, .tv_nsec = 10000000 };
+
+	buf = rb_create(&props_batch);
+
+	errno = 0;
+	ck_assert_ptr_eq(rb_pop_head_wait(buf, &timeout), NULL);
+	ck_assert_int_eq(errno, ETIMEDOUT);
+
+	for(size_t i = 0; i < DS_PRIV(buf)->capacity; i++)
+		ck_assert(rb_push_tail(buf, &in));
+
+	errno = 0;
+	ck_assert(!rb_push_tail_wait(buf, &in, &timeout));
+	ck_assert_int_eq(errno, ETIMEDOUT);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+#define WAIT_STREAM_LENGTH 1000
+
+static void * __wait_producer(void * arg)
+{
+	ring_buffer buf = arg;
+
+	for(uint32_t i = 0; i < WAIT_STREAM_LENGTH; i++)
+		rb_push_tail_wait(buf, &i, NULL);
+
+	return NULL;
+}
+
+static void __check_wait_stream(const struct ds_properties * props)
+{
+	pthread_t producer;
+	uint32_t out;
+	ring_buffer buf;
+
+	buf = rb_create(props);
+	pthread_create(&producer, NULL, __wait_producer, buf);
+
+	/* The buffer is much smaller than the stream, so both sides have to
+	 * sleep on each other repeatedly. */
+	for(uint32_t i = 0; i < WAIT_STREAM_LENGTH; i++) {
+		ck_assert(rb_pop_head_wait_into(buf, NULL, &out));
+		ck_assert_uint_eq(out, i);
+	}
+
+	pthread_join(producer, NULL);
+	ck_assert(rb_empty(buf));
+
+	rb_destroy(&buf);
+}
+
+START_TEST(test_rb_wait_stream)
+{
+	__check_wait_stream(&props_batch);
+	__check_wait_stream(&props_spsc);
+	__check_wait_stream(&props_mpmc);
+}
+END_TEST
+
+static void __check_reserve(const struct ds_properties * props)
+{
+	uint32_t in[6] = { 0, 1, 2, 3, 4, 5 };
+	uint32_t out[8];
+	uint32_t * slots;
+	size_t n;
+	ring_buffer buf;
+
+	buf = rb_create(props);
+
+	/* Leave the head two slots before the end of an 8 slot region. */
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 6), 6);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 6), 6);
+
+	/* The free run is cut short by the end of the data region. */
+	n = 5;
+	slots = rb_reserve_tail(buf, &n);
+	ck_assert_ptr_ne(slots, NULL);
+	ck_assert_uint_eq(n, 2);
+	slots[0] = 10;
+	slots[1] = 11;
+	ck_assert(rb_commit_tail(buf, 2));
+
+	n = 5;
+	slots = rb_reserve_tail(buf, &n);
+	ck_assert_uint_eq(n, 5);
+	for(size_t i = 0; i < n; i++)
+		slots[i] = 12 + i;
+	ck_assert(rb_commit_tail(buf, 3));
+	ck_assert_uint_eq(rb_size(buf), 5);
+
+	n = 8;
+	slots = rb_acquire_head(buf, &n);
+	ck_assert_ptr_ne(slots, NULL);
+	ck_assert_uint_eq(n, 2);
+	ck_assert_uint_eq(slots[0], 10);
+	ck_assert_uint_eq(slots[1], 11);
+	ck_assert(rb_release_head(buf, 1));
+
+	n = 8;
+	slots = rb_acquire_head(buf, &n);
+	ck_assert_uint_eq(n, 1);
+	ck_assert_uint_eq(slots[0], 11);
+	errno = 0;
+	ck_assert(!rb_release_head(buf, 2));
+	ck_assert_int_eq(errno, EINVAL);
+
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 8), 4);
+	for(size_t i = 0; i < 4; i++)
+		ck_assert_uint_eq(out[i], 11 + i);
+
+	n = 1;
+	errno = 0;
+	ck_assert_ptr_eq(rb_acquire_head(buf, &n), NULL);
+	ck_assert_int_eq(errno, EFAULT);
+
+	rb_destroy(&buf);
+}
+
+START_TEST(test_rb_reserve)
+{
+	struct ds_properties props_reserve = props_spsc;
+
+	props_reserve.entries = 8;
+	__check_reserve(&props_batch);
+	__check_reserve(&props_reserve);
+}
+END_TEST
+
+START_TEST(test_rb_reserve_full)
+{
+	uint32_t in = 1;
+	size_t n = 1;
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+	for(size_t i = 0; i < props_batch.entries; i++)
+		ck_assert(rb_push_tail(buf, &in));
+
+	errno = 0;
+	ck_assert_ptr_eq(rb_reserve_tail(buf, &n), NULL);
+	ck_assert_int_eq(errno, ENOBUFS);
+
+	rb_destroy(&buf);
+
+	buf = rb_create(&props_mpmc);
+	errno = 0;
+	ck_assert_ptr_eq(rb_reserve_tail(buf, &n), NULL);
+	ck_assert_int_eq(errno, ENOTSUP);
+	ck_assert_ptr_eq(rb_acquire_head(buf, &n), NULL);
+	ck_assert_int_eq(errno, ENOTSUP);
+	rb_destroy(&buf);
+}
+END_TEST
+
+#define OPTIMISTIC_WRITES 100000
+
+struct pair {
+	uint64_t a;
+	uint64_t b;
+};
+
+static void * __optimistic_writer(void * arg)
+{
+	ring_buffer buf = arg;
+	struct pair pair;
+
+	/* Keep the buffer nearly full while rewriting its contents, so that
+	 * readers constantly race with pops and pushes. */
+	for(uint64_t i = 0; i < OPTIMISTIC_WRITES; i++) {
+		rb_pop_head_into(buf, &pair);
+		pair.a = pair.b = i;
+		rb_push_tail(buf, &pair);
+	}
+
+	return NULL;
+}
+
+START_TEST(test_rb_optimistic_fetch)
+{
+	pthread_t writer;
+	struct pair pair = { 0, 0 };
+	ring_buffer buf;
+	struct ds_properties props_pair = {
+		.data_size = sizeof(struct pair),
+		.entries   = 16,
+	};
+
+	buf = rb_create(&props_pair);
+	for(size_t i = 0; i < props_pair.entries; i++)
+		rb_push_tail(buf, &pair);
+
+	pthread_create(&writer, NULL, __optimistic_writer, buf);
+
+	/* No read may observe a half-written block or an impossible size. */
+	for(size_t i = 0; i < OPTIMISTIC_WRITES; i++) {
+		size_t size = rb_size(buf);
+
+		ck_assert(size >= props_pair.entries - 1);
+		ck_assert(size <= props_pair.entries);
+		ck_assert(rb_fetch_into(buf, i, &pair));
+		ck_assert(pair.a == pair.b);
+	}
+
+	pthread_join(writer, NULL);
+	rb_destroy(&buf);
+}
+END_TEST
+
+static void __shared_name(char * name, size_t len)
+{
+	snprintf(name, len, "/focs-test-%d", (int) getpid());
+}
+
+START_TEST(test_rb_shared_attach)
+{
+	char name[64];
+	uint32_t in[4] = { 1, 2, 3, 4 };
+	uint32_t out[4];
+	ring_buffer producer;
+	ring_buffer consumer;
+
+	__shared_name(name, sizeof(name));
+	producer = rb_create_shared(name, &props_spsc);
+	ck_assert_ptr_ne(producer, NULL);
+	ck_assert_uint_eq(rb_backing(producer), RB_BACKING_SHARED);
+
+	/* A second buffer with the same name cannot be created. */
+	errno = 0;
+	ck_assert_ptr_eq(rb_create_shared(name, &props_spsc), NULL);
+	ck_assert_int_eq(errno, EEXIST);
+
+	/* Nor can it be attached to with different properties. */
+	errno = 0;
+	ck_assert_ptr_eq(rb_attach_shared(name, &props_mpmc), NULL);
+	ck_assert_int_eq(errno, EINVAL);
+
+	consumer = rb_attach_shared(name, &props_spsc);
+	ck_assert_ptr_ne(consumer, NULL);
+	ck_assert(rb_unlink_shared(name));
+
+	/* The two mappings are at different addresses but see the same data. */
+	ck_assert_ptr_ne(DS_PRIV(producer)->data, DS_PRIV(consumer)->data);
+	ck_assert_uint_eq(rb_push_tail_n(producer, in, 4), 4);
+	ck_assert_uint_eq(rb_size(consumer), 4);
+	ck_assert_uint_eq(rb_pop_head_n(consumer, out, 4), 4);
+	for(size_t i = 0; i < 4; i++)
+		ck_assert_uint_eq(out[i], in[i]);
+	ck_assert(rb_empty(producer));
+
+	rb_destroy(&producer);
+	rb_destroy(&consumer);
+}
+END_TEST
+
+START_TEST(test_rb_shared_fork)
+{
+	char name[64];
+	pid_t pid;
+	int status;
+	uint32_t out;
+	ring_buffer buf;
+
+	__shared_name(name, sizeof(name));
+	buf = rb_create_shared(name, &props_mpmc);
+	ck_assert_ptr_ne(buf, NULL);
+
+	pid = fork();
+	ck_assert_int_ge(pid, 0);
+	if(pid == 0) {
+		ring_buffer child = rb_attach_shared(name, &props_mpmc);
+
+		if(!child)
+			_exit(EXIT_FAILURE);
+
+		for(uint32_t i = 0; i < WAIT_STREAM_LENGTH; i++)
+			while(!rb_push_tail(child, &i))
+				sched_yield();
+
+		rb_destroy(&child);
+		_exit(EXIT_SUCCESS);
+	}
+
+	for(uint32_t i = 0; i < WAIT_STREAM_LENGTH; i++) {
+		while(!rb_pop_head_into(buf, &out))
+			sched_yield();
+		ck_assert_uint_eq(out, i);
+	}
+
+	waitpid(pid, &status, 0);
+	ck_assert(WIFEXITED(status));
+	ck_assert_int_eq(WEXITSTATUS(status), EXIT_SUCCESS);
+
+	rb_unlink_shared(name);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_shared_locked)
+{
+	char name[64];
+
+	__shared_name(name, sizeof(name));
+
+	errno = 0;
+	ck_assert_ptr_eq(rb_create_shared(name, &props_batch), NULL);
+	ck_assert_int_eq(errno, EINVAL);
+
+	errno = 0;
+	ck_assert_ptr_eq(rb_attach_shared(name, &props_spsc), NULL);
+	ck_assert_int_eq(errno, ENOENT);
+}
+END_TEST
+
+START_TEST(test_rb_grow)
+{
+	uint32_t in[20];
+	uint32_t out[20];
+	uint32_t val = 100;
+	ring_buffer buf;
+	struct ds_properties props_grow = props_batch;
+
+	props_grow.growable = true;
+	buf = rb_create(&props_grow);
+	for(uint32_t i = 0; i < 20; i++)
+		in[i] = i;
+
+	/* Wrap the contents before the buffer has to grow. */
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 5), 5);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 5), 5);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 8), 8);
+	ck_assert(rb_full(buf));
+
+	ck_assert(rb_push_tail(buf, &in[8]));
+	ck_assert_uint_eq(DS_PRIV(buf)->capacity, 16);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in + 9, 11), 11);
+	ck_assert_uint_eq(DS_PRIV(buf)->capacity, 32);
+	ck_assert(rb_push_head(buf, &val));
+	ck_assert(rb_insert(buf, &val, 10));
+	ck_assert(rb_pop_head_into(buf, out));
+	ck_assert_uint_eq(out[0], val);
+
+	/* The contents survived both reallocations in order. */
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 20), 20);
+	for(uint32_t i = 0; i < 20; i++) {
+		if(i < 9)
+			ck_assert_uint_eq(out[i], i);
+		else if(i == 9)
+			ck_assert_uint_eq(out[i], val);
+		else
+			ck_assert_uint_eq(out[i], i - 1);
+	}
+	ck_assert_uint_eq(rb_size(buf), 1);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_shrink_to_fit)
+{
+	uint32_t in[20] = { 0 };
+	uint32_t out[20];
+	ring_buffer buf;
+	struct ds_properties props_grow = props_batch;
+
+	props_grow.growable = true;
+	buf = rb_create(&props_grow);
+
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 20), 20);
+	ck_assert_uint_eq(DS_PRIV(buf)->capacity, 20);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 17), 17);
+
+	/* Shrinking stops at the capacity the buffer was created with. */
+	ck_assert(rb_shrink_to_fit(buf));
+	ck_assert_uint_eq(DS_PRIV(buf)->capacity, props_batch.entries);
+	ck_assert_uint_eq(rb_size(buf), 3);
+
+	rb_destroy(&buf);
+
+	buf = rb_create(&props_batch);
+	errno = 0;
+	ck_assert(!rb_shrink_to_fit(buf));
+	ck_assert_int_eq(errno, ENOTSUP);
+	rb_destroy(&buf);
+
+	props_grow.concurrency = DS_SPSC;
+	errno = 0;
+	ck_assert_ptr_eq(rb_create(&props_grow), NULL);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+#define GROW_ROUNDS 2000
+#define GROW_LIMIT  256
+
+static void * __grow_writer(void * arg)
+{
+	size_t n;
+	uint32_t * slot;
+	uint32_t out[GROW_LIMIT];
+	ring_buffer buf = arg;
+
+	/* Fill the buffer in place through several reallocations, then empty
+	 * it and shrink it back, over and over. */
+	for(size_t round = 0; round < GROW_ROUNDS; round++) {
+		for(uint32_t i = 0; i < GROW_LIMIT; i++) {
+			n = 1;
+			slot = rb_reserve_tail(buf, &n);
+			*slot = i;
+			rb_commit_tail(buf, 1);
+		}
+
+		rb_pop_head_n(buf, out, GROW_LIMIT);
+		rb_shrink_to_fit(buf);
+	}
+
+	return NULL;
+}
+
+START_TEST(test_rb_grow_concurrent)
+{
+	size_t size;
+	ring_buffer buf;
+	pthread_t writer;
+	struct rb_stats before, after;
+	struct ds_properties props_grow = props_batch;
+
+	/* An odd capacity moves the counters further on each growth. */
+	props_grow.entries = 5;
+	props_grow.growable = true;
+	buf = rb_create(&props_grow);
+	pthread_create(&writer, NULL, __grow_writer, buf);
+
+	/* Growing moves the head and tail, which the lock-free size queries
+	 * must never see half done: every size lies between the sizes implied
+	 * by the counters read just before and just after it. */
+	do {
+		rb_stats(buf, &before);
+		size = rb_size(buf);
+		rb_stats(buf, &after);
+
+		ck_assert(size + after.pops >= before.pushes);
+		ck_assert(size + before.pops <= after.pushes);
+	} while(after.pushes < GROW_ROUNDS * GROW_LIMIT);
+
+	pthread_join(writer, NULL);
+	ck_assert(rb_empty(buf));
+	rb_destroy(&buf);
+}
+END_TEST
+
+static void rb_fd_round_trip(const struct ds_properties * fd_props)
+{
+	int fds[2];
+	uint8_t in[10];
+	uint8_t out[10];
+	ring_buffer buf;
+
+	ck_assert_int_eq(pipe(fds), 0);
+	buf = rb_create(fd_props);
+	for(uint8_t i = 0; i < 10; i++)
+		in[i] = i;
+
+	/* Move the free space across the wrap before reading into it. */
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 6), 6);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 6), 6);
+
+	ck_assert_int_eq(write(fds[1], in, 10), 10);
+	ck_assert_int_eq(rb_read_fd(buf, fds[0], 20), 10);
+	ck_assert(rb_full(buf));
+	errno = 0;
+	ck_assert_int_eq(rb_read_fd(buf, fds[0], 1), -1);
+	ck_assert_int_eq(errno, ENOBUFS);
+
+	/* Write the used space back out, also across the wrap. */
+	ck_assert_int_eq(rb_write_fd(buf, fds[1], 7), 7);
+	ck_assert_int_eq(rb_write_fd(buf, fds[1], 7), 3);
+	ck_assert(rb_empty(buf));
+	errno = 0;
+	ck_assert_int_eq(rb_write_fd(buf, fds[1], 1), -1);
+	ck_assert_int_eq(errno, EFAULT);
+
+	ck_assert_int_eq(read(fds[0], out, 10), 10);
+	for(uint8_t i = 0; i < 10; i++)
+		ck_assert_uint_eq(out[i], i);
+
+	/* End of file pushes nothing. */
+	close(fds[1]);
+	ck_assert_int_eq(rb_read_fd(buf, fds[0], 10), 0);
+	ck_assert(rb_empty(buf));
+
+	close(fds[0]);
+	rb_destroy(&buf);
+}
+
+START_TEST(test_rb_fd)
+{
+	struct ds_properties props_fd = props;
+
+	rb_fd_round_trip(&props_fd);
+	props_fd.concurrency = DS_SPSC;
+	rb_fd_round_trip(&props_fd);
+}
+END_TEST
+
+START_TEST(test_rb_fd_unsupported)
+{
+	ring_buffer buf;
+	struct ds_properties props_fd = props;
+
+	buf = rb_create(&props_batch);
+	errno = 0;
+	ck_assert_int_eq(rb_read_fd(buf, STDIN_FILENO, 4), -1);
+	ck_assert_int_eq(errno, EINVAL);
+	rb_destroy(&buf);
+
+	props_fd.concurrency = DS_MPMC;
+	buf = rb_create(&props_fd);
+	errno = 0;
+	ck_assert_int_eq(rb_write_fd(buf, STDOUT_FILENO, 4), -1);
+	ck_assert_int_eq(errno, ENOTSUP);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_broadcast)
+{
+	uint32_t in[6] = { 0, 1, 2, 3, 4, 5 };
+	uint32_t out[6];
+	ring_buffer buf;
+	rb_reader fast;
+	rb_reader slow;
+	rb_reader late;
+
+	buf = rb_create(&props_broadcast);
+	fast = rb_reader_attach(buf);
+	slow = rb_reader_attach(buf);
+
+	/* Every reader sees every block. */
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 3), 3);
+	ck_assert_uint_eq(rb_reader_pop_n(fast, out, 6), 3);
+	for(uint32_t i = 0; i < 3; i++)
+		ck_assert_uint_eq(out[i], i);
+	ck_assert(rb_reader_pop_into(slow, out));
+	ck_assert_uint_eq(out[0], 0);
+
+	/* The producer is held up by the slowest reader. */
+	ck_assert_uint_eq(rb_push_tail_n(buf, in + 3, 3), 2);
+	ck_assert(rb_full(buf));
+	errno = 0;
+	ck_assert(!rb_push_tail(buf, &in[5]));
+	ck_assert_int_eq(errno, ENOBUFS);
+	ck_assert_uint_eq(rb_reader_size(fast), 2);
+	ck_assert_uint_eq(rb_reader_size(slow), 4);
+
+	/* A reader attached later only sees what is pushed from then on. */
+	late = rb_reader_attach(buf);
+	ck_assert_uint_eq(rb_reader_size(late), 0);
+	errno = 0;
+	ck_assert(!rb_reader_pop_into(late, out));
+	ck_assert_int_eq(errno, EFAULT);
+
+	/* Detaching the slow reader frees up its slots. */
+	rb_reader_detach(&slow);
+	ck_assert_ptr_eq(slow, NULL);
+	ck_assert_uint_eq(rb_size(buf), 2);
+	ck_assert(rb_push_tail(buf, &in[5]));
+	ck_assert_uint_eq(rb_reader_pop_n(fast, out, 6), 3);
+	ck_assert_uint_eq(out[0], 3);
+	ck_assert_uint_eq(out[2], 5);
+	ck_assert(rb_reader_pop_into(late, out));
+	ck_assert_uint_eq(out[0], 5);
+	ck_assert_uint_eq(rb_reader_lost(fast), 0);
+
+	rb_reader_detach(&fast);
+	rb_reader_detach(&late);
+
+	/* Without readers, pushed blocks are simply discarded. */
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 4), 4);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 4), 4);
+	ck_assert(rb_empty(buf));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_broadcast_overwrite)
+{
+	uint32_t in[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	uint32_t out[10];
+	ring_buffer buf;
+	rb_reader reader;
+	struct ds_properties props_ow = props_broadcast;
+
+	props_ow.overwrite = true;
+	buf = rb_create(&props_ow);
+	reader = rb_reader_attach(buf);
+
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 3), 3);
+	ck_assert(rb_reader_pop_into(reader, out));
+	ck_assert_uint_eq(out[0], 0);
+
+	/* The producer laps the reader, which skips to the oldest block. */
+	for(uint32_t i = 3; i < 10; i++)
+		ck_assert(rb_push_tail(buf, &in[i]));
+	ck_assert_uint_eq(rb_reader_size(reader), 4);
+	ck_assert_uint_eq(rb_reader_pop_n(reader, out, 10), 4);
+	for(uint32_t i = 0; i < 4; i++)
+		ck_assert_uint_eq(out[i], i + 6);
+	ck_assert_uint_eq(rb_reader_lost(reader), 5);
+
+	/* Only the newest blocks of an oversized batch survive. */
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 10), 10);
+	ck_assert_uint_eq(rb_reader_pop_n(reader, out, 10), 4);
+	ck_assert_uint_eq(out[0], 6);
+	ck_assert_uint_eq(rb_reader_lost(reader), 11);
+
+	rb_reader_detach(&reader);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_broadcast_unsupported)
+{
+	uint32_t val = 0;
+	ring_buffer buf;
+	struct ds_properties props_shared = props_broadcast;
+
+	buf = rb_create(&props_broadcast);
+	errno = 0;
+	ck_assert(!rb_pop_head_into(buf, &val));
+	ck_assert_int_eq(errno, ENOTSUP);
+	errno = 0;
+	ck_assert(!rb_push_head(buf, &val));
+	ck_assert_int_eq(errno, ENOTSUP);
+	errno = 0;
+	ck_assert(!rb_fetch_into(buf, 0, &val));
+	ck_assert_int_eq(errno, ENOTSUP);
+	rb_destroy(&buf);
+
+	buf = rb_create(&props_spsc);
+	errno = 0;
+	ck_assert_ptr_eq(rb_reader_attach(buf), NULL);
+	ck_assert_int_eq(errno, ENOTSUP);
+	rb_destroy(&buf);
+
+	errno = 0;
+	ck_assert_ptr_eq(rb_create_shared("/focs-test-broadcast",
+					  &props_shared), NULL);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+#define BROADCAST_READERS       3
+#define BROADCAST_STREAM_LENGTH 1000
+
+static void * __broadcast_reader(void * arg)
+{
+	rb_reader reader = arg;
+	uint32_t val;
+
+	for(uint32_t i = 0; i < BROADCAST_STREAM_LENGTH; i++) {
+		while(!rb_reader_pop_into(reader, &val))
+			sched_yield();
+
+		if(val != i)
+			return (void *) 1;
+	}
+
+	return NULL;
+}
+
+START_TEST(test_rb_broadcast_threads)
+{
+	ring_buffer buf;
+	void * result;
+	pthread_t threads[BROADCAST_READERS];
+	rb_reader readers[BROADCAST_READERS];
+
+	buf = rb_create(&props_broadcast);
+	for(int i = 0; i < BROADCAST_READERS; i++) {
+		readers[i] = rb_reader_attach(buf);
+		pthread_create(&threads[i], NULL, __broadcast_reader,
+			       readers[i]);
+	}
+
+	for(uint32_t i = 0; i < BROADCAST_STREAM_LENGTH; i++)
+		ck_assert(rb_push_tail_wait(buf, &i, NULL));
+
+	for(int i = 0; i < BROADCAST_READERS; i++) {
+		pthread_join(threads[i], &result);
+		ck_assert_ptr_eq(result, NULL);
+		rb_reader_detach(&readers[i]);
+	}
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+uint32_t * rb_double_inplace(uint32_t * data)
+{
+	*data *= 2;
+	return data;
+}
+
+uint32_t * rb_double_newptr(uint32_t * data)
+{
+	uint32_t * n;
+
+	n = malloc(sizeof(*data));
+	*n = *data * 2;
+
+	return n;
+}
+
+/* Both folds build a decimal number from the digits they visit in order. */
+uint32_t * rb_digits_left(uint32_t * acc, const uint32_t * c)
+{
+	*acc = *acc * 10 + *c;
+	return acc;
+}
+
+uint32_t * rb_digits_right(const uint32_t * c, uint32_t * acc)
+{
+	*acc = *acc * 10 + *c;
+	return acc;
+}
+
+bool rb_pred_even(const uint32_t * n)
+{
+	return (*n % 2 == 0);
+}
+
+bool rb_pred_lt10(const uint32_t * n)
+{
+	return (*n < 10);
+}
+
+/* Fill `buf` with 1..`n` so that the contents wrap around the end. */
+static void rb_fill_wrapped(ring_buffer buf, const uint32_t n)
+{
+	uint32_t in[8] = { 0 };
+
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 5), 5);
+	ck_assert_uint_eq(rb_pop_head_n(buf, in, 5), 5);
+	for(uint32_t i = 1; i <= n; i++)
+		ck_assert(rb_push_tail(buf, &i));
+}
+
+START_TEST(test_rb_map)
+{
+	uint32_t out[6];
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+	rb_fill_wrapped(buf, 6);
+
+	rb_map(buf, (map_fn) rb_double_inplace);
+	rb_map(buf, (map_fn) rb_double_newptr);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 6), 6);
+	for(uint32_t i = 0; i < 6; i++)
+		ck_assert_uint_eq(out[i], 4 * (i + 1));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_fold)
+{
+	uint32_t init = 0;
+	uint32_t * result;
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+
+	result = rb_foldl(buf, (foldl_fn) rb_digits_left, &init);
+	ck_assert_uint_eq(*result, 0);
+	free(result);
+
+	rb_fill_wrapped(buf, 6);
+	result = rb_foldl(buf, (foldl_fn) rb_digits_left, &init);
+	ck_assert_uint_eq(*result, 123456);
+	free(result);
+	result = rb_foldr(buf, (foldr_fn) rb_digits_right, &init);
+	ck_assert_uint_eq(*result, 654321);
+	free(result);
+	ck_assert_uint_eq(rb_size(buf), 6);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_any_all)
+{
+	uint32_t big = 12;
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+	ck_assert(!rb_any(buf, (pred_fn) rb_pred_even));
+	ck_assert(rb_all(buf, (pred_fn) rb_pred_even));
+
+	rb_fill_wrapped(buf, 6);
+	ck_assert(rb_any(buf, (pred_fn) rb_pred_even));
+	ck_assert(!rb_all(buf, (pred_fn) rb_pred_even));
+	ck_assert(rb_all(buf, (pred_fn) rb_pred_lt10));
+
+	/* The only failing block sits in the second run. */
+	ck_assert(rb_push_tail(buf, &big));
+	ck_assert(!rb_all(buf, (pred_fn) rb_pred_lt10));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_filter)
+{
+	uint32_t out[8];
+	ring_buffer buf;
+
+	buf = rb_create(&props_batch);
+	rb_fill_wrapped(buf, 8);
+
+	ck_assert(rb_filter(buf, (pred_fn) rb_pred_even));
+	ck_assert_uint_eq(rb_size(buf), 4);
+	ck_assert(!rb_filter(buf, (pred_fn) rb_pred_even));
+
+	/* The buffer keeps working across the compacted wrap. */
+	for(uint32_t i = 10; i < 14; i++)
+		ck_assert(rb_push_tail(buf, &i));
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 8), 8);
+	for(uint32_t i = 0; i < 4; i++) {
+		ck_assert_uint_eq(out[i], 2 * (i + 1));
+		ck_assert_uint_eq(out[i + 4], i + 10);
+	}
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_hof_unsupported)
+{
+	uint32_t init = 0;
+	ring_buffer buf;
+
+	buf = rb_create(&props_spsc);
+	errno = 0;
+	rb_map(buf, (map_fn) rb_double_inplace);
+	ck_assert_int_eq(errno, ENOTSUP);
+	errno = 0;
+	ck_assert_ptr_eq(rb_foldl(buf, (foldl_fn) rb_digits_left, &init),
+			 NULL);
+	ck_assert_int_eq(errno, ENOTSUP);
+	errno = 0;
+	ck_assert(!rb_filter(buf, (pred_fn) rb_pred_even));
+	ck_assert_int_eq(errno, ENOTSUP);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_stats)
+{
+	uint32_t in[12] = { 0 };
+	uint32_t out[12];
+	ring_buffer buf;
+	struct rb_stats stats;
+	struct ds_properties props_overwrite = props_batch;
+
+	/* Overwriting pushes are counted as both pushes and overwrites. */
+	props_overwrite.overwrite = true;
+	buf = rb_create(&props_overwrite);
+	for(int i = 0; i < 10; i++)
+		ck_assert(rb_push_tail(buf, &in[i]));
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 3), 3);
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 3), 3);
+	ck_assert(rb_pop_tail_into(buf, out));
+
+	rb_stats(buf, &stats);
+	ck_assert_uint_eq(stats.pushes, 13);
+	ck_assert_uint_eq(stats.overwrites, 5);
+	ck_assert_uint_eq(stats.pops, 4);
+	ck_assert_uint_eq(stats.failed, 0);
+	rb_destroy(&buf);
+
+	/* Without overwriting, blocks that do not fit are counted instead. */
+	buf = rb_create(&props_batch);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 10), 8);
+	ck_assert(!rb_push_head(buf, &in[0]));
+	rb_stats(buf, &stats);
+	ck_assert_uint_eq(stats.pushes, 8);
+	ck_assert_uint_eq(stats.overwrites, 0);
+	ck_assert_uint_eq(stats.failed, 3);
+	rb_destroy(&buf);
+
+	/* The lock-free modes count the same way. */
+	buf = rb_create(&props_spsc);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 12), 10);
+	ck_assert(!rb_push_tail(buf, &in[0]));
+	ck_assert_uint_eq(rb_pop_head_n(buf, out, 4), 4);
+	rb_stats(buf, &stats);
+	ck_assert_uint_eq(stats.pushes, 10);
+	ck_assert_uint_eq(stats.pops, 4);
+	ck_assert_uint_eq(stats.failed, 3);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_stats_reserve)
+{
+	size_t n;
+	uint32_t in[10] = {0};
+	ring_buffer buf;
+	struct rb_stats stats;
+
+	/* Reserving slots in a full buffer counts every requested block as
+	 * failed, like a push would. */
+	buf = rb_create(&props_batch);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 8), 8);
+	n = 3;
+	ck_assert_ptr_eq(rb_reserve_tail(buf, &n), NULL);
+	ck_assert_int_eq(errno, ENOBUFS);
+	rb_stats(buf, &stats);
+	ck_assert_uint_eq(stats.pushes, 8);
+	ck_assert_uint_eq(stats.failed, 3);
+	rb_destroy(&buf);
+
+	buf = rb_create(&props_spsc);
+	ck_assert_uint_eq(rb_push_tail_n(buf, in, 10), 10);
+	n = 2;
+	ck_assert_ptr_eq(rb_reserve_tail(buf, &n), NULL);
+	ck_assert_int_eq(errno, ENOBUFS);
+	rb_stats(buf, &stats);
+	ck_assert_uint_eq(stats.pushes, 10);
+	ck_assert_uint_eq(stats.failed, 2);
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_snapshot)
+{
+	uint32_t out[8];
+	ring_buffer buf;
+	struct ds_properties props_overwrite = props_batch;
+
+	props_overwrite.overwrite = true;
+	buf = rb_create(&props_overwrite);
+	ck_assert_uint_eq(rb_capacity(buf), 8);
+	ck_assert_uint_eq(rb_snapshot(buf, out), 0);
+
+	/* The contents wrap, and come out oldest first. */
+	for(uint32_t i = 0; i < 13; i++)
+		ck_assert(rb_push_tail(buf, &i));
+	ck_assert_uint_eq(rb_snapshot(buf, out), 8);
+	for(uint32_t i = 0; i < 8; i++)
+		ck_assert_uint_eq(out[i], i + 5);
+	ck_assert_uint_eq(rb_size(buf), 8);
+	rb_destroy(&buf);
+
+	buf = rb_create(&props_spsc);
+	for(uint32_t i = 0; i < 6; i++)
+		ck_assert(rb_push_tail(buf, &i));
+	ck_assert(rb_pop_head_into(buf, out));
+	ck_assert_uint_eq(rb_snapshot(buf, out), 5);
+	for(uint32_t i = 0; i < 5; i++)
+		ck_assert_uint_eq(out[i], i + 1);
+	rb_destroy(&buf);
+
+	buf = rb_create(&props_mpmc);
+	errno = 0;
+	ck_assert_uint_eq(rb_snapshot(buf, out), 0);
+	ck_assert_int_eq(errno, ENOTSUP);
+	rb_destroy(&buf);
+}
+END_TEST
+
+#define SNAPSHOT_PUSHES 20000
+
+static void * __snapshot_producer(void * arg)
+{
+	ring_buffer buf = arg;
+
+	for(uint32_t i = 0; i < SNAPSHOT_PUSHES; i++)
+		rb_push_tail(buf, &i);
+
+	return NULL;
+}
+
+START_TEST(test_rb_snapshot_concurrent)
+{
+	uint32_t out[8];
+	size_t count;
+	ring_buffer buf;
+	pthread_t producer;
+	struct rb_stats stats;
+	struct ds_properties props_overwrite = props_batch;
+
+	props_overwrite.overwrite = true;
+	buf = rb_create(&props_overwrite);
+	pthread_create(&producer, NULL, __snapshot_producer, buf);
+
+	/* Every snapshot is a run of consecutive values, however far the
+	 * producer got during the copy. */
+	do {
+		rb_stats(buf, &stats);
+		count = rb_snapshot(buf, out);
+		for(size_t i = 1; i < count; i++)
+			ck_assert_uint_eq(out[i], out[i - 1] + 1);
+	} while(stats.pushes < SNAPSHOT_PUSHES);
+
+	pthread_join(producer, NULL);
+	ck_assert_uint_eq(rb_snapshot(buf, out), 8);
+	ck_assert_uint_eq(out[7], SNAPSHOT_PUSHES - 1);
+	rb_stats(buf, &stats);
+	ck_assert_uint_eq(stats.overwrites, SNAPSHOT_PUSHES - 8);
+	rb_destroy(&buf);
+}
+END_TEST
+
 Suite * rb_suite(void)
 {
 	Suite * suite;
@@ -431,18 +2325,51 @@ Suite * rb_suite(void)
 	TCase * case_rb_pop_tail;
 	TCase * case_rb_insert;
 	TCase * case_rb_fetch;
+	TCase * case_rb_into;
+	TCase * case_rb_peek;
+	TCase * case_rb_batch;
+	TCase * case_rb_pow2;
+	TCase * case_rb_spsc;
+	TCase * case_rb_mpmc;
+	TCase * case_rb_mirrored;
+	TCase * case_rb_wait;
+	TCase * case_rb_reserve;
+	TCase * case_rb_optimistic;
+	TCase * case_rb_shared;
+	TCase * case_rb_grow;
+	TCase * case_rb_fd;
+	TCase * case_rb_broadcast;
+	TCase * case_rb_hof;
+	TCase * case_rb_stats;
 
 	suite = suite_create("Ring Buffer");
 
 	case_rb_create = tcase_create("rb_create");
 	case_rb_push_head = tcase_create("rb_push_head");
-	case_rb_push_head = tcase_create("rb_push_tail");
+	case_rb_push_tail = tcase_create("rb_push_tail");
 	case_rb_pop_head = tcase_create("rb_pop_head");
 	case_rb_pop_tail = tcase_create("rb_pop_tail");
 	case_rb_insert = tcase_create("rb_insert");
 	case_rb_fetch = tcase_create("rb_fetch");
+	case_rb_into = tcase_create("rb_into");
+	case_rb_peek = tcase_create("rb_peek");
+	case_rb_batch = tcase_create("rb_batch");
+	case_rb_pow2 = tcase_create("rb_pow2");
+	case_rb_spsc = tcase_create("rb_spsc");
+	case_rb_mpmc = tcase_create("rb_mpmc");
+	case_rb_mirrored = tcase_create("rb_mirrored");
+	case_rb_wait = tcase_create("rb_wait");
+	case_rb_reserve = tcase_create("rb_reserve");
+	case_rb_optimistic = tcase_create("rb_optimistic");
+	case_rb_shared = tcase_create("rb_shared");
+	case_rb_grow = tcase_create("rb_grow");
+	case_rb_fd = tcase_create("rb_fd");
+	case_rb_broadcast = tcase_create("rb_broadcast");
+	case_rb_hof = tcase_create("rb_hof");
+	case_rb_stats = tcase_create("rb_stats");
 
 	tcase_add_test(case_rb_create, test_rb_create);
+	tcase_add_test(case_rb_create, test_rb_create_layout);
 	tcase_add_test(case_rb_push_head, test_rb_push_head_single);
 	tcase_add_test(case_rb_push_head, test_rb_push_head_multiple);
 	tcase_add_test(case_rb_push_tail, test_rb_push_tail_single);
@@ -455,9 +2382,64 @@ Suite * rb_suite(void)
 	tcase_add_test(case_rb_pop_tail, test_rb_pop_tail_multiple);
 	tcase_add_test(case_rb_insert, test_rb_insert_single);
 	tcase_add_test(case_rb_insert, test_rb_insert_multiple);
+	tcase_add_test(case_rb_insert, test_rb_insert_shift);
+	tcase_add_test(case_rb_insert, test_rb_insert_wrap);
 	tcase_add_test(case_rb_fetch, test_rb_fetch_empty);
 	tcase_add_test(case_rb_fetch, test_rb_fetch_single);
 	tcase_add_test(case_rb_fetch, test_rb_fetch_multiple);
+	tcase_add_test(case_rb_into, test_rb_pop_head_into);
+	tcase_add_test(case_rb_into, test_rb_pop_tail_into);
+	tcase_add_test(case_rb_into, test_rb_fetch_into);
+	tcase_add_test(case_rb_peek, test_rb_peek);
+	tcase_add_test(case_rb_peek, test_rb_spsc_peek);
+	tcase_add_test(case_rb_batch, test_rb_push_tail_n);
+	tcase_add_test(case_rb_batch, test_rb_push_head_n);
+	tcase_add_test(case_rb_batch, test_rb_pop_tail_n);
+	tcase_add_test(case_rb_batch, test_rb_push_tail_n_overwrite);
+	tcase_add_test(case_rb_batch, test_rb_spsc_batch);
+	tcase_add_test(case_rb_pow2, test_rb_pow2_auto);
+	tcase_add_test(case_rb_pow2, test_rb_pow2_requested);
+	tcase_add_test(case_rb_pow2, test_rb_pow2_wrap);
+	tcase_add_test(case_rb_pow2, test_rb_push_head_overwrite);
+	tcase_add_test(case_rb_spsc, test_rb_spsc_create_overwrite);
+	tcase_add_test(case_rb_spsc, test_rb_spsc_fifo);
+	tcase_add_test(case_rb_spsc, test_rb_spsc_full);
+	tcase_add_test(case_rb_spsc, test_rb_spsc_unsupported);
+	tcase_add_test(case_rb_spsc, test_rb_spsc_layout);
+	tcase_add_test(case_rb_spsc, test_rb_spsc_threads);
+	tcase_add_test(case_rb_mpmc, test_rb_mpmc_fifo);
+	tcase_add_test(case_rb_mpmc, test_rb_mpmc_full);
+	tcase_add_test(case_rb_mpmc, test_rb_mpmc_unsupported);
+	tcase_add_test(case_rb_mpmc, test_rb_mpmc_threads);
+	tcase_add_test(case_rb_mirrored, test_rb_mirrored_create);
+	tcase_add_test(case_rb_mirrored, test_rb_mirrored_span);
+	tcase_add_test(case_rb_mirrored, test_rb_backing_pinned);
+	tcase_add_test(case_rb_wait, test_rb_wait_timeout);
+	tcase_add_test(case_rb_wait, test_rb_wait_stream);
+	tcase_add_test(case_rb_reserve, test_rb_reserve);
+	tcase_add_test(case_rb_reserve, test_rb_reserve_full);
+	tcase_add_test(case_rb_optimistic, test_rb_optimistic_fetch);
+	tcase_add_test(case_rb_shared, test_rb_shared_attach);
+	tcase_add_test(case_rb_shared, test_rb_shared_fork);
+	tcase_add_test(case_rb_shared, test_rb_shared_locked);
+	tcase_add_test(case_rb_grow, test_rb_grow);
+	tcase_add_test(case_rb_grow, test_rb_shrink_to_fit);
+	tcase_add_test(case_rb_grow, test_rb_grow_concurrent);
+	tcase_add_test(case_rb_fd, test_rb_fd);
+	tcase_add_test(case_rb_fd, test_rb_fd_unsupported);
+	tcase_add_test(case_rb_broadcast, test_rb_broadcast);
+	tcase_add_test(case_rb_broadcast, test_rb_broadcast_overwrite);
+	tcase_add_test(case_rb_broadcast, test_rb_broadcast_unsupported);
+	tcase_add_test(case_rb_broadcast, test_rb_broadcast_threads);
+	tcase_add_test(case_rb_hof, test_rb_map);
+	tcase_add_test(case_rb_hof, test_rb_fold);
+	tcase_add_test(case_rb_hof, test_rb_any_all);
+	tcase_add_test(case_rb_hof, test_rb_filter);
+	tcase_add_test(case_rb_hof, test_rb_hof_unsupported);
+	tcase_add_test(case_rb_stats, test_rb_stats);
+	tcase_add_test(case_rb_stats, test_rb_stats_reserve);
+	tcase_add_test(case_rb_stats, test_rb_snapshot);
+	tcase_add_test(case_rb_stats, test_rb_snapshot_concurrent);
 
 	suite_add_tcase(suite, case_rb_create);
 	suite_add_tcase(suite, case_rb_push_head);
@@ -466,6 +2448,22 @@ Suite * rb_suite(void)
 	suite_add_tcase(suite, case_rb_pop_tail);
 	suite_add_tcase(suite, case_rb_insert);
 	suite_add_tcase(suite, case_rb_fetch);
+	suite_add_tcase(suite, case_rb_into);
+	suite_add_tcase(suite, case_rb_peek);
+	suite_add_tcase(suite, case_rb_batch);
+	suite_add_tcase(suite, case_rb_pow2);
+	suite_add_tcase(suite, case_rb_spsc);
+	suite_add_tcase(suite, case_rb_mpmc);
+	suite_add_tcase(suite, case_rb_mirrored);
+	suite_add_tcase(suite, case_rb_wait);
+	suite_add_tcase(suite, case_rb_reserve);
+	suite_add_tcase(suite, case_rb_optimistic);
+	suite_add_tcase(suite, case_rb_shared);
+	suite_add_tcase(suite, case_rb_grow);
+	suite_add_tcase(suite, case_rb_fd);
+	suite_add_tcase(suite, case_rb_broadcast);
+	suite_add_tcase(suite, case_rb_hof);
+	suite_add_tcase(suite, case_rb_stats);
 
 	return suite;
 }
@@ -471,6 +471,43 @@ START_TEST(test_sl_delete_multiple)
 }
 END_TEST
 
+START_TEST(test_sl_delete_recycle)
+{
+	uint8_t in1 = 1;
+	uint8_t in2 = 2;
+	uint8_t * out;
+	struct sl_element * first;
+	single_list list;
+
+	list = sl_create(&props);
+
+	/* A deleted element is reused by the next insertion. */
+	sl_push_tail(list, &in1);
+	first = DS_PRIV(list)->head;
+	ck_assert(sl_delete(list, 0));
+	sl_push_tail(list, &in2);
+	ck_assert_ptr_eq(DS_PRIV(list)->head, first);
+	ck_assert_int_eq(*(uint8_t *) DS_PRIV(list)->head->data, in2);
+
+	/* Span several slabs, then drain the list. */
+	for(size_t i = 0; i < 1000; i++)
+		sl_push_tail(list, &in1);
+	ck_assert_int_eq(DS_PRIV(list)->length, 1001);
+
+	out = sl_pop_head(list);
+	ck_assert_int_eq(*out, in2);
+	free(out);
+	for(size_t i = 0; i < 1000; i++) {
+		out = sl_pop_head(list);
+		ck_assert_int_eq(*out, in1);
+		free(out);
+	}
+	ck_assert(sl_null(list));
+
+	sl_free(&list);
+}
+END_TEST
+
 START_TEST(test_sl_remove_empty)
 {
 	void * val1;
@@ -1545,6 +1582,259 @@ START_TEST(test_sl_foldl_multiple)
 }
 END_TEST
 
+/* Orders values by their high nibble alone, so that equal keys can be told
+ * apart to check stability. */
+bool comp_high_nibble(const uint8_t * a, const uint8_t * b)
+{
+	return (*a >> 4) < (*b >> 4);
+}
+
+/* Check a list's contents, links and tail against a flat array. */
+static void check_contents(single_list list, const uint8_t * model, size_t n)
+{
+	size_t i = 0;
+	struct sl_element * current;
+
+	ck_assert_int_eq(DS_PRIV(list)->length, n);
+
+	linked_list_foreach(list, current) {
+		ck_assert_int_eq(*(uint8_t *) current->data, model[i]);
+		if(!current->next)
+			ck_assert_ptr_eq(DS_PRIV(list)->tail, current);
+		i++;
+	}
+	ck_assert_int_eq(i, n);
+}
+
+START_TEST(test_sl_sort_empty)
+{
+	single_list list;
+
+	list = sl_create(&props);
+	sl_sort(list, (comp_fn) comp_high_nibble);
+
+	ck_assert(!DS_PRIV(list)->head);
+	ck_assert(!DS_PRIV(list)->tail);
+	ck_assert(sl_null(list));
+
+	sl_free(&list);
+}
+END_TEST
+
+START_TEST(test_sl_sort_multiple)
+{
+	size_t i;
+	uint8_t val;
+	uint8_t model[200];
+	single_list list;
+
+	list = sl_create(&props);
+
+	for(size_t n = 0; n < 200; n++) {
+		/* Sort after each push so that every length is covered, and
+		 * keep the model sorted with a stable insertion sort. */
+		val = (n * 73 + 11) % 256;
+		sl_push_tail(list, &val);
+
+		for(i = n; i > 0 && comp_high_nibble(&val, &model[i - 1]); i--)
+			model[i] = model[i - 1];
+		model[i] = val;
+
+		sl_sort(list, (comp_fn) comp_high_nibble);
+		check_contents(list, model, n + 1);
+	}
+
+	sl_free(&list);
+}
+END_TEST
+
+START_TEST(test_sl_merge_multiple)
+{
+	uint8_t val;
+	uint8_t model[120];
+	size_t n = 0;
+	uint8_t * out;
+	single_list dst, src;
+
+	dst = sl_create(&props);
+	src = sl_create(&props);
+
+	/* Equal keys from @dst must come first: [0x00, 0x01, 0x10, ...] */
+	for(size_t i = 0; i < 60; i++) {
+		val = (i * 16) % 256 + (i >= 16);
+		sl_push_tail(dst, &val);
+		val = (i * 16) % 256 + 2 + (i >= 16);
+		sl_push_tail(src, &val);
+	}
+	sl_sort(dst, (comp_fn) comp_high_nibble);
+	sl_sort(src, (comp_fn) comp_high_nibble);
+
+	for(size_t k = 0; k < 16; k++) {
+		for(size_t i = 0; i < 60; i++) {
+			out = sl_fetch(dst, i);
+			if((*out >> 4) == k)
+				model[n++] = *out;
+		}
+		for(size_t i = 0; i < 60; i++) {
+			out = sl_fetch(src, i);
+			if((*out >> 4) == k)
+				model[n++] = *out;
+		}
+	}
+
+	ck_assert(sl_merge(dst, src, (comp_fn) comp_high_nibble));
+	check_contents(dst, model, 120);
+	ck_assert(sl_null(src));
+	ck_assert(!DS_PRIV(src)->tail);
+
+	/* Both lists remain usable, and elements merged in from @src are
+	 * released by @dst. */
+	val = 7;
+	sl_push_tail(src, &val);
+	ck_assert_int_eq(*(uint8_t *) sl_fetch(src, 0), 7);
+
+	while((out = sl_pop_head(dst)))
+		free(out);
+	for(size_t i = 0; i < 240; i++)
+		sl_push_head(dst, &val);
+	ck_assert_int_eq(DS_PRIV(dst)->length, 240);
+
+	sl_free(&dst);
+	sl_free(&src);
+}
+END_TEST
+
+START_TEST(test_sl_merge_invalid)
+{
+	single_list list;
+
+	list = sl_create(&props);
+
+	errno = 0;
+	ck_assert(!sl_merge(list, list, (comp_fn) comp_high_nibble));
+	ck_assert_int_eq(errno, EINVAL);
+
+	sl_free(&list);
+}
+END_TEST
+
+START_TEST(test_sl_splice)
+{
+	uint8_t val;
+	uint8_t model[80];
+	size_t n = 0;
+	single_list dst, src;
+
+	dst = sl_create(&props);
+	src = sl_create(&props);
+
+	/* Splice runs of [100, 101, ...] into the head, the tail and the
+	 * middle of the list, checking the result against a flat array. */
+	for(size_t pos = 0; n + 8 <= 80; pos = (pos + 7) % (n + 1)) {
+		for(val = 100; val < 108; val++)
+			sl_push_tail(src, &val);
+
+		ck_assert(sl_splice(dst, pos, src));
+		ck_assert(sl_null(src));
+		ck_assert(!DS_PRIV(src)->tail);
+
+		memmove(model + pos + 8, model + pos, n - pos);
+		for(size_t i = 0; i < 8; i++)
+			model[pos + i] = 100 + i;
+		n += 8;
+
+		check_contents(dst, model, n);
+	}
+
+	/* Splicing an empty list changes nothing. */
+	ck_assert(sl_splice(dst, 3, src));
+	check_contents(dst, model, n);
+
+	errno = 0;
+	ck_assert(!sl_splice(dst, n + 1, src));
+	ck_assert_int_eq(errno, EINVAL);
+	errno = 0;
+	ck_assert(!sl_splice(dst, 0, dst));
+	ck_assert_int_eq(errno, EINVAL);
+
+	sl_free(&dst);
+	sl_free(&src);
+}
+END_TEST
+
+START_TEST(test_sl_concat)
+{
+	uint8_t in[4] = {1, 2, 3, 4};
+	uint8_t * out;
+	single_list dst, src;
+
+	dst = sl_create(&props);
+	src = sl_create(&props);
+
+	/* [] ++ [1, 2] -> [1, 2]; [1, 2] ++ [3, 4] -> [1, 2, 3, 4] */
+	sl_push_tail(src, &in[0]);
+	sl_push_tail(src, &in[1]);
+	ck_assert(sl_concat(dst, src));
+	sl_push_tail(src, &in[2]);
+	sl_push_tail(src, &in[3]);
+	ck_assert(sl_concat(dst, src));
+
+	check_contents(dst, in, 4);
+	ck_assert(sl_null(src));
+
+	/* Elements moved from @src are released by @dst. */
+	sl_free(&src);
+	for(size_t i = 0; i < 4; i++) {
+		out = sl_pop_tail(dst);
+		ck_assert_int_eq(*out, in[3 - i]);
+		free(out);
+	}
+
+	sl_free(&dst);
+}
+END_TEST
+
+START_TEST(test_sl_split_at)
+{
+	uint8_t val;
+	uint8_t model[20];
+	single_list list, rest;
+
+	list = sl_create(&props);
+	for(val = 0; val < 20; val++) {
+		model[val] = val;
+		sl_push_tail(list, &val);
+	}
+
+	/* Split at every position, then join the halves back together. */
+	for(size_t pos = 0; pos <= 20; pos++) {
+		uint8_t * moved = pos < 20 ? sl_fetch(list, pos) : NULL;
+
+		rest = sl_split_at(list, pos);
+		ck_assert(rest);
+		if(moved)
+			ck_assert_ptr_eq(sl_fetch(rest, 0), moved);
+
+		check_contents(list, model, pos);
+		check_contents(rest, model + pos, 20 - pos);
+
+		val = 20;
+		sl_push_tail(rest, &val);
+		free(sl_pop_tail(rest));
+
+		ck_assert(sl_concat(list, rest));
+		check_contents(list, model, 20);
+		sl_free(&rest);
+	}
+
+	errno = 0;
+	ck_assert(!sl_split_at(list, 21));
+	ck_assert_int_eq(errno, EINVAL);
+
+	sl_free(&list);
+}
+END_TEST
+
 Suite * sl_suite(void)
 {
 	Suite * suite;
@@ -1566,6 +1856,9 @@ Suite * sl_suite(void)
 	TCase * case_sl_take_while;
 	TCase * case_sl_map;
 	TCase * case_sl_reverse;
+	TCase * case_sl_sort;
+	TCase * case_sl_merge;
+	TCase * case_sl_splice;
 	TCase * case_sl_foldl;
 	TCase * case_sl_foldr;
 
@@ -1589,6 +1882,9 @@ Suite * sl_suite(void)
 	case_sl_take_while = tcase_create("sl_take_while");
 	case_sl_map = tcase_create("sl_map");
 	case_sl_reverse = tcase_create("sl_reverse");
+	case_sl_sort = tcase_create("sl_sort");
+	case_sl_merge = tcase_create("sl_merge");
+	case_sl_splice = tcase_create("sl_splice");
 	case_sl_foldl = tcase_create("sl_foldl");
 	case_sl_foldr = tcase_create("sl_foldr");
 
@@ -1610,6 +1906,7 @@ Suite * sl_suite(void)
 	tcase_add_test(case_sl_delete, test_sl_delete_empty);
 	tcase_add_test(case_sl_delete, test_sl_delete_single);
 	tcase_add_test(case_sl_delete, test_sl_delete_multiple);
+	tcase_add_test(case_sl_delete, test_sl_delete_recycle);
 	tcase_add_test(case_sl_remove, test_sl_remove_empty);
 	tcase_add_test(case_sl_remove, test_sl_remove_single);
 	tcase_add_test(case_sl_remove, test_sl_remove_multiple);
@@ -1640,6 +1937,13 @@ Suite * sl_suite(void)
 	tcase_add_test(case_sl_reverse, test_sl_reverse_empty);
 	tcase_add_test(case_sl_reverse, test_sl_reverse_single);
 	tcase_add_test(case_sl_reverse, test_sl_reverse_multiple);
+	tcase_add_test(case_sl_sort, test_sl_sort_empty);
+	tcase_add_test(case_sl_sort, test_sl_sort_multiple);
+	tcase_add_test(case_sl_merge, test_sl_merge_multiple);
+	tcase_add_test(case_sl_merge, test_sl_merge_invalid);
+	tcase_add_test(case_sl_splice, test_sl_splice);
+	tcase_add_test(case_sl_splice, test_sl_concat);
+	tcase_add_test(case_sl_splice, test_sl_split_at);
 	tcase_add_test(case_sl_foldr, test_sl_foldr_empty);
 	tcase_add_test(case_sl_foldr, test_sl_foldr_single);
 	tcase_add_test(case_sl_foldr, test_sl_foldr_multiple);
@@ -1665,6 +1969,9 @@ Suite * sl_suite(void)
 	suite_add_tcase(suite, case_sl_take_while);
 	suite_add_tcase(suite, case_sl_map);
 	suite_add_tcase(suite, case_sl_reverse);
+	suite_add_tcase(suite, case_sl_sort);
+	suite_add_tcase(suite, case_sl_merge);
+	suite_add_tcase(suite, case_sl_splice);
 	suite_add_tcase(suite, case_sl_foldr);
 	suite_add_tcase(suite, case_sl_foldl);
 
@@ -0,0 +1,459 @@
+/* unrolled_list.c - Unit Tests for Unrolled Linked List
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <check.h>
+
+#include "list/unrolled_list.h"
+
+static const struct ds_properties props = {
+	.data_size = sizeof(int),
+};
+
+/* Check that @list holds exactly the @n values in @expected, and that its
+ * nodes are consistent with its length. */
+static void check_contents(unrolled_list list, const int * expected, size_t n)
+{
+	size_t total = 0;
+	struct ul_node * node;
+	struct ul_node * prev = NULL;
+
+	ck_assert_int_eq(ul_length(list), n);
+
+	linked_list_foreach(list, node) {
+		ck_assert_ptr_eq(node->prev, prev);
+		ck_assert(node->count > 0);
+		ck_assert(node->count <= DS_PRIV(list)->capacity);
+		total += node->count;
+		prev = node;
+	}
+	ck_assert_ptr_eq(DS_PRIV(list)->tail, prev);
+	ck_assert_int_eq(total, n);
+
+	for(size_t i = 0; i < n; i++)
+		ck_assert_int_eq(*(int *) ul_fetch(list, i), expected[i]);
+}
+
+static bool is_even(const void * data)
+{
+	return *(const int *) data % 2 == 0;
+}
+
+static bool is_small(const void * data)
+{
+	return *(const int *) data < 100;
+}
+
+static bool is_negative(const void * data)
+{
+	return *(const int *) data < 0;
+}
+
+static void * double_it(void * data)
+{
+	*(int *) data *= 2;
+	return data;
+}
+
+static void * sum(void * acc, const void * c)
+{
+	*(int *) acc += *(const int *) c;
+	return acc;
+}
+
+static void * sum_r(const void * c, void * acc)
+{
+	return sum(acc, c);
+}
+
+START_TEST(test_ul_alloc)
+{
+	unrolled_list list;
+	struct ds_properties bad = {.data_size = 0};
+
+	list = ul_create(&props);
+	ck_assert(list);
+	ck_assert(ul_null(list));
+	ck_assert(DS_PRIV(list)->capacity >= UL_MIN_CAPACITY);
+
+	ul_free(&list);
+	ck_assert(!list);
+
+	ck_assert(!ul_create(&bad));
+}
+END_TEST
+
+START_TEST(test_ul_push_pop)
+{
+	int val;
+	int * out;
+	int expected[300];
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	/* [-150 .. -1, 0 .. 149] spans several nodes from both ends. */
+	for(int i = 0; i < 150; i++) {
+		val = -1 - i;
+		ul_push_head(list, &val);
+		val = i;
+		ul_push_tail(list, &val);
+	}
+	for(int i = 0; i < 300; i++)
+		expected[i] = i - 150;
+	check_contents(list, expected, 300);
+
+	out = ul_pop_head(list);
+	ck_assert_int_eq(*out, -150);
+	free(out);
+	out = ul_pop_tail(list);
+	ck_assert_int_eq(*out, 149);
+	free(out);
+	check_contents(list, expected + 1, 298);
+
+	for(int i = 0; i < 298; i++)
+		free(ul_pop_tail(list));
+	ck_assert(ul_null(list));
+	ck_assert(!DS_PRIV(list)->head);
+	ck_assert(!DS_PRIV(list)->tail);
+	ck_assert(!ul_pop_head(list));
+	ck_assert(!ul_pop_tail(list));
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_insert_split)
+{
+	int val;
+	int expected[201];
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	for(int i = 0; i < 200; i++) {
+		val = (i < 100) ? i : i + 1;
+		ul_push_tail(list, &val);
+	}
+
+	/* Inserting into a full node splits it. */
+	val = 100;
+	ck_assert(ul_insert(list, &val, 100));
+	for(int i = 0; i < 201; i++)
+		expected[i] = i;
+	check_contents(list, expected, 201);
+
+	/* Head, tail and out of range. */
+	val = -1;
+	ck_assert(ul_insert(list, &val, 0));
+	val = 201;
+	ck_assert(ul_insert(list, &val, 202));
+	ck_assert(!ul_insert(list, &val, 204));
+	ck_assert_int_eq(*(int *) ul_fetch(list, 0), -1);
+	ck_assert_int_eq(*(int *) ul_fetch(list, 202), 201);
+	ck_assert(!ul_fetch(list, 203));
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_delete_merge)
+{
+	int val;
+	int * out;
+	size_t nodes = 0;
+	struct ul_node * node;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	for(int i = 0; i < 400; i++) {
+		val = i;
+		ul_push_tail(list, &val);
+	}
+
+	/* Thin out the list; nodes merge as they empty. */
+	for(int i = 0; i < 300; i++)
+		ck_assert(ul_delete(list, 50));
+	ck_assert(!ul_delete(list, 100));
+
+	out = ul_remove(list, 50);
+	ck_assert_int_eq(*out, 350);
+	free(out);
+	ck_assert(!ul_remove(list, 99));
+
+	linked_list_foreach(list, node)
+		nodes++;
+	ck_assert(nodes <= 99 / (DS_PRIV(list)->capacity / 2) + 2);
+
+	ck_assert_int_eq(*(int *) ul_fetch(list, 49), 49);
+	ck_assert_int_eq(*(int *) ul_fetch(list, 50), 351);
+	ck_assert_int_eq(ul_length(list), 99);
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_random)
+{
+	int val;
+	int * out;
+	size_t pos;
+	size_t n = 0;
+	int model[2000];
+	unrolled_list list;
+
+	list = ul_create(&props);
+	srand(42);
+
+	/* Compare the list against a flat array under random edits. */
+	for(int step = 0; step < 4000; step++) {
+		pos = n ? (size_t) rand() % (n + 1) : 0;
+		if(n < 2000 && (rand() % 3 || n == 0)) {
+			val = step;
+			ck_assert(ul_insert(list, &val, pos));
+			memmove(model + pos + 1, model + pos,
+				(n - pos) * sizeof(*model));
+			model[pos] = val;
+			n++;
+		} else {
+			pos %= n;
+			out = ul_remove(list, pos);
+			ck_assert_int_eq(*out, model[pos]);
+			free(out);
+			memmove(model + pos, model + pos + 1,
+				(n - pos - 1) * sizeof(*model));
+			n--;
+		}
+	}
+
+	check_contents(list, model, n);
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_contains)
+{
+	int val;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	val = 7;
+	ck_assert(!ul_contains(list, &val));
+
+	for(int i = 0; i < 200; i++)
+		ul_push_tail(list, &i);
+
+	val = 199;
+	ck_assert(ul_contains(list, &val));
+	val = 200;
+	ck_assert(!ul_contains(list, &val));
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_any_all)
+{
+	int val;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	ck_assert(!ul_any(list, is_even));
+	ck_assert(!ul_all(list, is_even));
+
+	for(int i = 0; i < 100; i++) {
+		val = 2 * i;
+		ul_push_tail(list, &val);
+	}
+	ck_assert(ul_any(list, is_even));
+	ck_assert(ul_all(list, is_even));
+
+	val = 1;
+	ul_push_tail(list, &val);
+	ck_assert(ul_any(list, is_even));
+	ck_assert(!ul_all(list, is_even));
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_filter)
+{
+	int expected[100];
+	unrolled_list list;
+
+	list = ul_create(&props);
+	ck_assert(!ul_filter(list, is_even));
+
+	for(int i = 0; i < 200; i++)
+		ul_push_tail(list, &i);
+
+	ck_assert(ul_filter(list, is_even));
+	for(int i = 0; i < 100; i++)
+		expected[i] = 2 * i;
+	check_contents(list, expected, 100);
+
+	ck_assert(!ul_filter(list, is_even));
+	ck_assert(ul_filter(list, is_small));
+	check_contents(list, expected, 50);
+
+	ck_assert(ul_filter(list, is_negative));
+	ck_assert(ul_null(list));
+	ck_assert(!DS_PRIV(list)->head);
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_drop_take_while)
+{
+	int expected[200];
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	for(int i = 0; i < 200; i++) {
+		ul_push_tail(list, &i);
+		expected[i] = i;
+	}
+
+	/* [0 .. 199] -> [100 .. 199] */
+	ck_assert(ul_drop_while(list, is_small));
+	check_contents(list, expected + 100, 100);
+	ck_assert(!ul_drop_while(list, is_small));
+
+	/* [100 .. 199] -> [] */
+	ck_assert(ul_take_while(list, is_small));
+	ck_assert(ul_null(list));
+
+	for(int i = 0; i < 200; i++)
+		ul_push_tail(list, &i);
+
+	/* [0 .. 199] -> [0 .. 99] */
+	ck_assert(ul_take_while(list, is_small));
+	check_contents(list, expected, 100);
+	ck_assert(!ul_take_while(list, is_small));
+
+	/* [0 .. 99] -> [] */
+	ck_assert(ul_drop_while(list, is_small));
+	ck_assert(ul_null(list));
+	ck_assert(!DS_PRIV(list)->tail);
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_map_reverse)
+{
+	int expected[150];
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	for(int i = 0; i < 150; i++) {
+		ul_push_tail(list, &i);
+		expected[i] = 2 * (149 - i);
+	}
+
+	ul_map(list, double_it);
+	ul_reverse(list);
+	check_contents(list, expected, 150);
+
+	ul_free(&list);
+}
+END_TEST
+
+START_TEST(test_ul_fold)
+{
+	int init = 5;
+	int * out;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	out = ul_foldl(list, sum, &init);
+	ck_assert_int_eq(*out, 5);
+	free(out);
+
+	for(int i = 1; i <= 100; i++)
+		ul_push_tail(list, &i);
+
+	out = ul_foldl(list, sum, &init);
+	ck_assert_int_eq(*out, 5055);
+	free(out);
+
+	out = ul_foldr(list, sum_r, &init);
+	ck_assert_int_eq(*out, 5055);
+	free(out);
+
+	ul_free(&list);
+}
+END_TEST
+
+Suite * ul_suite(void)
+{
+	Suite * suite;
+	TCase * case_ul_alloc;
+	TCase * case_ul_edit;
+	TCase * case_ul_properties;
+	TCase * case_ul_hof;
+
+	suite = suite_create("Unrolled List");
+
+	case_ul_alloc = tcase_create("ul_alloc");
+	case_ul_edit = tcase_create("ul_edit");
+	case_ul_properties = tcase_create("ul_properties");
+	case_ul_hof = tcase_create("ul_hof");
+
+	tcase_add_test(case_ul_alloc, test_ul_alloc);
+	tcase_add_test(case_ul_edit, test_ul_push_pop);
+	tcase_add_test(case_ul_edit, test_ul_insert_split);
+	tcase_add_test(case_ul_edit, test_ul_delete_merge);
+	tcase_add_test(case_ul_edit, test_ul_random);
+	tcase_add_test(case_ul_properties, test_ul_contains);
+	tcase_add_test(case_ul_properties, test_ul_any_all);
+	tcase_add_test(case_ul_hof, test_ul_filter);
+	tcase_add_test(case_ul_hof, test_ul_drop_take_while);
+	tcase_add_test(case_ul_hof, test_ul_map_reverse);
+	tcase_add_test(case_ul_hof, test_ul_fold);
+
+	suite_add_tcase(suite, case_ul_alloc);
+	suite_add_tcase(suite, case_ul_edit);
+	suite_add_tcase(suite, case_ul_properties);
+	suite_add_tcase(suite, case_ul_hof);
+
+	return suite;
+}
+
+int main(void)
+{
+	Suite * suite_ul;
+	SRunner * suite_runner;
+
+	suite_ul = ul_suite();
+
+	suite_runner = srunner_create(suite_ul);
+	srunner_run_all(suite_runner, CK_NORMAL);
+	srunner_free(suite_runner);
+
+	return 0;
+}